@@ -0,0 +1,84 @@
+# Kingdoms of Amalur: Re-Reckoning PAK Dumper
+# (c) 2020 atom0s [atom0s@live.com]
+#
+# Profile-guided optimization workflow. (Run by the depak_pgo target, or directly with cmake -P.)
+#
+#   1. Builds a baseline into WORK_DIR/base.
+#   2. Builds an instrumented copy into WORK_DIR/pgo and trains it by extracting TRAIN, or a generated PAK file.
+#   3. Rebuilds WORK_DIR/pgo in place with the recorded profile. (GCC matches profiles by object path.)
+#   4. Runs depak_e2e_bench from both builds on the same corpus and reports the speedup of the optimized build.
+#
+# Variables: SOURCE_DIR, WORK_DIR, CXX_COMPILER, MARCH, TRAIN, BENCH_ARGS.
+cmake_minimum_required(VERSION 3.16)
+
+if(NOT SOURCE_DIR OR NOT WORK_DIR)
+    message(FATAL_ERROR "SOURCE_DIR and WORK_DIR must be given.")
+endif()
+if(NOT BENCH_ARGS)
+    set(BENCH_ARGS "--corpus tiny,mixed --threads 1 --repeat 3")
+endif()
+separate_arguments(BENCH_ARGS UNIX_COMMAND "${BENCH_ARGS}")
+
+set(PROFILE_DIR "${WORK_DIR}/profile")
+set(TRAIN_DIR "${WORK_DIR}/train")
+
+# Runs a command and stops the workflow when it fails..
+function(pgo_run)
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        list(JOIN ARGN " " cmd)
+        message(FATAL_ERROR "Command failed (${result}): ${cmd}")
+    endif()
+endfunction()
+
+# Configures and builds a tree with the given PGO stage..
+function(pgo_build dir stage)
+    set(args -S ${SOURCE_DIR} -B ${dir} -DCMAKE_BUILD_TYPE=Release -DDEPAK_PGO=${stage} -DDEPAK_PGO_DIR=${PROFILE_DIR} "-DDEPAK_MARCH=${MARCH}")
+    if(CXX_COMPILER)
+        list(APPEND args -DCMAKE_CXX_COMPILER=${CXX_COMPILER})
+    endif()
+    pgo_run(${CMAKE_COMMAND} ${args})
+    pgo_run(${CMAKE_COMMAND} --build ${dir} --target depak depak_e2e_bench --parallel)
+endfunction()
+
+message(STATUS "[pgo] Building the baseline..")
+pgo_build(${WORK_DIR}/base OFF)
+
+message(STATUS "[pgo] Building the instrumented binaries..")
+file(REMOVE_RECURSE ${PROFILE_DIR} ${TRAIN_DIR})
+file(MAKE_DIRECTORY ${PROFILE_DIR} ${TRAIN_DIR})
+pgo_build(${WORK_DIR}/pgo GENERATE)
+
+# Train on a representative extraction; mixed sizes and data so every decode path is exercised..
+set(DEPAK ${WORK_DIR}/pgo/depak)
+if(TRAIN)
+    set(TRAIN_PAK ${TRAIN})
+else()
+    set(TRAIN_PAK ${TRAIN_DIR}/train.pak)
+    message(STATUS "[pgo] Generating the training PAK file..")
+    pgo_run(${DEPAK} generate -q --entries 4000 --size lognormal:16384:1.5 --max-size 8388608 --profile mixed --seed 11 ${TRAIN_PAK})
+endif()
+
+message(STATUS "[pgo] Training on: ${TRAIN_PAK}")
+execute_process(COMMAND ${DEPAK} -q ${TRAIN_PAK} WORKING_DIRECTORY ${TRAIN_DIR})
+execute_process(COMMAND ${DEPAK} -q --io mmap --sink null --threads 2 ${TRAIN_PAK} WORKING_DIRECTORY ${TRAIN_DIR})
+file(REMOVE_RECURSE ${TRAIN_DIR}/dump)
+
+# Clang writes raw profiles that have to be merged first..
+file(GLOB raw ${PROFILE_DIR}/*.profraw)
+if(raw)
+    find_program(LLVM_PROFDATA NAMES llvm-profdata REQUIRED)
+    pgo_run(${LLVM_PROFDATA} merge -output=${PROFILE_DIR}/depak.profdata ${raw})
+endif()
+
+message(STATUS "[pgo] Building the profile-optimized binaries..")
+pgo_build(${WORK_DIR}/pgo USE)
+
+# Compare both builds on the same corpus; the bench exits with 1 when a combination got slower, which is reported but not fatal..
+message(STATUS "[pgo] Benchmarking the baseline..")
+pgo_run(${WORK_DIR}/base/depak_e2e_bench --dir ${WORK_DIR}/corpus ${BENCH_ARGS} --out ${WORK_DIR}/base.json)
+
+message(STATUS "[pgo] Benchmarking the profile-optimized build..")
+execute_process(COMMAND ${WORK_DIR}/pgo/depak_e2e_bench --dir ${WORK_DIR}/corpus ${BENCH_ARGS} --out ${WORK_DIR}/pgo.json --baseline ${WORK_DIR}/base.json)
+
+message(STATUS "[pgo] Done; the optimized binaries are in: ${WORK_DIR}/pgo")
@@ -0,0 +1,277 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Compression analytics per asset type and chunk.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "analyze.h"
+
+/**
+ * The count of chunk count distribution buckets. (0, 1, 2-3, 4-7, .. up to 2^31 and above.)
+ */
+constexpr uint32_t ANALYZE_BUCKETS = 33;
+
+/**
+ * Asset Type Analysis Structure
+ *
+ */
+struct analyzetype_t
+{
+    uint64_t Files;                    // The count of files.
+    uint64_t Chunks;                   // The count of chunks.
+    uint64_t PackedBytes;              // The compressed size of the files.
+    uint64_t DecodedBytes;             // The decompressed size of the files.
+    uint64_t IncompressibleChunks;     // The count of chunks that did not get smaller when compressed.
+    uint64_t SampledChunks;            // The count of chunks decoded for timing.
+    uint64_t SampledBytes;             // The decompressed size of the chunks decoded for timing.
+    uint64_t SampledNs;                // The time taken to decode the sampled chunks.
+    std::vector<uint32_t> ChunkCounts; // The chunk count of each file.
+};
+
+/**
+ * Chunk Count Distribution Bucket Structure
+ *
+ */
+struct analyzebucket_t
+{
+    uint64_t Files;       // The count of files in the bucket.
+    uint64_t PackedBytes; // The compressed size of the files in the bucket.
+};
+
+/**
+ * Returns the chunk count distribution bucket of a chunk count.
+ *
+ * @param {uint32_t} chunks - The chunk count.
+ * @return {uint32_t} The bucket index.
+ */
+static uint32_t analyze_bucket(uint32_t chunks)
+{
+    uint32_t bucket = 0;
+    while (chunks != 0)
+    {
+        chunks >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * Returns the value at the given percentile of a sorted vector.
+ *
+ * @param {std::vector<uint32_t>&} values - The sorted values.
+ * @param {double} percentile - The percentile. (0 to 100)
+ * @return {uint32_t} The value.
+ */
+static uint32_t analyze_percentile(const std::vector<uint32_t>& values, const double percentile)
+{
+    if (values.empty())
+        return 0;
+
+    const auto index = (std::size_t)((percentile / 100.0) * (double)(values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+/**
+ * Prints a single row of the asset type table.
+ *
+ * @param {char*} type - The asset type.
+ * @param {analyzetype_t&} t - The asset type analysis.
+ * @param {uint64_t} totalPacked - The compressed size of the whole archive.
+ * @param {bool} sampled - Flag if chunks were decoded for timing.
+ */
+static void analyze_print_row(const char* type, const analyzetype_t& t, const uint64_t totalPacked, const bool sampled)
+{
+    const auto ratio = t.PackedBytes == 0 ? 0.0 : (double)t.DecodedBytes / (double)t.PackedBytes;
+    const auto share = totalPacked == 0 ? 0.0 : (double)t.PackedBytes * 100.0 / (double)totalPacked;
+    const auto incompressible = t.Chunks == 0 ? 0.0 : (double)t.IncompressibleChunks * 100.0 / (double)t.Chunks;
+
+    char decode[32]{};
+    if (sampled && t.SampledBytes > 0)
+        sprintf_s(decode, u8"%12.3f", ((double)t.SampledNs / 1000000.0) / ((double)t.SampledBytes / (1024.0 * 1024.0)));
+    else
+        sprintf_s(decode, u8"%12s", u8"-");
+
+    char chunks[48]{};
+    sprintf_s(chunks, u8"%u/%u/%u", analyze_percentile(t.ChunkCounts, 50), analyze_percentile(t.ChunkCounts, 90), t.ChunkCounts.empty() ? 0 : t.ChunkCounts.back());
+
+    printf_s(u8"%-12s %9llu %10llu %11.2f %11.2f %7.3fx %6.1f%% %18s %8.1f%% %s\r\n", type, (unsigned long long)t.Files, (unsigned long long)t.Chunks,
+        (double)t.PackedBytes / (1024.0 * 1024.0), (double)t.DecodedBytes / (1024.0 * 1024.0), ratio, share, chunks, incompressible, decode);
+}
+
+/**
+ * Reports where the bytes of a PAK file go, per asset type, from its entry and chunk tables.
+ *
+ * Only the chunk tables are read, so the report is fast even on large archives. When a sample percentage is given,
+ * that share of the chunks is also read and decoded to measure the decode time per MB of each asset type.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {double} samplePercent - The percentage of chunks to decode for timing. (0 to skip decoding.)
+ */
+void analyze_pak(FILE* f, const pakheader_t* header, const double samplePercent)
+{
+    // Read the entry and string tables..
+    std::vector<pakfileentry_t> fileEntries;
+    std::vector<std::tuple<uint32_t, std::string>> stringEntries;
+    uint32_t sCount = 0;
+
+    if (!pak_read_entries(f, header, fileEntries, sCount) || fileEntries.empty())
+    {
+        printf_s(u8"[!] Error: Failed to read the entries table; cannot analyze.\r\n");
+        return;
+    }
+
+    const auto table = fileEntries.back();
+    fileEntries.pop_back();
+
+    if (!pak_read_names(f, header, table, stringEntries))
+        printf_s(u8"[!] Warning: Failed to read the strings table; asset types will be unknown.\r\n");
+
+    std::unordered_map<uint32_t, std::size_t> index;
+    pak_index_names(stringEntries, index);
+
+    const auto sampled = samplePercent > 0;
+    if (sampled)
+        printf_s(u8"[!] Info: Analyzing %zu entries, decoding %.2f%% of the chunks for timing..\r\n\r\n", fileEntries.size(), samplePercent);
+    else
+        printf_s(u8"[!] Info: Analyzing %zu entries..\r\n\r\n", fileEntries.size());
+
+    std::map<std::string, analyzetype_t> types;
+    analyzebucket_t buckets[ANALYZE_BUCKETS]{};
+    uint64_t failures = 0;
+
+    // The sampled chunks are picked at random, with a fixed seed so runs are comparable..
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> pick(0.0, 100.0);
+
+    std::vector<uint32_t> chunkSizes;
+    std::vector<uint8_t> chunkData;
+    std::vector<uint8_t> bufferDec(PAK_CHUNK_SIZE, u8'\0');
+
+    for (const auto& e : fileEntries)
+    {
+        const auto offset = (uint64_t)e.Position * header->Unknown00;
+
+        // Every chunk but the last decodes to a full chunk, so the count must match the file size..
+        uint32_t fileSize = 0;
+        if (!pak_read_chunk_table(f, offset, fileSize, chunkSizes) || chunkSizes.size() != ((uint64_t)fileSize + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE)
+        {
+            failures++;
+            continue;
+        }
+
+        const auto iter = index.find(e.Crc);
+        auto& t         = types[pak_asset_type(iter != index.end() ? std::get<1>(stringEntries[iter->second]) : u8"")];
+
+        const auto chunks = (uint32_t)chunkSizes.size();
+        uint64_t packed   = 0;
+        uint64_t pos      = offset + 8 + (uint64_t)chunks * 4;
+
+        for (uint32_t x = 0; x < chunks; x++)
+        {
+            const auto expected = x + 1 < chunks ? PAK_CHUNK_SIZE : fileSize - x * PAK_CHUNK_SIZE;
+            if (chunkSizes[x] >= expected)
+                t.IncompressibleChunks++;
+
+            // Decode the sampled chunks on their own to time them..
+            if (sampled && pick(rng) < samplePercent)
+            {
+                chunkData.resize(chunkSizes[x]);
+                if (_fseeki64(f, (int64_t)pos, SEEK_SET) != 0 || (!chunkData.empty() && fread(chunkData.data(), 1, chunkData.size(), f) != chunkData.size()))
+                    failures++;
+                else
+                {
+                    // Decoded with the bounds checked decoder; damaged chunks count as failures instead of timings..
+                    uint32_t decoded = 0;
+                    const auto start = std::chrono::steady_clock::now();
+                    const auto ok    = pak_decode_chunk_checked(chunkData.data(), chunkSizes[x], bufferDec.data(), PAK_CHUNK_SIZE, decoded);
+                    const auto ns    = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                    if (!ok || decoded != expected)
+                        failures++;
+                    else
+                    {
+                        t.SampledNs += ns;
+                        t.SampledBytes += decoded;
+                        t.SampledChunks++;
+                    }
+                }
+            }
+
+            packed += chunkSizes[x];
+            pos += chunkSizes[x];
+        }
+
+        t.Files++;
+        t.Chunks += chunks;
+        t.PackedBytes += packed;
+        t.DecodedBytes += fileSize;
+        t.ChunkCounts.push_back(chunks);
+
+        auto& b = buckets[analyze_bucket(chunks)];
+        b.Files++;
+        b.PackedBytes += packed;
+    }
+
+    // Order the asset types by their share of the archive..
+    std::vector<std::pair<std::string, analyzetype_t*>> rows;
+    analyzetype_t total{};
+    for (auto& t : types)
+    {
+        std::sort(t.second.ChunkCounts.begin(), t.second.ChunkCounts.end());
+        rows.push_back({t.first, &t.second});
+
+        total.Files += t.second.Files;
+        total.Chunks += t.second.Chunks;
+        total.PackedBytes += t.second.PackedBytes;
+        total.DecodedBytes += t.second.DecodedBytes;
+        total.IncompressibleChunks += t.second.IncompressibleChunks;
+        total.SampledChunks += t.second.SampledChunks;
+        total.SampledBytes += t.second.SampledBytes;
+        total.SampledNs += t.second.SampledNs;
+        total.ChunkCounts.insert(total.ChunkCounts.end(), t.second.ChunkCounts.begin(), t.second.ChunkCounts.end());
+    }
+    std::sort(total.ChunkCounts.begin(), total.ChunkCounts.end());
+    std::sort(rows.begin(), rows.end(), [](const std::pair<std::string, analyzetype_t*>& a, const std::pair<std::string, analyzetype_t*>& b) -> bool {
+        return a.second->PackedBytes > b.second->PackedBytes;
+    });
+
+    printf_s(u8"%-12s %9s %10s %11s %11s %8s %7s %18s %9s %12s\r\n", u8"Type", u8"Files", u8"Chunks", u8"Packed MB", u8"Decoded MB", u8"Ratio", u8"Share",
+        u8"Chunks p50/p90/max", u8"Incompr.", u8"Decode ms/MB");
+    for (const auto& r : rows)
+        analyze_print_row(r.first.c_str(), *r.second, total.PackedBytes, sampled);
+    printf_s(u8"\r\n");
+    analyze_print_row(u8"(all)", total, total.PackedBytes, sampled);
+
+    // Print the chunk count distribution..
+    printf_s(u8"\r\n[!] Info: Chunk count distribution:\r\n");
+    printf_s(u8"%22s %9s %8s %11s %8s\r\n", u8"Chunks", u8"Files", u8"% files", u8"Packed MB", u8"% bytes");
+    for (uint32_t x = 0; x < ANALYZE_BUCKETS; x++)
+    {
+        const auto& b = buckets[x];
+        if (b.Files == 0)
+            continue;
+
+        char range[32]{};
+        if (x <= 1)
+            sprintf_s(range, u8"%u", x);
+        else
+            sprintf_s(range, u8"%llu-%llu", 1ull << (x - 1), (1ull << x) - 1);
+
+        printf_s(u8"%22s %9llu %7.2f%% %11.2f %7.2f%%\r\n", range, (unsigned long long)b.Files, (double)b.Files * 100.0 / (double)std::max<uint64_t>(1, total.Files),
+            (double)b.PackedBytes / (1024.0 * 1024.0), (double)b.PackedBytes * 100.0 / (double)std::max<uint64_t>(1, total.PackedBytes));
+    }
+
+    if (sampled)
+        printf_s(u8"\r\n[!] Info: Decoded %llu sampled chunks (%.2f MB).\r\n", (unsigned long long)total.SampledChunks, (double)total.SampledBytes / (1024.0 * 1024.0));
+    if (failures > 0)
+        printf_s(u8"[!] Warning: %llu entries or chunks could not be read or decoded.\r\n", (unsigned long long)failures);
+}
@@ -0,0 +1,26 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Compression analytics per asset type and chunk.
+ */
+#ifndef DEPAK_ANALYZE_H_INCLUDED
+#define DEPAK_ANALYZE_H_INCLUDED
+
+#include <cstdint>
+#include <cstdio>
+#include "pak.h"
+
+/**
+ * Reports where the bytes of a PAK file go, per asset type, from its entry and chunk tables.
+ *
+ * Only the chunk tables are read, so the report is fast even on large archives. When a sample percentage is given,
+ * that share of the chunks is also read and decoded to measure the decode time per MB of each asset type.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {double} samplePercent - The percentage of chunks to decode for timing. (0 to skip decoding.)
+ */
+void analyze_pak(FILE* f, const pakheader_t* header, const double samplePercent);
+
+#endif // DEPAK_ANALYZE_H_INCLUDED
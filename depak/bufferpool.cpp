@@ -0,0 +1,165 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Reusable per-thread buffers for compressed and decoded chunk data.
+ */
+#include <Windows.h>
+#include <atomic>
+#include <new>
+
+#include "bufferpool.h"
+#include "memstats.h"
+#include "numa.h"
+
+/**
+ * Buffer pool totals, added to as pools are released.
+ */
+static std::atomic<uint64_t> g_PoolAcquires{0};
+static std::atomic<uint64_t> g_PoolAllocations{0};
+static std::atomic<uint64_t> g_PoolPools{0};
+static std::atomic<uint64_t> g_PoolCapacity{0};
+
+/**
+ * Releases the memory of a pool block.
+ *
+ * @param {poolblock_t&} b - The block.
+ */
+static void pool_free(poolblock_t& b)
+{
+    if (b.Mapped != 0)
+        huge_free(b.Memory, b.Mapped);
+    else
+        ::operator delete(b.Memory);
+
+    b = poolblock_t{};
+}
+
+/**
+ * Returns the capacity a pool buffer is allocated with for the given size. (The next power of two, at least
+ * POOL_MIN_SIZE.)
+ *
+ * @param {std::size_t} size - The required size.
+ * @return {std::size_t} The capacity.
+ */
+static std::size_t pool_capacity(const std::size_t size)
+{
+    auto capacity = POOL_MIN_SIZE;
+    while (capacity < size)
+        capacity <<= 1;
+    return capacity;
+}
+
+/**
+ * Returns a pool buffer that holds at least the given size plus POOL_SLACK bytes.
+ *
+ * The contents of the buffer are not kept when it has to grow.
+ *
+ * @param {bufferpool_t&} pool - The pool.
+ * @param {PoolBuffer} kind - The buffer kind.
+ * @param {std::size_t} size - The required size.
+ * @return {uint8_t*} The buffer, aligned to POOL_ALIGNMENT.
+ */
+uint8_t* pool_acquire(bufferpool_t& pool, const PoolBuffer kind, const std::size_t size)
+{
+    pool.Acquires++;
+
+    auto& b = pool.Blocks[(int)kind];
+    if (b.Data != nullptr && size <= b.Capacity)
+        return b.Data;
+
+    // Grow to the next power of two so a run of slowly growing files only allocates a handful of times..
+    const auto capacity = pool_capacity(size);
+
+    pool_free(b);
+
+    // Huge page allocations are page aligned and rounded up to whole huge pages; the rounding is usable capacity..
+    if (pool.Pages != HugePages::Off)
+    {
+        b.Memory = huge_alloc(capacity + POOL_SLACK, pool.Pages, b.Mapped);
+        if (b.Memory != nullptr)
+        {
+            b.Data     = (uint8_t*)b.Memory;
+            b.Capacity = b.Mapped - POOL_SLACK;
+
+            // Nothing is touched yet, so binding places every page on the node..
+            if (pool.Numa)
+                numa_bind(b.Memory, b.Mapped, pool.NumaNode);
+        }
+    }
+
+    // Otherwise allocated through operator new so the allocation accounting sees pool growth..
+    if (b.Memory == nullptr)
+    {
+        b.Memory   = ::operator new(capacity + POOL_SLACK + POOL_ALIGNMENT);
+        b.Data     = (uint8_t*)(((uintptr_t)b.Memory + POOL_ALIGNMENT - 1) & ~(uintptr_t)(POOL_ALIGNMENT - 1));
+        b.Capacity = capacity;
+    }
+
+    b.Rounded = capacity;
+    pool.Allocations++;
+    return b.Data;
+}
+
+/**
+ * Frees the pool buffers that are larger than a buffer acquired for the given size would be.
+ *
+ * @param {bufferpool_t&} pool - The pool.
+ * @param {std::size_t} size - The largest size the kept buffers must serve.
+ */
+void pool_trim(bufferpool_t& pool, const std::size_t size)
+{
+    const auto capacity = pool_capacity(size);
+    for (auto& b : pool.Blocks)
+    {
+        // Compared before huge page rounding, so buffers of regular requests are never freed..
+        if (b.Memory != nullptr && b.Rounded > capacity)
+            pool_free(b);
+    }
+}
+
+/**
+ * Releases the buffers of a pool and adds its counters to the process totals.
+ *
+ * @param {bufferpool_t&} pool - The pool.
+ */
+void pool_release(bufferpool_t& pool)
+{
+    uint64_t capacity = 0;
+    for (auto& b : pool.Blocks)
+    {
+        capacity += b.Capacity;
+        pool_free(b);
+    }
+
+    g_PoolAcquires.fetch_add(pool.Acquires, std::memory_order_relaxed);
+    g_PoolAllocations.fetch_add(pool.Allocations, std::memory_order_relaxed);
+    g_PoolPools.fetch_add(1, std::memory_order_relaxed);
+    g_PoolCapacity.fetch_add(capacity, std::memory_order_relaxed);
+
+    pool.Acquires    = 0;
+    pool.Allocations = 0;
+}
+
+/**
+ * Prints the buffer pool totals. (Only when heap allocation accounting is enabled.)
+ */
+void pool_print(void)
+{
+    const auto pools = g_PoolPools.load(std::memory_order_relaxed);
+    if (!mem_enabled() || pools == 0)
+        return;
+
+    const auto acquires    = g_PoolAcquires.load(std::memory_order_relaxed);
+    const auto allocations = g_PoolAllocations.load(std::memory_order_relaxed);
+
+    printf_s(u8"\r\n[!] Buffer pool: (summed over %llu threads)\r\n", (unsigned long long)pools);
+    printf_s(u8"    Acquires       : %llu (%llu served without allocating)\r\n", (unsigned long long)acquires, (unsigned long long)(acquires - allocations));
+    printf_s(u8"    Allocations    : %llu\r\n", (unsigned long long)allocations);
+    printf_s(u8"    Capacity       : %.2f MB\r\n", (double)g_PoolCapacity.load(std::memory_order_relaxed) / (1024.0 * 1024.0));
+
+    const auto huge = huge_stats();
+    if (huge.Explicit + huge.Transparent + huge.Fallbacks > 0)
+        printf_s(u8"    Huge pages     : %llu explicit, %llu transparent, %llu fell back\r\n", (unsigned long long)huge.Explicit, (unsigned long long)huge.Transparent,
+            (unsigned long long)huge.Fallbacks);
+}
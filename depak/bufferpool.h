@@ -0,0 +1,108 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Reusable per-thread buffers for compressed and decoded chunk data.
+ */
+#ifndef DEPAK_BUFFERPOOL_H_INCLUDED
+#define DEPAK_BUFFERPOOL_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include "hugepages.h"
+
+/**
+ * The alignment of every pool buffer. (A cache line.)
+ */
+constexpr std::size_t POOL_ALIGNMENT = 64;
+
+/**
+ * The count of bytes past the requested size every pool buffer holds, so decoders that read or write slightly
+ * past the end of their data never leave the buffer.
+ */
+constexpr std::size_t POOL_SLACK = 64;
+
+/**
+ * The smallest buffer a pool allocates.
+ */
+constexpr std::size_t POOL_MIN_SIZE = 64 * 1024;
+
+/**
+ * Pool Buffer Enumeration
+ *
+ */
+enum class PoolBuffer
+{
+    Compressed, // The compressed chunk data of a file.
+    Decoded,    // The decompressed data of a file.
+
+    Count
+};
+
+/**
+ * Pool Block Structure
+ *
+ */
+struct poolblock_t
+{
+    void* Memory;         // The allocated memory. (Unaligned.)
+    uint8_t* Data;        // The aligned buffer inside of the allocated memory.
+    std::size_t Capacity; // The usable size of the buffer, excluding the slack.
+    std::size_t Rounded;  // The power of two size the buffer was allocated for. (Capacity before huge page rounding.)
+    std::size_t Mapped;   // The size of the huge page allocation. (0 when allocated with operator new.)
+};
+
+/**
+ * Buffer Pool Structure
+ *
+ * One buffer of each kind, owned by a single thread. Buffers only ever grow, to the largest size requested so far
+ * rounded up to a power of two, so once the largest file has been seen every request is served without allocating.
+ * A zero-initialized pool is empty and ready for use; set Pages before the first acquire to back it with huge pages.
+ * Buffers are first touched by the owning thread, so a pinned thread gets them on its own NUMA node.
+ */
+struct bufferpool_t
+{
+    poolblock_t Blocks[(int)PoolBuffer::Count]; // The buffer of each kind.
+    uint64_t Acquires;                          // The count of buffers handed out.
+    uint64_t Allocations;                       // The count of times a buffer had to grow.
+    HugePages Pages;                            // The page kind buffers are allocated with.
+    bool Numa;                                  // Flag if huge page buffers are bound to NumaNode.
+    uint32_t NumaNode;                          // The NUMA node of the owning thread.
+};
+
+/**
+ * Returns a pool buffer that holds at least the given size plus POOL_SLACK bytes.
+ *
+ * The contents of the buffer are not kept when it has to grow.
+ *
+ * @param {bufferpool_t&} pool - The pool.
+ * @param {PoolBuffer} kind - The buffer kind.
+ * @param {std::size_t} size - The required size.
+ * @return {uint8_t*} The buffer, aligned to POOL_ALIGNMENT.
+ */
+uint8_t* pool_acquire(bufferpool_t& pool, const PoolBuffer kind, const std::size_t size);
+
+/**
+ * Frees the pool buffers that are larger than a buffer acquired for the given size would be.
+ *
+ * Lets a thread give back the memory of a one-off large request instead of holding it until the pool is released.
+ *
+ * @param {bufferpool_t&} pool - The pool.
+ * @param {std::size_t} size - The largest size the kept buffers must serve.
+ */
+void pool_trim(bufferpool_t& pool, const std::size_t size);
+
+/**
+ * Releases the buffers of a pool and adds its counters to the process totals.
+ *
+ * @param {bufferpool_t&} pool - The pool.
+ */
+void pool_release(bufferpool_t& pool);
+
+/**
+ * Prints the buffer pool totals. (Only when heap allocation accounting is enabled.)
+ */
+void pool_print(void);
+
+#endif // DEPAK_BUFFERPOOL_H_INCLUDED
@@ -0,0 +1,336 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Codec comparison benchmark over the contents of a PAK file.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "aplib.h"
+#include "codecbench.h"
+
+// Optional codecs are only used when the build enables them, since their libraries must be linked too..
+#ifndef DEPAK_HAVE_LZ4
+#define DEPAK_HAVE_LZ4 0
+#endif
+#ifndef DEPAK_HAVE_ZSTD
+#define DEPAK_HAVE_ZSTD 0
+#endif
+
+#if DEPAK_HAVE_LZ4
+#pragma comment(lib, "lz4.lib")
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+#if DEPAK_HAVE_ZSTD
+#pragma comment(lib, "zstd.lib")
+#include <zstd.h>
+#endif
+
+/**
+ * Codec Structure
+ *
+ */
+struct codec_t
+{
+    const char* Name;                                                                     // The display name of the codec.
+    int32_t Level;                                                                        // The compression level passed to the codec.
+    std::size_t (*Bound)(std::size_t size);                                               // Returns the worst case compressed size.
+    std::size_t (*Compress)(const uint8_t* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize, int32_t level); // Returns the compressed size, 0 on failure.
+    std::size_t (*Decompress)(const uint8_t* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize);              // Returns the decompressed size.
+};
+
+/**
+ * Codec Result Structure
+ *
+ */
+struct codecresult_t
+{
+    uint64_t Files;            // The count of files processed.
+    uint64_t DecodedBytes;     // The total decompressed size of the files.
+    uint64_t CompressedBytes;  // The total compressed size of the files.
+    uint64_t CompressNs;       // The total time spent compressing.
+    uint64_t DecompressNs;     // The total time spent decompressing.
+    uint64_t Failures;         // The count of files that failed to round-trip.
+};
+
+/**
+ * aPLib codec wrappers.
+ */
+static std::size_t aplib_bound(std::size_t size)
+{
+    return aP_max_packed_size((unsigned int)size);
+}
+static std::size_t aplib_compress(const uint8_t* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize, int32_t level)
+{
+    UNREFERENCED_PARAMETER(dstSize);
+    UNREFERENCED_PARAMETER(level);
+
+    static std::vector<uint8_t> workmem(aP_workmem_size(PAK_CHUNK_SIZE));
+    const auto size = aP_pack(src, dst, (unsigned int)srcSize, workmem.data(), nullptr, nullptr);
+    return size == APLIB_ERROR ? 0 : size;
+}
+static std::size_t aplib_decompress(const uint8_t* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize)
+{
+    UNREFERENCED_PARAMETER(srcSize);
+    UNREFERENCED_PARAMETER(dstSize);
+
+    return aP_depack_asm(src, dst);
+}
+
+#if DEPAK_HAVE_LZ4
+/**
+ * LZ4 codec wrappers.
+ */
+static std::size_t lz4_bound(std::size_t size)
+{
+    return (std::size_t)LZ4_compressBound((int)size);
+}
+static std::size_t lz4_compress(const uint8_t* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize, int32_t level)
+{
+    const auto size = level > 0
+                          ? LZ4_compress_HC((const char*)src, (char*)dst, (int)srcSize, (int)dstSize, level)
+                          : LZ4_compress_default((const char*)src, (char*)dst, (int)srcSize, (int)dstSize);
+    return size > 0 ? (std::size_t)size : 0;
+}
+static std::size_t lz4_decompress(const uint8_t* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize)
+{
+    const auto size = LZ4_decompress_safe((const char*)src, (char*)dst, (int)srcSize, (int)dstSize);
+    return size > 0 ? (std::size_t)size : 0;
+}
+#endif
+
+#if DEPAK_HAVE_ZSTD
+/**
+ * zstd codec wrappers.
+ */
+static std::size_t zstd_bound(std::size_t size)
+{
+    return ZSTD_compressBound(size);
+}
+static std::size_t zstd_compress(const uint8_t* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize, int32_t level)
+{
+    const auto size = ZSTD_compress(dst, dstSize, src, srcSize, level);
+    return ZSTD_isError(size) ? 0 : size;
+}
+static std::size_t zstd_decompress(const uint8_t* src, std::size_t srcSize, uint8_t* dst, std::size_t dstSize)
+{
+    const auto size = ZSTD_decompress(dst, dstSize, src, srcSize);
+    return ZSTD_isError(size) ? 0 : size;
+}
+#endif
+
+/**
+ * The list of codecs to benchmark. (aPLib exposes a single compression level.)
+ */
+static const codec_t g_Codecs[] = {
+    {u8"aPLib", 0, aplib_bound, aplib_compress, aplib_decompress},
+#if DEPAK_HAVE_LZ4
+    {u8"LZ4", 0, lz4_bound, lz4_compress, lz4_decompress},
+    {u8"LZ4 HC 9", 9, lz4_bound, lz4_compress, lz4_decompress},
+    {u8"LZ4 HC 12", 12, lz4_bound, lz4_compress, lz4_decompress},
+#endif
+#if DEPAK_HAVE_ZSTD
+    {u8"zstd 1", 1, zstd_bound, zstd_compress, zstd_decompress},
+    {u8"zstd 3", 3, zstd_bound, zstd_compress, zstd_decompress},
+    {u8"zstd 9", 9, zstd_bound, zstd_compress, zstd_decompress},
+    {u8"zstd 19", 19, zstd_bound, zstd_compress, zstd_decompress},
+#endif
+};
+
+/**
+ * Returns the elapsed nanoseconds since the given time point.
+ *
+ * @param {std::chrono::steady_clock::time_point} start - The starting time point.
+ * @return {uint64_t} The elapsed nanoseconds.
+ */
+static uint64_t elapsed_ns(const std::chrono::steady_clock::time_point start)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Returns the throughput in MB/s of the given byte count and duration.
+ *
+ * @param {uint64_t} bytes - The count of bytes processed.
+ * @param {uint64_t} ns - The time taken in nanoseconds.
+ * @return {double} The throughput in MB/s.
+ */
+static double mb_per_sec(const uint64_t bytes, const uint64_t ns)
+{
+    return ns == 0 ? 0.0 : ((double)bytes / (1024.0 * 1024.0)) / ((double)ns / 1000000000.0);
+}
+
+/**
+ * Prints a single result row of the benchmark table.
+ *
+ * @param {char*} type - The asset type.
+ * @param {char*} codec - The codec name.
+ * @param {codecresult_t&} r - The result to print.
+ * @param {bool} hasCompress - Flag if the compression speed is available.
+ */
+static void print_row(const char* type, const char* codec, const codecresult_t& r, const bool hasCompress)
+{
+    const auto ratio = r.CompressedBytes == 0 ? 0.0 : (double)r.DecodedBytes / (double)r.CompressedBytes;
+
+    char compress[32]{};
+    if (hasCompress)
+        sprintf_s(compress, u8"%10.1f", mb_per_sec(r.DecodedBytes, r.CompressNs));
+    else
+        sprintf_s(compress, u8"%10s", u8"-");
+
+    printf_s(u8"%-12s %-10s %8llu %12.2f %12.2f %7.3fx %s %12.1f%s\r\n",
+        type, codec, (unsigned long long)r.Files,
+        (double)r.DecodedBytes / (1024.0 * 1024.0),
+        (double)r.CompressedBytes / (1024.0 * 1024.0),
+        ratio, compress,
+        mb_per_sec(r.DecodedBytes, r.DecompressNs),
+        r.Failures > 0 ? u8"  (round-trip failures!)" : u8"");
+}
+
+/**
+ * Decodes a sample of entries from a PAK file and re-encodes them with the available codecs.
+ *
+ * Each decoded chunk is re-encoded on its own so the results keep the archives random access granularity.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {uint32_t} sampleCount - The maximum number of entries to sample.
+ */
+void codec_bench(FILE* f, const pakheader_t* header, const uint32_t sampleCount)
+{
+    // Read the entry and string tables..
+    std::vector<pakfileentry_t> fileEntries;
+    std::vector<std::tuple<uint32_t, std::string>> stringEntries;
+    uint32_t sCount = 0;
+
+    if (!pak_read_entries(f, header, fileEntries, sCount) || fileEntries.empty())
+    {
+        printf_s(u8"[!] Error: Failed to read the entries table; cannot benchmark.\r\n");
+        return;
+    }
+
+    const auto table = fileEntries.back();
+    fileEntries.pop_back();
+
+    if (!pak_read_names(f, header, table, stringEntries))
+        printf_s(u8"[!] Warning: Failed to read the strings table; asset types will be unknown.\r\n");
+
+    std::unordered_map<uint32_t, std::string> names;
+    for (const auto& se : stringEntries)
+        names.emplace(std::get<0>(se), std::get<1>(se));
+
+    // Pick an evenly spaced sample of the position sorted entries..
+    const auto count  = std::min<std::size_t>(sampleCount == 0 ? fileEntries.size() : sampleCount, fileEntries.size());
+    const auto stride = count == 0 ? 1 : std::max<std::size_t>(1, fileEntries.size() / count);
+
+    printf_s(u8"[!] Info: Benchmarking %zu of %zu entries with %zu codec(s)..\r\n\r\n", count, fileEntries.size(), std::size(g_Codecs));
+
+    // Results are keyed by asset type, then by codec (0 being the original pak data)..
+    std::map<std::string, std::vector<codecresult_t>> results;
+    const auto codecCount = std::size(g_Codecs) + 1;
+
+    std::vector<uint32_t> chunkSizes;
+    std::vector<uint8_t> chunkData;
+    std::vector<uint8_t> fileData;
+    std::vector<uint8_t> bufferEnc;
+    std::vector<uint8_t> bufferDec(PAK_CHUNK_SIZE + 64, u8'\0');
+    std::vector<std::size_t> encSizes;
+
+    for (std::size_t x = 0, n = 0; x < fileEntries.size() && n < count; x += stride, n++)
+    {
+        const auto& e = fileEntries[x];
+
+        // Read the file via the regular chunk path..
+        if (!pak_read_chunks(f, (uint64_t)e.Position * header->Unknown00, chunkSizes, chunkData) || chunkSizes.empty())
+            continue;
+
+        fileData.clear();
+        auto start = std::chrono::steady_clock::now();
+        const auto decoded  = pak_decode_chunks(chunkSizes, chunkData, fileData);
+        const auto decodeNs = elapsed_ns(start);
+        if (!decoded)
+            continue;
+
+        const auto it   = names.find(e.Crc);
+        const auto type = pak_asset_type(it != names.end() ? it->second : u8"");
+
+        auto& rows = results[type];
+        if (rows.empty())
+            rows.resize(codecCount, codecresult_t{});
+
+        // Record the original pak data..
+        rows[0].Files++;
+        rows[0].DecodedBytes += fileData.size();
+        rows[0].CompressedBytes += chunkData.size();
+        rows[0].DecompressNs += decodeNs;
+
+        // Re-encode the file with each codec, chunk by chunk..
+        for (std::size_t c = 0; c < std::size(g_Codecs); c++)
+        {
+            const auto& codec = g_Codecs[c];
+            auto& r           = rows[c + 1];
+
+            const auto chunkCount = (fileData.size() + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE;
+            const auto bound      = codec.Bound(PAK_CHUNK_SIZE);
+            bufferEnc.resize(chunkCount * bound);
+            encSizes.resize(chunkCount);
+
+            bool failed = false;
+
+            start = std::chrono::steady_clock::now();
+            for (std::size_t y = 0; y < chunkCount; y++)
+            {
+                const auto len = std::min<std::size_t>(PAK_CHUNK_SIZE, fileData.size() - y * PAK_CHUNK_SIZE);
+                encSizes[y]    = codec.Compress(fileData.data() + y * PAK_CHUNK_SIZE, len, bufferEnc.data() + y * bound, bound, codec.Level);
+                failed |= encSizes[y] == 0;
+            }
+            r.CompressNs += elapsed_ns(start);
+
+            start = std::chrono::steady_clock::now();
+            for (std::size_t y = 0; y < chunkCount && !failed; y++)
+            {
+                const auto len = std::min<std::size_t>(PAK_CHUNK_SIZE, fileData.size() - y * PAK_CHUNK_SIZE);
+                const auto dec = codec.Decompress(bufferEnc.data() + y * bound, encSizes[y], bufferDec.data(), bufferDec.size());
+                failed |= dec != len || std::memcmp(bufferDec.data(), fileData.data() + y * PAK_CHUNK_SIZE, len) != 0;
+            }
+            r.DecompressNs += elapsed_ns(start);
+
+            r.Files++;
+            r.DecodedBytes += fileData.size();
+            for (std::size_t y = 0; y < chunkCount; y++)
+                r.CompressedBytes += encSizes[y];
+            r.Failures += failed ? 1 : 0;
+        }
+    }
+
+    // Print the results per asset type, followed by the totals..
+    printf_s(u8"%-12s %-10s %8s %12s %12s %8s %10s %12s\r\n", u8"Type", u8"Codec", u8"Files", u8"Decoded MB", u8"Packed MB", u8"Ratio", u8"Comp MB/s", u8"Decomp MB/s");
+
+    std::vector<codecresult_t> totals(codecCount, codecresult_t{});
+    for (const auto& r : results)
+    {
+        for (std::size_t c = 0; c < codecCount; c++)
+        {
+            print_row(r.first.c_str(), c == 0 ? u8"pak" : g_Codecs[c - 1].Name, r.second[c], c != 0);
+
+            totals[c].Files += r.second[c].Files;
+            totals[c].DecodedBytes += r.second[c].DecodedBytes;
+            totals[c].CompressedBytes += r.second[c].CompressedBytes;
+            totals[c].CompressNs += r.second[c].CompressNs;
+            totals[c].DecompressNs += r.second[c].DecompressNs;
+            totals[c].Failures += r.second[c].Failures;
+        }
+        printf_s(u8"\r\n");
+    }
+
+    for (std::size_t c = 0; c < codecCount; c++)
+        print_row(u8"(all)", c == 0 ? u8"pak" : g_Codecs[c - 1].Name, totals[c], c != 0);
+}
@@ -0,0 +1,25 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Codec comparison benchmark over the contents of a PAK file.
+ */
+#ifndef DEPAK_CODECBENCH_H_INCLUDED
+#define DEPAK_CODECBENCH_H_INCLUDED
+
+#include <cstdint>
+#include <cstdio>
+#include "pak.h"
+
+/**
+ * Decodes a sample of entries from a PAK file and re-encodes them with the available codecs.
+ *
+ * Each decoded chunk is re-encoded on its own so the results keep the archives random access granularity.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {uint32_t} sampleCount - The maximum number of entries to sample.
+ */
+void codec_bench(FILE* f, const pakheader_t* header, const uint32_t sampleCount);
+
+#endif // DEPAK_CODECBENCH_H_INCLUDED
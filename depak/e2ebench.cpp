@@ -0,0 +1,620 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * End-to-end extraction benchmark. (depak_e2e_bench)
+ *
+ * Generates (or loads) PAK corpora of several shapes, extracts them with every requested combination of thread
+ * count, I/O backend, output sink, huge pages mode and NUMA placement, writes the results as json and compares them against a previous run.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "extract.h"
+#include "generator.h"
+#include "logger.h"
+#include "perf.h"
+
+/**
+ * Benchmark Corpus Structure
+ *
+ */
+struct benchcorpus_t
+{
+    std::string Name;     // The corpus name.
+    std::string Path;     // The PAK file path.
+    bool Generated;       // Flag if the corpus is generated. (False for PAK files given with --pak.)
+    genoptions_t Options; // The generator options of a generated corpus.
+};
+
+/**
+ * Benchmark Result Structure
+ *
+ */
+struct benchresult_t
+{
+    std::string Corpus; // The corpus name.
+    uint32_t Threads;   // The count of extraction threads.
+    ExtractIo Io;       // The I/O backend.
+    ExtractSink Sink;   // The output sink.
+    HugePages Pages;    // The huge pages mode.
+    bool Numa;          // Flag if the workers were pinned per NUMA node.
+    uint64_t Files;     // The count of files extracted per run.
+    uint64_t BytesOut;  // The count of decompressed bytes per run.
+    double Median;      // The median wall time of the runs in seconds.
+    double Min;         // The fastest wall time of the runs in seconds.
+    double Max;         // The slowest wall time of the runs in seconds.
+    double DtlbPerMb;   // The data TLB load misses per decompressed MB. (Negative when not measured.)
+};
+
+/**
+ * Benchmark Options Structure
+ *
+ */
+struct benchoptions_t
+{
+    std::string Dir;                   // The corpus (and file sink output) directory.
+    std::vector<std::string> Corpora;  // The names of the generated corpora to run.
+    std::vector<std::string> Paks;     // Existing PAK files to run.
+    std::vector<uint32_t> Threads;     // The thread counts to run.
+    std::vector<ExtractIo> Io;         // The I/O backends to run.
+    std::vector<ExtractSink> Sinks;    // The output sinks to run.
+    std::vector<HugePages> Pages;      // The huge pages modes to run.
+    std::vector<bool> Numa;            // The NUMA placement modes to run.
+    bool Perf;                         // Flag if data TLB misses are measured with the hardware counters.
+    uint32_t Repeat;                   // The count of timed runs per combination.
+    std::string Out;                   // The json results path.
+    std::string Baseline;              // The json results of a previous run to compare against. (Empty if none.)
+    double Threshold;                  // The slowdown, in percent, reported as a regression.
+};
+
+/**
+ * Returns the generator options of a named corpus shape.
+ *
+ * @param {char*} name - The corpus name. (tiny, huge or mixed)
+ * @param {genoptions_t&} opts - The options to populate.
+ * @return {bool} True on success, false if the name is unknown.
+ */
+static bool bench_corpus_options(const char* name, genoptions_t& opts)
+{
+    opts = gen_default_options();
+
+    if (::strcmp(name, u8"tiny") == 0)
+    {
+        // Many tiny files; dominated by per-file overhead..
+        opts.EntryCount = 20000;
+        opts.SizeDist   = GenSizeDist::Uniform;
+        opts.SizeA      = 64;
+        opts.SizeB      = 4096;
+    }
+    else if (::strcmp(name, u8"huge") == 0)
+    {
+        // Few huge files; dominated by decode and write throughput..
+        opts.EntryCount = 6;
+        opts.SizeDist   = GenSizeDist::Fixed;
+        opts.SizeA      = 48.0 * 1024 * 1024;
+    }
+    else if (::strcmp(name, u8"mixed") == 0)
+    {
+        // A game-like spread of sizes..
+        opts.EntryCount = 3000;
+        opts.SizeDist   = GenSizeDist::LogNormal;
+        opts.SizeA      = 16384;
+        opts.SizeB      = 1.5;
+        opts.MaxSize    = 16 * 1024 * 1024;
+    }
+    else
+        return false;
+
+    return true;
+}
+
+/**
+ * Splits a comma separated list.
+ *
+ * @param {char*} value - The list.
+ * @return {std::vector<std::string>} The list items.
+ */
+static std::vector<std::string> bench_split(const char* value)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (auto p = value;; p++)
+    {
+        if (*p == ',' || *p == '\0')
+        {
+            if (!item.empty())
+                items.push_back(item);
+            item.clear();
+
+            if (*p == '\0')
+                break;
+        }
+        else
+            item += *p;
+    }
+    return items;
+}
+
+/**
+ * Returns the value of a key on a single line json object written by bench_write_results.
+ *
+ * @param {std::string&} line - The json line.
+ * @param {char*} key - The key name.
+ * @return {std::string} The value, without quotes. (Empty if not found.)
+ */
+static std::string bench_json_value(const std::string& line, const char* key)
+{
+    const auto needle = std::string(u8"\"") + key + u8"\": ";
+    auto pos          = line.find(needle);
+    if (pos == std::string::npos)
+        return std::string();
+
+    pos += needle.size();
+    if (line[pos] == '"')
+    {
+        const auto end = line.find('"', pos + 1);
+        return end == std::string::npos ? std::string() : line.substr(pos + 1, end - pos - 1);
+    }
+
+    const auto end = line.find_first_of(u8",}", pos);
+    return line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+/**
+ * Returns the key that identifies a benchmark combination.
+ *
+ * @param {std::string&} corpus - The corpus name.
+ * @param {uint32_t} threads - The thread count.
+ * @param {char*} io - The I/O backend name.
+ * @param {char*} sink - The output sink name.
+ * @param {HugePages} pages - The huge pages mode. (Only part of the key when enabled, so older results still match.)
+ * @param {bool} numa - Flag if the workers are pinned per NUMA node. (Likewise only part of the key when enabled.)
+ * @return {std::string} The combination key.
+ */
+static std::string bench_key(const std::string& corpus, const uint32_t threads, const char* io, const char* sink, const HugePages pages, const bool numa)
+{
+    char key[512]{};
+    if (pages == HugePages::Off)
+        sprintf_s(key, u8"%s/t%u/%s/%s", corpus.c_str(), threads, io, sink);
+    else
+        sprintf_s(key, u8"%s/t%u/%s/%s/%s", corpus.c_str(), threads, io, sink, huge_name(pages));
+
+    return numa ? std::string(key) + u8"/numa" : key;
+}
+
+/**
+ * Writes the benchmark results as json; each result is written on its own line so runs diff cleanly.
+ *
+ * @param {benchoptions_t&} opts - The benchmark options.
+ * @param {std::vector<benchcorpus_t>&} corpora - The corpora that were run.
+ * @param {std::vector<benchresult_t>&} results - The results.
+ * @return {bool} True on success, false otherwise.
+ */
+static bool bench_write_results(const benchoptions_t& opts, const std::vector<benchcorpus_t>& corpora, const std::vector<benchresult_t>& results)
+{
+    FILE* f = nullptr;
+    if (fopen_s(&f, opts.Out.c_str(), u8"wb") != ERROR_SUCCESS)
+    {
+        printf_s(u8"[!] Error: Failed to open results file for writing: %s\r\n", opts.Out.c_str());
+        return false;
+    }
+
+#if defined(_MSC_VER)
+    const auto compiler = u8"msvc " _CRT_STRINGIZE(_MSC_FULL_VER);
+#elif defined(__clang__)
+    const auto compiler = u8"clang " __clang_version__;
+#elif defined(__GNUC__)
+    const auto compiler = u8"gcc " __VERSION__;
+#else
+    const auto compiler = u8"unknown";
+#endif
+
+    fprintf_s(f, u8"{\"version\": 1, \"compiler\": \"%s\", \"hardware_threads\": %u, \"repeat\": %u,\n", compiler, std::thread::hardware_concurrency(), opts.Repeat);
+
+    fprintf_s(f, u8"\"corpora\": [\n");
+    for (std::size_t x = 0; x < corpora.size(); x++)
+    {
+        const auto& c = corpora[x];
+        if (c.Generated)
+            fprintf_s(f, u8"  {\"name\": \"%s\", \"entries\": %llu, \"size_dist\": %d, \"size_a\": %.17g, \"size_b\": %.17g, \"max_size\": %llu, \"profile\": %d, \"seed\": %llu}%s\n",
+                c.Name.c_str(), (unsigned long long)c.Options.EntryCount, (int)c.Options.SizeDist, c.Options.SizeA, c.Options.SizeB, (unsigned long long)c.Options.MaxSize,
+                (int)c.Options.Profile, (unsigned long long)c.Options.Seed, x + 1 < corpora.size() ? u8"," : u8"");
+        else
+            fprintf_s(f, u8"  {\"name\": \"%s\", \"path\": \"%s\"}%s\n", c.Name.c_str(), c.Path.c_str(), x + 1 < corpora.size() ? u8"," : u8"");
+    }
+    fprintf_s(f, u8"],\n");
+
+    fprintf_s(f, u8"\"results\": [\n");
+    for (std::size_t x = 0; x < results.size(); x++)
+    {
+        const auto& r  = results[x];
+        const auto mbs = r.Median > 0 ? ((double)r.BytesOut / (1024.0 * 1024.0)) / r.Median : 0.0;
+        const auto fps = r.Median > 0 ? (double)r.Files / r.Median : 0.0;
+
+        char tlb[32] = u8"null";
+        if (r.DtlbPerMb >= 0)
+            sprintf_s(tlb, u8"%.1f", r.DtlbPerMb);
+
+        fprintf_s(f, u8"  {\"key\": \"%s\", \"corpus\": \"%s\", \"threads\": %u, \"io\": \"%s\", \"sink\": \"%s\", \"pages\": \"%s\", \"numa\": %s, \"files\": %llu, \"bytes_out\": %llu, "
+                     u8"\"median_s\": %.6f, \"min_s\": %.6f, \"max_s\": %.6f, \"mb_per_s\": %.2f, \"files_per_s\": %.1f, \"dtlb_misses_per_mb\": %s}%s\n",
+            bench_key(r.Corpus, r.Threads, extract_io_name(r.Io), extract_sink_name(r.Sink), r.Pages, r.Numa).c_str(), r.Corpus.c_str(), r.Threads, extract_io_name(r.Io),
+            extract_sink_name(r.Sink), huge_name(r.Pages), r.Numa ? u8"true" : u8"false", (unsigned long long)r.Files, (unsigned long long)r.BytesOut, r.Median, r.Min, r.Max, mbs, fps, tlb,
+            x + 1 < results.size() ? u8"," : u8"");
+    }
+    fprintf_s(f, u8"]}\n");
+    fclose(f);
+
+    printf_s(u8"[!] Info: Wrote results to: %s\r\n", opts.Out.c_str());
+    return true;
+}
+
+/**
+ * Compares the results against a previous run.
+ *
+ * @param {benchoptions_t&} opts - The benchmark options.
+ * @param {std::vector<benchresult_t>&} results - The results.
+ * @return {uint32_t} The count of regressions found.
+ */
+static uint32_t bench_compare(const benchoptions_t& opts, const std::vector<benchresult_t>& results)
+{
+    FILE* f = nullptr;
+    if (fopen_s(&f, opts.Baseline.c_str(), u8"rb") != ERROR_SUCCESS)
+    {
+        printf_s(u8"[!] Error: Failed to open baseline file: %s\r\n", opts.Baseline.c_str());
+        return 0;
+    }
+
+    // Load the baseline median of every combination..
+    std::vector<std::tuple<std::string, double>> baseline;
+    char buffer[4096]{};
+    while (fgets(buffer, sizeof(buffer), f) != nullptr)
+    {
+        const std::string line(buffer);
+        const auto key    = bench_json_value(line, u8"key");
+        const auto median = bench_json_value(line, u8"median_s");
+        if (!key.empty() && !median.empty())
+            baseline.push_back({key, ::strtod(median.c_str(), nullptr)});
+    }
+    fclose(f);
+
+    printf_s(u8"\r\n[!] Comparison against: %s (regression threshold: %.1f%%)\r\n", opts.Baseline.c_str(), opts.Threshold);
+    printf_s(u8"    %-32s %12s %12s %9s\r\n", u8"Combination", u8"Base s", u8"Now s", u8"Change");
+
+    uint32_t regressions = 0;
+    uint32_t compared    = 0;
+    double logRatio      = 0.0;
+    for (const auto& r : results)
+    {
+        const auto key  = bench_key(r.Corpus, r.Threads, extract_io_name(r.Io), extract_sink_name(r.Sink), r.Pages, r.Numa);
+        const auto iter = std::find_if(baseline.begin(), baseline.end(), [&key](const std::tuple<std::string, double>& b) -> bool { return std::get<0>(b) == key; });
+        if (iter == baseline.end() || std::get<1>(*iter) <= 0)
+        {
+            printf_s(u8"    %-32s %12s %12.4f %9s\r\n", key.c_str(), u8"-", r.Median, u8"new");
+            continue;
+        }
+
+        const auto base   = std::get<1>(*iter);
+        const auto change = (r.Median - base) / base * 100.0;
+        const auto slower = change > opts.Threshold;
+        if (slower)
+            regressions++;
+
+        if (r.Median > 0)
+        {
+            logRatio += std::log(base / r.Median);
+            compared++;
+        }
+
+        printf_s(u8"    %-32s %12.4f %12.4f %+8.1f%%%s\r\n", key.c_str(), base, r.Median, change, slower ? u8"  REGRESSION" : (change < -opts.Threshold ? u8"  improved" : u8""));
+    }
+
+    // The geometric mean keeps one long running combination from dominating the overall speedup..
+    if (compared > 0)
+        printf_s(u8"[!] Info: Overall speedup: %.3fx (geometric mean of %u combinations)\r\n", std::exp(logRatio / compared), compared);
+    if (regressions > 0)
+        printf_s(u8"[!] Warning: %u regression(s) beyond %.1f%%.\r\n", regressions, opts.Threshold);
+    return regressions;
+}
+
+/**
+ * Prints the command line usage information.
+ */
+static void bench_usage(void)
+{
+    printf_s(u8"Usage: depak_e2e_bench [options]\r\n\r\n");
+    printf_s(u8"  --dir <path>         - The corpus and output directory. (Default: e2e_corpus)\r\n");
+    printf_s(u8"  --corpus <list>      - Generated corpora to run: tiny, huge, mixed. (Default: tiny,huge,mixed)\r\n");
+    printf_s(u8"  --pak <file>         - Adds an existing PAK file as a corpus. (May be repeated.)\r\n");
+    printf_s(u8"  --threads <list>     - Thread counts to run. (Default: 1 and the hardware thread count)\r\n");
+    printf_s(u8"  --io <list>          - I/O backends to run: stdio, mmap. (Default: stdio,mmap)\r\n");
+    printf_s(u8"  --sink <list>        - Output sinks to run: null, file. (Default: null,file)\r\n");
+    printf_s(u8"  --pages <list>       - Huge pages modes to run: off, thp, explicit. (Default: off)\r\n");
+    printf_s(u8"  --numa <list>        - NUMA placement modes to run: off, on. (Default: off)\r\n");
+    printf_s(u8"  --perf <on|off>      - Measures data TLB misses per MB with the hardware counters. (Linux; Default: off)\r\n");
+    printf_s(u8"  --repeat <n>         - Timed runs per combination; the median is reported. (Default: 3)\r\n");
+    printf_s(u8"  --out <file.json>    - The results file. (Default: e2e_results.json)\r\n");
+    printf_s(u8"  --baseline <file>    - Results of a previous run to compare against.\r\n");
+    printf_s(u8"  --threshold <pct>    - Slowdown reported as a regression. (Default: 5)\r\n");
+}
+
+/**
+ * Parses the command line options.
+ *
+ * @param {int32_t} argc - The count of parameters passed to the application.
+ * @param {char*[]} argv - The array of parameters passed to the application.
+ * @param {benchoptions_t&} opts - The options to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+static bool bench_parse_options(int32_t argc, char* argv[], benchoptions_t& opts)
+{
+    opts.Dir       = u8"e2e_corpus";
+    opts.Corpora   = {u8"tiny", u8"huge", u8"mixed"};
+    opts.Threads   = {1};
+    opts.Io        = {ExtractIo::Stdio, ExtractIo::Mmap};
+    opts.Sinks     = {ExtractSink::Null, ExtractSink::File};
+    opts.Pages     = {HugePages::Off};
+    opts.Numa      = {false};
+    opts.Repeat    = 3;
+    opts.Out       = u8"e2e_results.json";
+    opts.Threshold = 5.0;
+
+    const auto hw = std::thread::hardware_concurrency();
+    if (hw > 1)
+        opts.Threads.push_back(hw);
+
+    bool corpusGiven = false;
+    for (int32_t x = 1; x < argc; x++)
+    {
+        const auto arg   = argv[x];
+        const auto value = x + 1 < argc ? argv[x + 1] : nullptr;
+        if (value == nullptr)
+        {
+            printf_s(u8"[!] Error: Missing value for option: %s\r\n", arg);
+            return false;
+        }
+
+        bool valid = true;
+        if (::strcmp(arg, u8"--dir") == 0)
+            opts.Dir = value;
+        else if (::strcmp(arg, u8"--corpus") == 0)
+        {
+            opts.Corpora = bench_split(value);
+            corpusGiven  = true;
+        }
+        else if (::strcmp(arg, u8"--pak") == 0)
+            opts.Paks.push_back(value);
+        else if (::strcmp(arg, u8"--threads") == 0)
+        {
+            opts.Threads.clear();
+            for (const auto& t : bench_split(value))
+                opts.Threads.push_back(::strtoul(t.c_str(), nullptr, 10));
+            valid = !opts.Threads.empty();
+        }
+        else if (::strcmp(arg, u8"--io") == 0)
+        {
+            opts.Io.clear();
+            for (const auto& i : bench_split(value))
+            {
+                ExtractIo io{};
+                valid = valid && extract_parse_io(i.c_str(), io);
+                opts.Io.push_back(io);
+            }
+        }
+        else if (::strcmp(arg, u8"--sink") == 0)
+        {
+            opts.Sinks.clear();
+            for (const auto& s : bench_split(value))
+            {
+                ExtractSink sink{};
+                valid = valid && extract_parse_sink(s.c_str(), sink);
+                opts.Sinks.push_back(sink);
+            }
+        }
+        else if (::strcmp(arg, u8"--pages") == 0)
+        {
+            opts.Pages.clear();
+            for (const auto& p : bench_split(value))
+            {
+                HugePages pages{};
+                valid = valid && huge_parse(p.c_str(), pages);
+                opts.Pages.push_back(pages);
+            }
+        }
+        else if (::strcmp(arg, u8"--numa") == 0)
+        {
+            opts.Numa.clear();
+            for (const auto& n : bench_split(value))
+            {
+                valid = valid && (n == u8"on" || n == u8"off");
+                opts.Numa.push_back(n == u8"on");
+            }
+        }
+        else if (::strcmp(arg, u8"--perf") == 0)
+            valid = (opts.Perf = ::strcmp(value, u8"on") == 0) || ::strcmp(value, u8"off") == 0;
+        else if (::strcmp(arg, u8"--repeat") == 0)
+            opts.Repeat = std::max(1ul, ::strtoul(value, nullptr, 10));
+        else if (::strcmp(arg, u8"--out") == 0)
+            opts.Out = value;
+        else if (::strcmp(arg, u8"--baseline") == 0)
+            opts.Baseline = value;
+        else if (::strcmp(arg, u8"--threshold") == 0)
+            opts.Threshold = ::strtod(value, nullptr);
+        else
+        {
+            printf_s(u8"[!] Error: Unknown option: %s\r\n", arg);
+            return false;
+        }
+
+        if (!valid)
+        {
+            printf_s(u8"[!] Error: Invalid value for option %s: %s\r\n", arg, value);
+            return false;
+        }
+
+        x++;
+    }
+
+    // Only run the given PAK files when no generated corpus was asked for explicitly..
+    if (!opts.Paks.empty() && !corpusGiven)
+        opts.Corpora.clear();
+
+    return true;
+}
+
+/**
+ * Application entry point.
+ *
+ * @param {int32_t} argc - The count of parameters passed to the application.
+ * @param {char*[]} argv - The array of parameters passed to the application.
+ * @return {int32_t} 0 on success, 1 if regressions were found, 2 on error.
+ */
+int32_t __cdecl main(int32_t argc, char* argv[])
+{
+    printf_s(u8"Kingdoms of Amalur: Rereckoning PAK Dumper - End-to-end Benchmark\r\n\r\n");
+
+    benchoptions_t opts{};
+    if (!bench_parse_options(argc, argv, opts))
+    {
+        bench_usage();
+        return 2;
+    }
+
+    ::CreateDirectory(opts.Dir.c_str(), nullptr);
+
+    // Prepare the corpora; generated corpora are reused when already present since generation is deterministic..
+    std::vector<benchcorpus_t> corpora;
+    for (const auto& name : opts.Corpora)
+    {
+        benchcorpus_t c{};
+        c.Name      = name;
+        c.Generated = true;
+        if (!bench_corpus_options(name.c_str(), c.Options))
+        {
+            printf_s(u8"[!] Error: Unknown corpus: %s\r\n", name.c_str());
+            return 2;
+        }
+
+        char path[MAX_PATH]{};
+        sprintf_s(path, u8"%s/%s-s%llu.pak", opts.Dir.c_str(), name.c_str(), (unsigned long long)c.Options.Seed);
+        c.Path = path;
+
+        if (::GetFileAttributes(c.Path.c_str()) == INVALID_FILE_ATTRIBUTES)
+        {
+            printf_s(u8"[!] Info: Generating corpus '%s'..\r\n", name.c_str());
+            if (!gen_write_pak(c.Path.c_str(), c.Options))
+                return 2;
+        }
+        corpora.push_back(c);
+    }
+    for (const auto& pak : opts.Paks)
+    {
+        benchcorpus_t c{};
+        c.Name = pak.substr(pak.find_last_of(u8"/\\") == std::string::npos ? 0 : pak.find_last_of(u8"/\\") + 1);
+        c.Path = pak;
+        corpora.push_back(c);
+    }
+
+    // The counters are only read around the worker phases, so they cover extraction and nothing else..
+    const auto perf = opts.Perf && perf_enable() && perf_available(PerfCounter::DtlbMisses);
+    if (opts.Perf && !perf)
+        printf_s(u8"[!] Warning: Data TLB misses cannot be measured; only throughput is reported.\r\n");
+
+    // Keep the extraction itself quiet; only errors are printed..
+    logger_start(LogLevel::Quiet);
+
+    std::vector<benchresult_t> results;
+    printf_s(u8"\r\n    %-32s %8s %12s %12s %12s %12s %12s\r\n", u8"Combination", u8"Files", u8"Median s", u8"Min s", u8"MB/s", u8"Files/s", u8"dTLB/MB");
+
+    for (const auto& c : corpora)
+    {
+        for (const auto threads : opts.Threads)
+        {
+            for (const auto io : opts.Io)
+            {
+                for (const auto sink : opts.Sinks)
+                {
+                    for (const auto pages : opts.Pages)
+                    {
+                        for (const auto numa : opts.Numa)
+                        {
+                            auto eopts      = extract_default_options();
+                            eopts.Threads   = threads;
+                            eopts.Io        = io;
+                            eopts.Sink      = sink;
+                            eopts.Pages     = pages;
+                            eopts.Numa      = numa;
+                            eopts.OutputDir = opts.Dir + u8"/out_" + c.Name;
+
+                            benchresult_t r{};
+                            r.Corpus    = c.Name;
+                            r.Threads   = threads;
+                            r.Io        = io;
+                            r.Sink      = sink;
+                            r.Pages     = pages;
+                            r.Numa      = numa;
+                            r.DtlbPerMb = -1;
+
+                            // One untimed run warms the page cache so every combination starts from the same state..
+                            extractresult_t er{};
+                            if (!extract_pak(c.Path.c_str(), eopts, er))
+                            {
+                                printf_s(u8"[!] Error: Failed to extract corpus: %s\r\n", c.Path.c_str());
+                                continue;
+                            }
+
+                            perfsample_t before{};
+                            if (perf)
+                                perf_totals(before);
+
+                            std::vector<double> times;
+                            for (uint32_t x = 0; x < opts.Repeat; x++)
+                            {
+                                const auto start = std::chrono::steady_clock::now();
+                                extract_pak(c.Path.c_str(), eopts, er);
+                                times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                            }
+                            std::sort(times.begin(), times.end());
+
+                            r.Files    = er.Files;
+                            r.BytesOut = er.BytesOut;
+                            r.Median   = times[times.size() / 2];
+                            r.Min      = times.front();
+                            r.Max      = times.back();
+
+                            char tlb[32] = u8"-";
+                            if (perf && r.BytesOut > 0)
+                            {
+                                perfsample_t after{};
+                                perf_totals(after);
+
+                                const auto misses = after.Values[(int)PerfCounter::DtlbMisses] - before.Values[(int)PerfCounter::DtlbMisses];
+                                r.DtlbPerMb       = (double)misses / ((double)r.BytesOut * opts.Repeat / (1024.0 * 1024.0));
+                                sprintf_s(tlb, u8"%.1f", r.DtlbPerMb);
+                            }
+                            results.push_back(r);
+
+                            printf_s(u8"    %-32s %8llu %12.4f %12.4f %12.2f %12.1f %12s\r\n", bench_key(r.Corpus, r.Threads, extract_io_name(io), extract_sink_name(sink), pages, numa).c_str(),
+                                (unsigned long long)r.Files, r.Median, r.Min, ((double)r.BytesOut / (1024.0 * 1024.0)) / r.Median, (double)r.Files / r.Median, tlb);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    logger_stop();
+
+    if (!bench_write_results(opts, corpora, results))
+        return 2;
+
+    if (!opts.Baseline.empty() && bench_compare(opts, results) > 0)
+        return 1;
+    return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Lazy, allocation-free views over the file entries of a reader.
+ */
+#include <cctype>
+#include <cstring>
+
+#include "entryview.h"
+
+/**
+ * Constructors
+ *
+ * @param {pakreader_t*} reader - The reader the entry belongs to.
+ * @param {std::size_t} index - The entry index.
+ */
+pakentry_t::pakentry_t(void)
+    : m_Reader(nullptr)
+    , m_Index(0)
+    , m_FileSize(0)
+    , m_Chunks(0)
+    , m_Layout(false)
+{}
+pakentry_t::pakentry_t(pakreader_t* reader, const std::size_t index)
+    : m_Reader(reader)
+    , m_Index(index)
+    , m_FileSize(0)
+    , m_Chunks(0)
+    , m_Layout(false)
+{}
+
+/**
+ * Returns the reader the entry belongs to.
+ *
+ * @return {pakreader_t*} The reader.
+ */
+pakreader_t* pakentry_t::reader(void) const
+{
+    return m_Reader;
+}
+
+/**
+ * Returns the index of the entry in its reader.
+ *
+ * @return {std::size_t} The entry index.
+ */
+std::size_t pakentry_t::index(void) const
+{
+    return m_Index;
+}
+
+/**
+ * Returns the table entry.
+ *
+ * @return {pakfileentry_t&} The table entry.
+ */
+const pakfileentry_t& pakentry_t::entry(void) const
+{
+    return *pak_entry(m_Reader, m_Index);
+}
+
+/**
+ * Returns the file name id of the entry.
+ *
+ * @return {uint32_t} The crc.
+ */
+uint32_t pakentry_t::crc(void) const
+{
+    return entry().Crc;
+}
+
+/**
+ * Returns the position of the file data block, in units of the header alignment.
+ *
+ * @return {uint32_t} The position.
+ */
+uint32_t pakentry_t::position(void) const
+{
+    return entry().Position;
+}
+
+/**
+ * Returns the byte offset of the file data block.
+ *
+ * @return {uint64_t} The offset.
+ */
+uint64_t pakentry_t::offset(void) const
+{
+    return (uint64_t)entry().Position * pak_header(m_Reader)->Unknown00;
+}
+
+/**
+ * Returns the stored size of the file data block.
+ *
+ * @return {uint32_t} The stored size.
+ */
+uint32_t pakentry_t::stored_size(void) const
+{
+    return entry().Size;
+}
+
+/**
+ * Returns the entry name.
+ *
+ * @return {char*} The name, or nullptr if the entry is not named in the string table.
+ */
+const char* pakentry_t::name(void) const
+{
+    return pak_entry_name(m_Reader, m_Index);
+}
+
+/**
+ * Returns if the entry name ends with the given extension, ignoring case. Unnamed entries never match.
+ *
+ * @param {char*} ext - The extension, including the dot.
+ * @return {bool} True if the name ends with the extension, false otherwise.
+ */
+bool pakentry_t::has_extension(const char* ext) const
+{
+    const auto n = name();
+    if (n == nullptr)
+        return false;
+
+    const auto len  = ::strlen(n);
+    const auto elen = ::strlen(ext);
+    if (len < elen)
+        return false;
+
+    for (std::size_t x = 0; x < elen; x++)
+    {
+        if (::tolower((unsigned char)n[len - elen + x]) != ::tolower((unsigned char)ext[x]))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Returns the decoded size of the entry. (Read from the file data on first use.)
+ *
+ * @return {uint64_t} The decoded size, or 0 if it cannot be read.
+ */
+uint64_t pakentry_t::file_size(void) const
+{
+    layout();
+    return m_FileSize;
+}
+
+/**
+ * Returns the count of compressed chunks of the entry. (Read from the file data on first use.)
+ *
+ * @return {uint32_t} The chunk count, or 0 if it cannot be read.
+ */
+uint32_t pakentry_t::chunk_count(void) const
+{
+    layout();
+    return m_Chunks;
+}
+
+/**
+ * Reads the decoded size and chunk count of the entry, once.
+ */
+void pakentry_t::layout(void) const
+{
+    if (m_Layout)
+        return;
+
+    if (!pak_entry_layout(m_Reader, m_Index, m_FileSize, m_Chunks))
+    {
+        m_FileSize = 0;
+        m_Chunks   = 0;
+    }
+    m_Layout = true;
+}
@@ -0,0 +1,283 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Lazy, allocation-free views over the file entries of a reader.
+ *
+ * A view walks the entries of a reader in position order without copying them. Views are filtered by chaining
+ * entry_filter with operator|, and a filter only runs as the view is iterated, so a query such as:
+ *
+ *   pak_entries(reader)
+ *       | entry_filter([](const pakentry_t& e) { return e.has_extension(u8".dds"); })
+ *       | entry_filter([](const pakentry_t& e) { return e.file_size() > 1024 * 1024; })
+ *
+ * only reads the file size of the .dds entries. Views can be passed straight to extract_view, which hands the
+ * selected entries to the extraction workers. The iterators are forward iterators with default construction and
+ * the usual member types, so the views also satisfy std::ranges::forward_range when built as C++20.
+ */
+#ifndef DEPAK_ENTRYVIEW_H_INCLUDED
+#define DEPAK_ENTRYVIEW_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "extract.h"
+#include "pakreader.h"
+
+/**
+ * PAK Entry Handle
+ *
+ * A file entry of a reader, as seen through a view. The table values are read from the reader directly; the
+ * decoded size and chunk count live in the file data and are read on first use.
+ */
+struct pakentry_t
+{
+    pakentry_t(void);
+    pakentry_t(pakreader_t* reader, const std::size_t index);
+
+    pakreader_t* reader(void) const;
+    std::size_t index(void) const;
+    const pakfileentry_t& entry(void) const;
+
+    uint32_t crc(void) const;
+    uint32_t position(void) const;
+    uint64_t offset(void) const;
+    uint32_t stored_size(void) const;
+    const char* name(void) const;
+    bool has_extension(const char* ext) const;
+
+    uint64_t file_size(void) const;
+    uint32_t chunk_count(void) const;
+
+private:
+    void layout(void) const;
+
+    pakreader_t* m_Reader;
+    std::size_t m_Index;
+    mutable uint64_t m_FileSize;
+    mutable uint32_t m_Chunks;
+    mutable bool m_Layout;
+};
+
+/**
+ * PAK Entry View
+ *
+ * Every file entry of a reader, in position order.
+ */
+struct pakentryview_t
+{
+    struct iterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = pakentry_t;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = pakentry_t;
+
+        iterator(void)
+            : m_Reader(nullptr)
+            , m_Index(0)
+        {}
+        iterator(pakreader_t* reader, const std::size_t index)
+            : m_Reader(reader)
+            , m_Index(index)
+        {}
+
+        pakentry_t operator*(void) const { return pakentry_t(m_Reader, m_Index); }
+        iterator& operator++(void)
+        {
+            m_Index++;
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            auto it = *this;
+            m_Index++;
+            return it;
+        }
+        bool operator==(const iterator& other) const { return m_Index == other.m_Index; }
+        bool operator!=(const iterator& other) const { return m_Index != other.m_Index; }
+
+    private:
+        pakreader_t* m_Reader;
+        std::size_t m_Index;
+    };
+
+    explicit pakentryview_t(pakreader_t* reader)
+        : m_Reader(reader)
+    {}
+
+    iterator begin(void) const { return iterator(m_Reader, 0); }
+    iterator end(void) const { return iterator(m_Reader, pak_entry_count(m_Reader)); }
+    std::size_t size(void) const { return pak_entry_count(m_Reader); }
+
+private:
+    pakreader_t* m_Reader;
+};
+
+/**
+ * PAK Filter View
+ *
+ * The entries of another view that match a predicate. The predicate runs while the view is iterated.
+ */
+template <typename View, typename Predicate>
+struct pakfilterview_t
+{
+    struct iterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = pakentry_t;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = pakentry_t;
+        using base_t            = decltype(std::declval<const View&>().begin());
+
+        iterator(void)
+            : m_Iter()
+            , m_End()
+            , m_Predicate(nullptr)
+            , m_Current()
+        {}
+        iterator(const base_t iter, const base_t end, const Predicate* predicate)
+            : m_Iter(iter)
+            , m_End(end)
+            , m_Predicate(predicate)
+            , m_Current()
+        {
+            seek();
+        }
+
+        pakentry_t operator*(void) const { return m_Current; }
+        iterator& operator++(void)
+        {
+            ++m_Iter;
+            seek();
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const iterator& other) const { return m_Iter == other.m_Iter; }
+        bool operator!=(const iterator& other) const { return m_Iter != other.m_Iter; }
+
+    private:
+        // Steps forward to the next matching entry; the match is kept so the values it read stay cached..
+        void seek(void)
+        {
+            for (; m_Iter != m_End; ++m_Iter)
+            {
+                m_Current = *m_Iter;
+                if ((*m_Predicate)(static_cast<const pakentry_t&>(m_Current)))
+                    return;
+            }
+        }
+
+        base_t m_Iter;
+        base_t m_End;
+        const Predicate* m_Predicate;
+        pakentry_t m_Current;
+    };
+
+    pakfilterview_t(View view, Predicate predicate)
+        : m_View(std::move(view))
+        , m_Predicate(std::move(predicate))
+    {}
+
+    iterator begin(void) const { return iterator(m_View.begin(), m_View.end(), &m_Predicate); }
+    iterator end(void) const { return iterator(m_View.end(), m_View.end(), &m_Predicate); }
+
+private:
+    View m_View;
+    Predicate m_Predicate;
+};
+
+/**
+ * PAK Filter Adaptor
+ *
+ * Holds a predicate until it is applied to a view with operator|.
+ */
+template <typename Func>
+struct pakfilter_t
+{
+    Func Predicate; // Called with a const pakentry_t&; returns true to keep the entry.
+};
+
+/**
+ * Returns a view over every file entry of a reader, in position order.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {pakentryview_t} The view.
+ */
+inline pakentryview_t pak_entries(pakreader_t* reader)
+{
+    return pakentryview_t(reader);
+}
+
+/**
+ * Returns a filter adaptor to apply to a view with operator|.
+ *
+ * @param {Predicate} predicate - Called with a const pakentry_t&; returns true to keep the entry.
+ * @return {pakfilter_t<Predicate>} The adaptor.
+ */
+template <typename Predicate>
+pakfilter_t<Predicate> entry_filter(Predicate predicate)
+{
+    return pakfilter_t<Predicate>{std::move(predicate)};
+}
+
+/**
+ * Applies a filter adaptor to a view.
+ */
+template <typename Predicate>
+pakfilterview_t<pakentryview_t, Predicate> operator|(pakentryview_t view, pakfilter_t<Predicate> filter)
+{
+    return pakfilterview_t<pakentryview_t, Predicate>(std::move(view), std::move(filter.Predicate));
+}
+
+/**
+ * Applies a filter adaptor to a filtered view.
+ */
+template <typename View, typename Inner, typename Predicate>
+pakfilterview_t<pakfilterview_t<View, Inner>, Predicate> operator|(pakfilterview_t<View, Inner> view, pakfilter_t<Predicate> filter)
+{
+    return pakfilterview_t<pakfilterview_t<View, Inner>, Predicate>(std::move(view), std::move(filter.Predicate));
+}
+
+/**
+ * Extracts the entries of a view with the extraction workers.
+ *
+ * The workers split their work by index, so the selected entries are gathered into the one list they are handed;
+ * nothing else is copied.
+ *
+ * @param {pakreader_t*} reader - The reader the view was made from.
+ * @param {View&} view - The view of the entries to extract.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+template <typename View>
+bool extract_view(pakreader_t* reader, const View& view, const extractoptions_t& opts, extractresult_t& result)
+{
+    std::vector<pakfileentry_t> entries;
+    std::vector<std::string> names;
+    for (const auto& e : view)
+    {
+        std::string name;
+        if (!pak_entry_output_name(reader, e.index(), name))
+            continue;
+
+        entries.push_back(e.entry());
+        names.push_back(std::move(name));
+    }
+
+    return extract_entries(pak_path(reader), pak_header(reader), entries, names, opts, result);
+}
+
+#endif // DEPAK_ENTRYVIEW_H_INCLUDED
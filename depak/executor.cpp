@@ -0,0 +1,268 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * The executor interface the extraction engine runs its parallel work on, and the default work-stealing pool.
+ */
+#include <algorithm>
+
+#include "executor.h"
+
+/**
+ * The pool and queue of the current thread when it is a pool thread.
+ */
+static thread_local const workpool_t* t_Pool = nullptr;
+static thread_local std::size_t t_Queue      = 0;
+
+/**
+ * Queues count tasks at once; task is called once with each index in [0, count). (Submits one at a time by default.)
+ *
+ * @param {std::size_t} count - The count of tasks.
+ * @param {std::function<void(std::size_t)>} task - The task.
+ */
+void executor_t::bulk_submit(const std::size_t count, std::function<void(std::size_t)> task)
+{
+    const auto shared = std::make_shared<std::function<void(std::size_t)>>(std::move(task));
+    for (std::size_t x = 0; x < count; x++)
+        submit([shared, x]() { (*shared)(x); });
+}
+
+/**
+ * Constructor and Destructor
+ *
+ * @param {uint32_t} threads - The count of pool threads. (At least one.)
+ */
+workpool_t::workpool_t(const uint32_t threads)
+    : m_Pending(0)
+    , m_Next(0)
+    , m_Stop(false)
+{
+    const auto count = std::max(1u, threads);
+    for (uint32_t x = 0; x < count; x++)
+        m_Queues.push_back(std::make_unique<queue_t>());
+
+    m_Threads.reserve(count);
+    for (uint32_t x = 0; x < count; x++)
+        m_Threads.emplace_back([this, x]() { this->run(x); });
+}
+workpool_t::~workpool_t(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Condition.notify_all();
+
+    for (auto& t : m_Threads)
+        t.join();
+}
+
+/**
+ * Queues a task; on the current threads own queue when called from a pool thread.
+ *
+ * @param {std::function<void(void)>} task - The task.
+ */
+void workpool_t::submit(std::function<void(void)> task)
+{
+    if (t_Pool == this)
+        this->push(t_Queue, std::move(task), true);
+    else
+        this->push(m_Next.fetch_add(1, std::memory_order_relaxed) % m_Queues.size(), std::move(task), false);
+
+    m_Condition.notify_one();
+}
+
+/**
+ * Queues count tasks at once, spread evenly over the queues.
+ *
+ * @param {std::size_t} count - The count of tasks.
+ * @param {std::function<void(std::size_t)>} task - The task.
+ */
+void workpool_t::bulk_submit(const std::size_t count, std::function<void(std::size_t)> task)
+{
+    if (count == 0)
+        return;
+
+    const auto shared = std::make_shared<std::function<void(std::size_t)>>(std::move(task));
+    const auto first  = t_Pool == this ? t_Queue : m_Next.fetch_add(count, std::memory_order_relaxed);
+    for (std::size_t x = 0; x < count; x++)
+        this->push((first + x) % m_Queues.size(), [shared, x]() { (*shared)(x); }, false);
+
+    if (count == 1)
+        m_Condition.notify_one();
+    else
+        m_Condition.notify_all();
+}
+
+/**
+ * Returns the count of pool threads.
+ *
+ * @return {uint32_t} The concurrency.
+ */
+uint32_t workpool_t::concurrency(void) const
+{
+    return (uint32_t)m_Threads.size();
+}
+
+/**
+ * Adds a task to a queue.
+ *
+ * @param {std::size_t} queue - The queue index.
+ * @param {std::function<void(void)>} task - The task.
+ * @param {bool} front - Flag if the task is run before the others. (Tasks of the queues own thread.)
+ */
+void workpool_t::push(const std::size_t queue, std::function<void(void)> task, const bool front)
+{
+    auto& q = *m_Queues[queue];
+    {
+        std::lock_guard<std::mutex> lock(q.Mutex);
+        if (front)
+            q.Tasks.push_front(std::move(task));
+        else
+            q.Tasks.push_back(std::move(task));
+    }
+
+    // Counted under the pool lock so a thread about to sleep cannot miss it..
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Pending.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Takes the next task; from the front of the threads own queue, otherwise from the back of another.
+ *
+ * @param {std::size_t} self - The queue index of the thread.
+ * @param {std::function<void(void)>&} task - The task taken.
+ * @return {bool} True if a task was taken, false if every queue is empty.
+ */
+bool workpool_t::take(const std::size_t self, std::function<void(void)>& task)
+{
+    for (std::size_t x = 0; x < m_Queues.size(); x++)
+    {
+        const auto index = (self + x) % m_Queues.size();
+        auto& q          = *m_Queues[index];
+
+        std::lock_guard<std::mutex> lock(q.Mutex);
+        if (q.Tasks.empty())
+            continue;
+
+        if (index == self)
+        {
+            task = std::move(q.Tasks.front());
+            q.Tasks.pop_front();
+        }
+        else
+        {
+            task = std::move(q.Tasks.back());
+            q.Tasks.pop_back();
+        }
+
+        m_Pending.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Runs tasks until the pool is destroyed.
+ *
+ * @param {std::size_t} self - The queue index of the thread.
+ */
+void workpool_t::run(const std::size_t self)
+{
+    t_Pool  = this;
+    t_Queue = self;
+
+    std::function<void(void)> task;
+    for (;;)
+    {
+        if (this->take(self, task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock, [this]() { return m_Stop || m_Pending.load(std::memory_order_relaxed) > 0; });
+        if (m_Stop && m_Pending.load(std::memory_order_relaxed) == 0)
+            break;
+    }
+}
+
+/**
+ * Shared state of an executor_parallel_for call.
+ */
+struct executorloop_t
+{
+    std::atomic<std::size_t> Next;                 // The next index to claim.
+    std::size_t Count;                             // The count of indexes.
+    const std::function<void(std::size_t)>* Fn;    // The function. (Only used while indexes are left to claim.)
+    std::mutex Mutex;                              // The completion lock.
+    std::condition_variable Condition;             // Signalled when the last index completes.
+    std::size_t Done;                              // The count of completed indexes.
+};
+
+/**
+ * Claims and runs indexes of a loop until none are left.
+ *
+ * @param {executorloop_t&} loop - The loop.
+ */
+static void executor_loop_run(executorloop_t& loop)
+{
+    std::size_t done = 0;
+    for (;;)
+    {
+        const auto index = loop.Next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= loop.Count)
+            break;
+
+        (*loop.Fn)(index);
+        done++;
+    }
+
+    if (done == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(loop.Mutex);
+    loop.Done += done;
+    if (loop.Done == loop.Count)
+        loop.Condition.notify_all();
+}
+
+/**
+ * Calls fn once with each index in [0, count) on an executor and waits for all of them.
+ *
+ * @param {executor_t*} executor - The executor. (nullptr runs every index on the calling thread.)
+ * @param {std::size_t} count - The count of indexes.
+ * @param {std::function<void(std::size_t)>&} fn - The function to call with each index.
+ * @param {bool} participate - Flag if the calling thread claims indexes too.
+ */
+void executor_parallel_for(executor_t* executor, const std::size_t count, const std::function<void(std::size_t)>& fn, const bool participate)
+{
+    if (count == 0)
+        return;
+
+    if (executor == nullptr || (participate && count == 1))
+    {
+        for (std::size_t x = 0; x < count; x++)
+            fn(x);
+        return;
+    }
+
+    // Tasks that start after every index was claimed find nothing to do, so the loop state is shared with them..
+    const auto loop = std::make_shared<executorloop_t>();
+    loop->Next      = 0;
+    loop->Count     = count;
+    loop->Fn        = &fn;
+    loop->Done      = 0;
+
+    const auto helpers = participate ? std::min<std::size_t>(count, executor->concurrency()) - 1 : std::min<std::size_t>(count, executor->concurrency());
+    if (helpers > 0)
+        executor->bulk_submit(helpers, [loop](std::size_t) { executor_loop_run(*loop); });
+
+    if (participate)
+        executor_loop_run(*loop);
+
+    std::unique_lock<std::mutex> lock(loop->Mutex);
+    loop->Condition.wait(lock, [&loop]() { return loop->Done == loop->Count; });
+}
@@ -0,0 +1,109 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * The executor interface the extraction engine runs its parallel work on, and the default work-stealing pool.
+ *
+ * Programs embedding the extractor can pass their own executor in extractoptions_t.Executor, so the file workers and
+ * the parallel chunk decoding of large files run on the host's threads instead of threads of their own.
+ */
+#ifndef DEPAK_EXECUTOR_H_INCLUDED
+#define DEPAK_EXECUTOR_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Executor Interface
+ *
+ * Runs tasks on some set of threads. Tasks may submit further tasks and must not block waiting on tasks they
+ * submitted; executor_parallel_for is the way to wait, since it runs the work itself when no thread picks it up.
+ */
+struct executor_t
+{
+    virtual ~executor_t(void) = default;
+
+    /**
+     * Queues a task.
+     *
+     * @param {std::function<void(void)>} task - The task.
+     */
+    virtual void submit(std::function<void(void)> task) = 0;
+
+    /**
+     * Queues count tasks at once; task is called once with each index in [0, count). (Submits one at a time by default.)
+     *
+     * @param {std::size_t} count - The count of tasks.
+     * @param {std::function<void(std::size_t)>} task - The task.
+     */
+    virtual void bulk_submit(const std::size_t count, std::function<void(std::size_t)> task);
+
+    /**
+     * Returns the count of tasks the executor runs at once.
+     *
+     * @return {uint32_t} The concurrency.
+     */
+    virtual uint32_t concurrency(void) const = 0;
+};
+
+/**
+ * Work-Stealing Pool
+ *
+ * The default executor. Each thread has its own queue; tasks submitted from a pool thread go to the front of its own
+ * queue and are run newest first while they are still in cache, other tasks are spread over the queues, and a thread
+ * whose queue is empty steals the oldest task of another.
+ */
+struct workpool_t final : executor_t
+{
+    explicit workpool_t(const uint32_t threads);
+    ~workpool_t(void) override;
+
+    workpool_t(const workpool_t&) = delete;
+    workpool_t& operator=(const workpool_t&) = delete;
+
+    void submit(std::function<void(void)> task) override;
+    void bulk_submit(const std::size_t count, std::function<void(std::size_t)> task) override;
+    uint32_t concurrency(void) const override;
+
+private:
+    struct queue_t
+    {
+        std::mutex Mutex;                             // The queue lock.
+        std::deque<std::function<void(void)>> Tasks; // The queued tasks.
+    };
+
+    void push(const std::size_t queue, std::function<void(void)> task, const bool front);
+    bool take(const std::size_t self, std::function<void(void)>& task);
+    void run(const std::size_t self);
+
+    std::vector<std::unique_ptr<queue_t>> m_Queues;
+    std::vector<std::thread> m_Threads;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::atomic<std::size_t> m_Pending;
+    std::atomic<std::size_t> m_Next;
+    bool m_Stop;
+};
+
+/**
+ * Calls fn once with each index in [0, count) on an executor and waits for all of them.
+ *
+ * Indexes are claimed one at a time by up to count tasks submitted to the executor and, when participate is set, by
+ * the calling thread, so the call finishes even if the executor never gets to the tasks. (A busy host pool, or a call
+ * from inside a task of the same executor.)
+ *
+ * @param {executor_t*} executor - The executor. (nullptr runs every index on the calling thread.)
+ * @param {std::size_t} count - The count of indexes.
+ * @param {std::function<void(std::size_t)>&} fn - The function to call with each index.
+ * @param {bool} participate - Flag if the calling thread claims indexes too.
+ */
+void executor_parallel_for(executor_t* executor, const std::size_t count, const std::function<void(std::size_t)>& fn, const bool participate = true);
+
+#endif // DEPAK_EXECUTOR_H_INCLUDED
@@ -0,0 +1,931 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * The file extraction engine. (Worker threads, I/O backends and output sinks.)
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "bufferpool.h"
+#include "extract.h"
+#include "filemap.h"
+#include "latency.h"
+#include "logger.h"
+#include "memstats.h"
+#include "metrics.h"
+#include "numa.h"
+#include "stats.h"
+#include "trace.h"
+
+/**
+ * Extraction Memory Budget Structure
+ *
+ * The bytes of file data shared by all workers. A worker reserves the bytes of each window it reads and decodes,
+ * and waits while the budget is used up by the others.
+ */
+struct extractbudget_t
+{
+    std::mutex Mutex;                  // The budget lock.
+    std::condition_variable Condition; // Signalled when bytes are returned to the budget.
+    uint64_t Total;                    // The size of the budget.
+    uint64_t Held;                     // The bytes currently reserved.
+    uint64_t Peak;                     // The most bytes reserved at once.
+};
+
+/**
+ * Extraction Budget Reservation Structure
+ *
+ * Reserves bytes of a memory budget for the lifetime of the scope. (Does nothing without a budget.)
+ *
+ * A reservation larger than the whole budget waits until nothing else is held and then holds the budget alone, so it
+ * never waits forever; its real size is still counted so the peak reports what was actually held.
+ */
+struct extractreservation_t
+{
+    extractreservation_t(extractbudget_t* budget, const uint64_t bytes)
+        : m_Budget(budget)
+        , m_Bytes(0)
+    {
+        if (m_Budget == nullptr)
+            return;
+
+        std::unique_lock<std::mutex> lock(m_Budget->Mutex);
+        m_Bytes = bytes;
+        m_Budget->Condition.wait(lock, [this]() { return m_Budget->Held == 0 || m_Budget->Held + m_Bytes <= m_Budget->Total; });
+        m_Budget->Held += m_Bytes;
+        m_Budget->Peak = std::max(m_Budget->Peak, m_Budget->Held);
+    }
+    ~extractreservation_t(void)
+    {
+        if (m_Budget == nullptr)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Budget->Mutex);
+            m_Budget->Held -= m_Bytes;
+        }
+        m_Budget->Condition.notify_all();
+    }
+
+    extractreservation_t(const extractreservation_t&) = delete;
+    extractreservation_t& operator=(const extractreservation_t&) = delete;
+
+private:
+    extractbudget_t* m_Budget;
+    uint64_t m_Bytes;
+};
+
+/**
+ * Extraction File Status Enumeration
+ *
+ */
+enum class ExtractFile
+{
+    Saved,   // The file was extracted.
+    Skipped, // The file was dropped by a post-process hook.
+    Failed,  // The file failed to extract.
+};
+
+/**
+ * Extraction Range Structure
+ *
+ * A contiguous run of the position sorted entries, handed out front to back.
+ */
+struct extractrange_t
+{
+    std::atomic<std::size_t> Next; // The index of the next entry to extract.
+    std::size_t End;               // The index one past the last entry of the range.
+};
+
+/**
+ * Extraction Worker Structure
+ *
+ * The per-thread state of a worker; the buffers are reused for every file the worker extracts, so once the
+ * largest file has been seen extraction runs without heap allocations.
+ */
+struct extractworker_t
+{
+    FILE* File;                                  // The workers own PAK file handle. (stdio backend.)
+    const filemap_t* Map;                        // The shared PAK file mapping. (mmap backend.)
+    std::vector<uint32_t> ChunkSizes;            // The compressed size of each chunk of the current file.
+    bufferpool_t Pool;                           // The compressed (stdio backend) and decompressed data buffers.
+    extractbudget_t* Budget;                     // The shared memory budget. (nullptr when unbounded.)
+    std::size_t Window;                          // The most chunks read and decoded before they are written out.
+    executor_t* Executor;                        // The executor windows of many chunks are decoded on. (nullptr decodes on the worker.)
+    std::vector<std::size_t> Parts;              // The decoded size of each part of a window decoded on the executor. (SIZE_MAX when it failed.)
+    const numanode_t* Node;                      // The NUMA node the worker is pinned to. (nullptr when not pinned.)
+    std::size_t Range;                           // The entry range the worker takes from after the priority range.
+    bool Pinned;                                 // Flag if the worker was pinned to its node.
+    std::atomic<std::size_t>* Left;              // The count of priority entries not extracted yet.
+    std::chrono::steady_clock::time_point Start; // The time extraction started.
+    extractresult_t Result;                      // The workers share of the result.
+};
+
+/**
+ * Returns the default extraction options. (One thread, stdio, written to the 'dump' directory.)
+ *
+ * @return {extractoptions_t} The default options.
+ */
+extractoptions_t extract_default_options(void)
+{
+    extractoptions_t opts{};
+    opts.Threads     = 1;
+    opts.Io          = ExtractIo::Stdio;
+    opts.Sink        = ExtractSink::File;
+    opts.OutputDir   = u8"dump";
+    opts.SpillMemory = EXTRACT_SPILL_MEMORY;
+    opts.SpillDir    = u8".";
+    return opts;
+}
+
+/**
+ * Parses an I/O backend name.
+ *
+ * @param {char*} value - The backend name. (stdio or mmap)
+ * @param {ExtractIo&} io - The value to receive the backend.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_parse_io(const char* value, ExtractIo& io)
+{
+    if (::strcmp(value, u8"stdio") == 0)
+        io = ExtractIo::Stdio;
+    else if (::strcmp(value, u8"mmap") == 0)
+        io = ExtractIo::Mmap;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Parses an output sink name.
+ *
+ * @param {char*} value - The sink name. (file or null)
+ * @param {ExtractSink&} sink - The value to receive the sink.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_parse_sink(const char* value, ExtractSink& sink)
+{
+    if (::strcmp(value, u8"file") == 0)
+        sink = ExtractSink::File;
+    else if (::strcmp(value, u8"null") == 0)
+        sink = ExtractSink::Null;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Returns the name of an I/O backend.
+ *
+ * @param {ExtractIo} io - The backend.
+ * @return {char*} The backend name.
+ */
+const char* extract_io_name(const ExtractIo io)
+{
+    return io == ExtractIo::Mmap ? u8"mmap" : u8"stdio";
+}
+
+/**
+ * Returns the name of an output sink.
+ *
+ * @param {ExtractSink} sink - The sink.
+ * @return {char*} The sink name.
+ */
+const char* extract_sink_name(const ExtractSink sink)
+{
+    return sink == ExtractSink::Null ? u8"null" : u8"file";
+}
+
+/**
+ * Resolves the output name of each file entry; entries without a name are given a numbered unknown file name.
+ *
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries.
+ * @param {std::vector<std::tuple<uint32_t, std::string>>&} strings - The string table entries.
+ * @param {std::vector<std::string>&} names - The vector to receive the name of each entry.
+ */
+void extract_resolve_names(const std::vector<pakfileentry_t>& entries, const std::vector<std::tuple<uint32_t, std::string>>& strings, std::vector<std::string>& names)
+{
+    statscope_t scope(StatPhase::Names);
+
+    names.clear();
+    names.reserve(entries.size());
+
+    // Index the string table by file id; a linear search per entry is quadratic on large tables..
+    std::unordered_map<uint32_t, std::size_t> index;
+    pak_index_names(strings, index);
+
+    std::size_t unknownFileCount = 0;
+    for (const auto& e : entries)
+    {
+        // Obtain the files name if available..
+        const auto sentry = index.find(e.Crc);
+        if (sentry != index.end() && !std::get<1>(strings[sentry->second]).empty())
+        {
+            names.push_back(std::get<1>(strings[sentry->second]));
+            continue;
+        }
+
+        // Construct an invalid file name if one was not found..
+        char fileName[MAX_PATH]{};
+        sprintf_s(fileName, u8"%08X.unknown_file", (uint32_t)unknownFileCount);
+        names.push_back(fileName);
+
+        unknownFileCount++;
+    }
+}
+
+/**
+ * Decompresses a window of chunks into the given buffer.
+ *
+ * Windows of many chunks are split into parts decoded in parallel on the workers executor. Every chunk but the last
+ * of a file decodes to a whole PAK_CHUNK_SIZE, so each part decodes straight to where its data belongs; a part that
+ * decodes short of that, like a damaged chunk in any part, fails the window.
+ *
+ * @param {extractworker_t&} w - The worker.
+ * @param {uint32_t*} chunkSizes - The compressed size of each chunk.
+ * @param {std::size_t} count - The count of chunks.
+ * @param {uint8_t*} chunkData - The compressed chunk data.
+ * @param {uint8_t*} fileData - The buffer to receive the decompressed data. (Must hold PAK_CHUNK_SIZE bytes per chunk.)
+ * @param {std::size_t&} size - The value to receive the size of the decompressed data.
+ * @return {bool} True on success, false if a chunk is damaged.
+ */
+static bool extract_decode(extractworker_t& w, const uint32_t* chunkSizes, const std::size_t count, const uint8_t* chunkData, uint8_t* fileData, std::size_t& size)
+{
+    const auto parts = w.Executor == nullptr ? 1 : std::min<std::size_t>(w.Executor->concurrency(), count / EXTRACT_DECODE_PART);
+    if (parts < 2)
+        return pak_decode_chunks(chunkSizes, count, chunkData, fileData, size);
+
+    w.Parts.assign(parts, SIZE_MAX);
+    executor_parallel_for(w.Executor, parts, [&w, chunkSizes, count, chunkData, fileData, parts](const std::size_t p) {
+        const auto first = count * p / parts;
+        const auto last  = count * (p + 1) / parts;
+        const auto pos   = std::accumulate(chunkSizes, chunkSizes + first, (uint64_t)0);
+
+        std::size_t decoded = 0;
+        if (pak_decode_chunks(chunkSizes + first, last - first, chunkData + pos, fileData + first * PAK_CHUNK_SIZE, decoded))
+            w.Parts[p] = decoded;
+    });
+
+    size = 0;
+    for (std::size_t p = 0; p < parts; p++)
+    {
+        if (w.Parts[p] == SIZE_MAX || (p + 1 < parts && w.Parts[p] != (count * (p + 1) / parts - count * p / parts) * PAK_CHUNK_SIZE))
+            return false;
+        size += w.Parts[p];
+    }
+    return true;
+}
+
+/**
+ * Frees the pool buffers a hooked file grew past the size of a regular window, while its reservation still holds
+ * them in the memory budget; otherwise every worker would keep the largest hooked file it saw outside of the budget.
+ *
+ * @param {extractworker_t&} w - The worker.
+ * @param {bool} hooked - Flag if the current file is taken by a post-process hook.
+ */
+static void extract_trim(extractworker_t& w, const bool hooked)
+{
+    if (hooked && w.Budget != nullptr)
+        pool_trim(w.Pool, w.Window * PAK_CHUNK_SIZE);
+}
+
+/**
+ * Extracts a single file entry.
+ *
+ * The chunks are read, decoded and written in windows of at most w.Window chunks, so without a memory budget a
+ * file is handled in one go and with one only a window of it is held in memory at a time. Files taken by a
+ * post-process hook are always decoded whole and handed to the hooks before they are written; under a memory budget
+ * they reserve their whole size, waiting for the budget to drain when it is larger than the budget.
+ *
+ * @param {extractworker_t&} w - The worker.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {pakfileentry_t&} e - The file entry.
+ * @param {std::string&} name - The output name of the entry.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @return {ExtractFile} The status of the file.
+ */
+static ExtractFile extract_file(extractworker_t& w, const pakheader_t* header, const pakfileentry_t& e, const std::string& name, const extractoptions_t& opts)
+{
+    const auto offset = (uint64_t)e.Position * header->Unknown00;
+
+    // Read the chunk sizes table..
+    const uint8_t* mapped = nullptr;
+    uint32_t entrySize    = 0;
+    bool valid            = false;
+    if (opts.Io == ExtractIo::Mmap)
+        valid = pak_map_chunks(w.Map->Data, w.Map->Size, offset, entrySize, w.ChunkSizes, mapped);
+    else
+    {
+        statscope_t scope(StatPhase::Read);
+        valid = pak_read_chunk_table(w.File, offset, entrySize, w.ChunkSizes);
+    }
+
+    if (!valid)
+    {
+        log_error(u8"[!] Error: Failed to read file data: %s\r\n", name.c_str());
+        return ExtractFile::Failed;
+    }
+
+    // Files without chunks have nothing to save..
+    if (w.ChunkSizes.empty())
+        return ExtractFile::Saved;
+
+    char filePath[MAX_PATH]{};
+    if (opts.Sink == ExtractSink::File)
+        sprintf_s(filePath, u8"%s//%s", opts.OutputDir.c_str(), name.c_str());
+
+    FILE* out           = nullptr;
+    uint64_t packed     = 0;
+    uint64_t unpacked   = 0;
+    uint64_t written    = 0;
+    const auto count    = w.ChunkSizes.size();
+    const auto hooked   = !opts.Post.empty() && post_accepts(opts.Post, name.c_str());
+    const auto window   = hooked ? count : w.Window;
+    const auto finished = [&](ExtractFile status) -> ExtractFile {
+        extract_trim(w, hooked);
+        if (out != nullptr)
+        {
+            statscope_t scope(StatPhase::Write);
+
+            // Buffered data is written out on close, so a failed close fails the file too..
+            if (fclose(out) != 0 && status == ExtractFile::Saved)
+            {
+                log_error(u8"[!] Error: Failed to write file: %s\r\n", filePath);
+                status = ExtractFile::Failed;
+            }
+
+            // Do not leave a partially streamed file behind..
+            if (status == ExtractFile::Failed)
+                std::remove(filePath);
+        }
+        return status;
+    };
+
+    for (std::size_t x = 0; x < count;)
+    {
+        const auto chunks = std::min(window, count - x);
+        const auto size   = std::accumulate(w.ChunkSizes.begin() + x, w.ChunkSizes.begin() + x + chunks, (uint64_t)0);
+
+        // Hold the windows bytes in the budget until they are written out; a hooked file reserves its whole size..
+        extractreservation_t reservation(w.Budget, (opts.Io == ExtractIo::Mmap ? 0 : size) + chunks * PAK_CHUNK_SIZE);
+
+        // Read the compressed data chunks..
+        const uint8_t* chunkData = nullptr;
+        if (opts.Io == ExtractIo::Mmap)
+            chunkData = mapped + packed;
+        else
+        {
+            statscope_t scope(StatPhase::Read);
+            scope.bytes(size);
+
+            const auto data = pool_acquire(w.Pool, PoolBuffer::Compressed, (std::size_t)size);
+            if (size > 0 && fread(data, 1, (std::size_t)size, w.File) != size)
+            {
+                log_error(u8"[!] Error: Failed to read file data: %s\r\n", name.c_str());
+                return finished(ExtractFile::Failed);
+            }
+            chunkData = data;
+        }
+
+        // Decompress the chunks; a window before the last must decode whole and the file must decode to its size..
+        const auto capacity     = chunks * PAK_CHUNK_SIZE;
+        const uint8_t* fileData = pool_acquire(w.Pool, PoolBuffer::Decoded, capacity);
+        std::size_t decoded     = 0;
+        if (!extract_decode(w, w.ChunkSizes.data() + x, chunks, chunkData, (uint8_t*)fileData, decoded) || (x + chunks < count ? decoded != capacity : unpacked + decoded != entrySize))
+        {
+            log_error(u8"[!] Error: Failed to decompress file data: %s\r\n", name.c_str());
+            return finished(ExtractFile::Failed);
+        }
+
+        auto fileSize = (uint64_t)decoded;
+        unpacked += decoded;
+
+        // Run the post-process hooks while the decoded data is still in cache..
+        if (hooked)
+        {
+            statscope_t scope(StatPhase::Post);
+
+            depak_postbuffer_t buffer{name.c_str(), (uint8_t*)fileData, fileSize, capacity};
+            const auto ret = post_run(opts.Post, buffer);
+            if (ret == DEPAK_POST_ERROR)
+            {
+                log_error(u8"[!] Error: A post-process hook failed on file: %s\r\n", name.c_str());
+                return finished(ExtractFile::Failed);
+            }
+            if (ret == DEPAK_POST_SKIP)
+            {
+                log_verbose(u8"[!] Info: Skipped by a post-process hook: %s\r\n", name.c_str());
+                return finished(ExtractFile::Skipped);
+            }
+
+            fileData = buffer.Data;
+            fileSize = buffer.Size;
+        }
+
+        // Save the decompressed data..
+        statscope_t scope(StatPhase::Write);
+        scope.bytes(fileSize);
+
+        if (opts.Sink == ExtractSink::File)
+        {
+            if (out == nullptr && fopen_s(&out, filePath, u8"wb") != ERROR_SUCCESS)
+            {
+                log_error(u8"[!] Error: Failed to dump file: %s\r\n", filePath);
+                return finished(ExtractFile::Failed);
+            }
+
+            // A short write (a full disk) fails the file instead of leaving it truncated..
+            if (fileSize > 0 && fwrite(fileData, (std::size_t)fileSize, 1, out) != 1)
+            {
+                log_error(u8"[!] Error: Failed to write file: %s\r\n", filePath);
+                return finished(ExtractFile::Failed);
+            }
+        }
+
+        packed += size;
+        written += fileSize;
+        x += chunks;
+
+        extract_trim(w, hooked);
+    }
+
+    const auto status = finished(ExtractFile::Saved);
+    if (status != ExtractFile::Saved)
+        return status;
+
+    const auto bytesIn = count * 4 + 8 + packed;
+    stats_add_file(bytesIn, written);
+
+    w.Result.BytesIn += bytesIn;
+    w.Result.BytesOut += written;
+    return status;
+}
+
+/**
+ * Takes the next entry to extract; from the priority range first, then from the workers own range and then from the
+ * others.
+ *
+ * @param {extractworker_t&} w - The worker.
+ * @param {std::vector<extractrange_t>&} ranges - The entry ranges. (The priority range first.)
+ * @param {std::size_t&} index - The value to receive the entry index.
+ * @return {bool} True if an entry was taken, false if none are left.
+ */
+static bool extract_take(extractworker_t& w, std::vector<extractrange_t>& ranges, std::size_t& index)
+{
+    const auto groups = ranges.size() - 1;
+    for (std::size_t x = 0; x < ranges.size(); x++)
+    {
+        auto& range = x == 0 ? ranges[0] : ranges[1 + (w.Range - 1 + x - 1) % groups];
+        if (range.Next.load(std::memory_order_relaxed) >= range.End)
+            continue;
+
+        index = range.Next.fetch_add(1, std::memory_order_relaxed);
+        if (index < range.End)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Extracts entries until none are left.
+ *
+ * @param {extractworker_t&} w - The worker.
+ * @param {std::vector<extractrange_t>&} ranges - The entry ranges.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries to extract.
+ * @param {std::vector<std::string>&} names - The output name of each entry.
+ * @param {extractoptions_t&} opts - The extraction options.
+ */
+static void extract_worker(extractworker_t& w, std::vector<extractrange_t>& ranges, const pakheader_t* header, const std::vector<pakfileentry_t>& entries, const std::vector<std::string>& names, const extractoptions_t& opts)
+{
+    metricsgauge_t active(MetricGauge::ActiveWorkers);
+
+    // Pin the worker before it touches its buffers, so they are allocated on its own node..
+    if (w.Node != nullptr)
+        w.Pinned = numa_pin_thread(*w.Node);
+
+    for (;;)
+    {
+        // Entries are handed out in position order so the workers of a range read the file front to back together..
+        std::size_t x = 0;
+        if (!extract_take(w, ranges, x))
+            break;
+
+        if (metrics_enabled())
+        {
+            std::size_t queued = 0;
+            for (const auto& r : ranges)
+                queued += r.End - std::min(r.End, r.Next.load(std::memory_order_relaxed));
+            metrics_gauge_set(MetricGauge::QueueDepth, (int64_t)queued);
+        }
+
+        const auto& e    = entries[x];
+        const auto& name = names[x];
+        const auto begin = std::chrono::steady_clock::now();
+        const auto mem   = mem_snapshot();
+        const auto bytes = w.Result.BytesOut;
+        const auto read  = w.Result.BytesIn;
+
+        log_verbose(u8"[!] Info: Saving file: %s\r\n", name.c_str());
+
+        // Dump the file..
+        {
+            tracescope_t span(u8"file", name.c_str());
+            span.bytes(e.Size);
+
+            const auto status = extract_file(w, header, e, name, opts);
+            if (status == ExtractFile::Saved)
+                w.Result.Files++;
+            else if (status == ExtractFile::Skipped)
+                w.Result.Skipped++;
+            else
+            {
+                w.Result.Failures++;
+                metrics_add(MetricCounter::Errors, 1);
+            }
+        }
+
+        const auto written = w.Result.BytesOut - bytes;
+        // Report the moment the last priority entry is done; the rest continue in the background..
+        if (x < ranges[0].End && w.Left->fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            w.Result.PriorityReady = std::chrono::duration<double>(std::chrono::steady_clock::now() - w.Start).count();
+            log_info(u8"[!] Info: The %zu priority files are ready after %.3f s; continuing with the rest.\r\n", ranges[0].End, w.Result.PriorityReady);
+        }
+
+        metrics_add(MetricCounter::Files, 1);
+        metrics_add(MetricCounter::FileBytes, written);
+        metrics_add(MetricCounter::CompressedBytes, w.Result.BytesIn - read);
+        progress_add(1, written);
+        mem_add_file(mem);
+        latency_record_file((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count(), name.c_str(), written);
+    }
+}
+
+/**
+ * Extracts the given file entries of a PAK file, or of a PAK file held in memory.
+ *
+ * @param {char*} path - The PAK file path. (nullptr when extracting from memory.)
+ * @param {filemap_t*} image - The PAK file held in memory. (nullptr when extracting from the path.)
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries to extract.
+ * @param {std::vector<std::string>&} names - The output name of each entry.
+ * @param {std::size_t} priority - The count of leading entries extracted before the others.
+ * @param {extractoptions_t&} opts - The extraction options. (The mmap backend when extracting from memory.)
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True if the PAK file could be opened with the requested backend, false otherwise.
+ */
+static bool extract_run(const char* path, const filemap_t* image, const pakheader_t* header, const std::vector<pakfileentry_t>& entries, const std::vector<std::string>& names,
+    const std::size_t priority, const extractoptions_t& opts, extractresult_t& result)
+{
+    result = extractresult_t{};
+
+    auto threads = opts.Threads != 0 ? opts.Threads : opts.Executor != nullptr ? opts.Executor->concurrency() : std::thread::hardware_concurrency();
+    threads      = (uint32_t)std::max<std::size_t>(1, std::min<std::size_t>(threads, entries.size()));
+
+    // Open the PAK file for the requested backend..
+    filemap_t map{};
+    if (image != nullptr)
+        map = *image;
+    else if (opts.Io == ExtractIo::Mmap && !filemap_open(path, map, opts.Pages))
+    {
+        log_error(u8"[!] Error: Failed to map the PAK file into memory.\r\n");
+        return false;
+    }
+
+    // With a memory budget, files are streamed in windows small enough that every worker can hold one..
+    extractbudget_t budget{};
+    budget.Total = opts.MemoryBudget;
+
+    auto window = (std::size_t)-1;
+    if (opts.MemoryBudget > 0)
+        window = (std::size_t)std::max<uint64_t>(1, std::min(EXTRACT_STREAM_WINDOW, opts.MemoryBudget / threads / 2) / PAK_CHUNK_SIZE);
+
+    // The leading priority entries form a range every worker takes from first. With NUMA placement the workers are
+    // spread over the nodes and the other position sorted entries are split into one contiguous range per node, sized
+    // by the file data of the nodes share of the workers..
+    std::vector<numanode_t> nodes;
+    if (opts.Numa && opts.Executor != nullptr)
+        log_error(u8"[!] Warning: Workers running on a host executor are not pinned per NUMA node.\r\n");
+    else if (opts.Numa && !numa_nodes(nodes))
+        log_error(u8"[!] Warning: The NUMA topology could not be read; workers are not pinned.\r\n");
+
+    const auto groups = nodes.empty() ? 1 : std::min<std::size_t>(nodes.size(), threads);
+    std::vector<extractrange_t> ranges(1 + groups);
+    ranges[0].Next = 0;
+    ranges[0].End  = priority;
+    {
+        const auto total = std::accumulate(entries.begin() + priority, entries.end(), 0.0, [](const double sum, const pakfileentry_t& e) { return sum + e.Size; });
+
+        auto begin    = priority;
+        double size   = 0;
+        double target = 0;
+        for (std::size_t g = 0; g < groups; g++)
+        {
+            // Worker x belongs to group x % groups..
+            const auto share = threads / groups + (g < threads % groups ? 1 : 0);
+            target += total * (double)share / (double)threads;
+
+            auto end = begin;
+            while (end < entries.size() && (g + 1 == groups || size < target))
+                size += entries[end++].Size;
+
+            ranges[1 + g].Next = begin;
+            ranges[1 + g].End  = end;
+            begin              = end;
+        }
+    }
+
+    std::atomic<std::size_t> left{priority};
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<extractworker_t> workers(threads);
+    bool opened = true;
+    for (std::size_t x = 0; x < workers.size(); x++)
+    {
+        auto& w  = workers[x];
+        w.Map    = &map;
+        w.Budget = opts.MemoryBudget > 0 ? &budget : nullptr;
+        w.Window = window;
+        w.Range  = 1 + x % groups;
+        w.Left   = &left;
+        w.Start  = start;
+
+        w.Pool.Pages = opts.Pages;
+        if (!nodes.empty())
+        {
+            w.Node          = &nodes[w.Range - 1];
+            w.Pool.Numa     = true;
+            w.Pool.NumaNode = w.Node->Id;
+        }
+        if (opts.Io == ExtractIo::Stdio && fopen_s(&w.File, path, u8"rb") != ERROR_SUCCESS)
+            opened = false;
+    }
+
+    if (opened)
+    {
+        // Create the output dump folder..
+        if (opts.Sink == ExtractSink::File)
+            ::CreateDirectory(opts.OutputDir.c_str(), nullptr);
+
+        progress_begin(entries.size());
+
+        // The workers run on the host executor, with the calling thread taking part so a busy host pool cannot stall
+        // the extraction. Without one, a single worker runs on the calling thread, unless it is pinned, and several run
+        // on a pool owned by the extraction that also decodes the windows of large files once workers run out of files..
+        std::unique_ptr<workpool_t> pool;
+        auto executor = opts.Executor;
+        if (executor == nullptr && (threads > 1 || !nodes.empty()))
+        {
+            pool     = std::make_unique<workpool_t>(threads);
+            executor = pool.get();
+        }
+
+        for (auto& w : workers)
+            w.Executor = executor;
+
+        executor_parallel_for(executor, workers.size(), [&workers, &ranges, header, &entries, &names, &opts](const std::size_t x) {
+            extract_worker(workers[x], ranges, header, entries, names, opts);
+        }, opts.Executor != nullptr);
+        pool.reset();
+
+        progress_end();
+    }
+    else
+        log_error(u8"[!] Error: Failed to open PAK file for reading.\r\n");
+
+    // Gather the results and release the workers..
+    uint32_t pinned = 0;
+    for (auto& w : workers)
+    {
+        pinned += w.Pinned ? 1 : 0;
+        result.Files += w.Result.Files;
+        result.Failures += w.Result.Failures;
+        result.Skipped += w.Result.Skipped;
+        result.BytesIn += w.Result.BytesIn;
+        result.BytesOut += w.Result.BytesOut;
+        result.PriorityReady = std::max(result.PriorityReady, w.Result.PriorityReady);
+
+        if (w.File != nullptr)
+            fclose(w.File);
+        pool_release(w.Pool);
+    }
+    result.PeakHeld      = budget.Peak;
+    result.PriorityFiles = priority;
+    if (image == nullptr)
+        filemap_close(map);
+
+    if (result.Skipped > 0)
+        log_info(u8"[!] Info: %llu files were skipped by post-process hooks.\r\n", (unsigned long long)result.Skipped);
+    if (!nodes.empty())
+        log_info(u8"[!] Info: NUMA: %zu node(s) used; %u of %zu workers pinned.\r\n", groups, pinned, workers.size());
+
+    return opened;
+}
+
+/**
+ * Returns the key a file name is matched by in a priority list. (Lowercase, with forward slashes.)
+ *
+ * @param {std::string&} name - The file name.
+ * @return {std::string} The key.
+ */
+static std::string extract_priority_key(const std::string& name)
+{
+    auto key = name;
+    std::transform(key.begin(), key.end(), key.begin(), [](const char c) { return c == '\\' ? '/' : (char)::tolower((unsigned char)c); });
+    return key;
+}
+
+/**
+ * Moves the entries named in a priority list in front of the others. Both parts stay in position order, so each is
+ * still read front to back.
+ *
+ * @param {char*} path - The priority list path. (One file name per line.)
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries.
+ * @param {std::vector<std::string>&} names - The output name of each entry.
+ * @param {std::vector<pakfileentry_t>&} orderedEntries - The vector to receive the reordered entries.
+ * @param {std::vector<std::string>&} orderedNames - The vector to receive the reordered names.
+ * @param {std::size_t&} priority - The value to receive the count of listed entries.
+ * @return {bool} True on success, false if the list could not be read.
+ */
+static bool extract_prioritize(const char* path, const std::vector<pakfileentry_t>& entries, const std::vector<std::string>& names, std::vector<pakfileentry_t>& orderedEntries,
+    std::vector<std::string>& orderedNames, std::size_t& priority)
+{
+    FILE* f = nullptr;
+    if (fopen_s(&f, path, u8"rb") != ERROR_SUCCESS)
+        return false;
+
+    // Read the listed names; blank lines are skipped..
+    std::unordered_set<std::string> listed;
+    char line[4096]{};
+    while (fgets(line, sizeof(line), f) != nullptr)
+    {
+        auto len = ::strlen(line);
+        while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == '\n' || line[len - 1] == ' ' || line[len - 1] == '\t'))
+            line[--len] = '\0';
+
+        if (len > 0)
+            listed.insert(extract_priority_key(line));
+    }
+    fclose(f);
+
+    orderedEntries.clear();
+    orderedNames.clear();
+    orderedEntries.reserve(entries.size());
+    orderedNames.reserve(names.size());
+
+    std::unordered_set<std::string> found;
+    for (auto pass = 0; pass < 2; pass++)
+    {
+        for (std::size_t x = 0; x < entries.size(); x++)
+        {
+            const auto key  = extract_priority_key(names[x]);
+            const auto want = listed.count(key) > 0;
+            if (want != (pass == 0))
+                continue;
+
+            if (want)
+                found.insert(key);
+            orderedEntries.push_back(entries[x]);
+            orderedNames.push_back(names[x]);
+        }
+
+        if (pass == 0)
+            priority = orderedEntries.size();
+    }
+
+    log_info(u8"[!] Info: Priority list: %zu of %zu listed files found.\r\n", found.size(), listed.size());
+    for (const auto& name : listed)
+    {
+        if (found.count(name) == 0)
+            log_verbose(u8"[!] Warning: Listed file not found: %s\r\n", name.c_str());
+    }
+
+    return true;
+}
+
+/**
+ * Extracts the given file entries, the ones named in the priority list of the options first.
+ *
+ * @param {char*} path - The PAK file path. (nullptr when extracting from memory.)
+ * @param {filemap_t*} image - The PAK file held in memory. (nullptr when extracting from the path.)
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries to extract.
+ * @param {std::vector<std::string>&} names - The output name of each entry.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+static bool extract_start(const char* path, const filemap_t* image, const pakheader_t* header, const std::vector<pakfileentry_t>& entries, const std::vector<std::string>& names,
+    const extractoptions_t& opts, extractresult_t& result)
+{
+    if (opts.Priority.empty())
+        return extract_run(path, image, header, entries, names, 0, opts, result);
+
+    std::vector<pakfileentry_t> orderedEntries;
+    std::vector<std::string> orderedNames;
+    std::size_t priority = 0;
+    if (!extract_prioritize(opts.Priority.c_str(), entries, names, orderedEntries, orderedNames, priority))
+    {
+        log_error(u8"[!] Error: Failed to read the priority list: %s\r\n", opts.Priority.c_str());
+        result = extractresult_t{};
+        return false;
+    }
+
+    return extract_run(path, image, header, orderedEntries, orderedNames, priority, opts, result);
+}
+
+/**
+ * Extracts the given file entries of a PAK file.
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries to extract.
+ * @param {std::vector<std::string>&} names - The output name of each entry.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True if the PAK file could be opened with the requested backend, false otherwise.
+ */
+bool extract_entries(const char* path, const pakheader_t* header, const std::vector<pakfileentry_t>& entries, const std::vector<std::string>& names, const extractoptions_t& opts, extractresult_t& result)
+{
+    return extract_start(path, nullptr, header, entries, names, opts, result);
+}
+
+/**
+ * Extracts the given file entries of a PAK file held in memory. (The files are always decoded straight from memory.)
+ *
+ * @param {uint8_t*} data - The PAK file data.
+ * @param {uint64_t} size - The size of the PAK file data.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries to extract.
+ * @param {std::vector<std::string>&} names - The output name of each entry.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_entries_image(const uint8_t* data, const uint64_t size, const pakheader_t* header, const std::vector<pakfileentry_t>& entries, const std::vector<std::string>& names,
+    const extractoptions_t& opts, extractresult_t& result)
+{
+    filemap_t image{};
+    image.Data = data;
+    image.Size = size;
+
+    // Memory is read the same way as a mapping..
+    auto o = opts;
+    o.Io   = ExtractIo::Mmap;
+    return extract_start(nullptr, &image, header, entries, names, o, result);
+}
+
+/**
+ * Reads the tables of a Kaiko compressed PAK file and extracts all of its file entries.
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_pak(const char* path, const extractoptions_t& opts, extractresult_t& result)
+{
+    result = extractresult_t{};
+
+    FILE* f = nullptr;
+    if (fopen_s(&f, path, u8"rb") != ERROR_SUCCESS)
+        return false;
+
+    // Read the header and tables..
+    pakheader_t header{};
+    std::vector<pakfileentry_t> entries;
+    std::vector<std::tuple<uint32_t, std::string>> strings;
+    uint32_t specialCount = 0;
+
+    const auto valid = fread(&header, sizeof(pakheader_t), 1, f) == 1 && header.Signature == PakFileType::KaikoCompressedLE && header.IsValid != 0 &&
+                       pak_read_entries(f, &header, entries, specialCount) && !entries.empty();
+    if (valid)
+    {
+        const auto table = entries.back();
+        entries.pop_back();
+        pak_read_names(f, &header, table, strings);
+    }
+    fclose(f);
+
+    if (!valid)
+        return false;
+
+    std::vector<std::string> names;
+    extract_resolve_names(entries, strings, names);
+
+    return extract_entries(path, &header, entries, names, opts, result);
+}
@@ -0,0 +1,179 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * The file extraction engine. (Worker threads, I/O backends and output sinks.)
+ */
+#ifndef DEPAK_EXTRACT_H_INCLUDED
+#define DEPAK_EXTRACT_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "executor.h"
+#include "hugepages.h"
+#include "pak.h"
+#include "postprocess.h"
+
+/**
+ * Extraction I/O Backend Enumeration
+ *
+ */
+enum class ExtractIo
+{
+    Stdio, // Each worker reads through its own FILE handle.
+    Mmap,  // The PAK file is mapped into memory once and shared by all workers.
+};
+
+/**
+ * Extraction Output Sink Enumeration
+ *
+ */
+enum class ExtractSink
+{
+    File, // Decompressed files are written to the output directory.
+    Null, // Decompressed files are discarded. (Measures reading and decoding alone.)
+};
+
+/**
+ * Extraction Options Structure
+ *
+ */
+struct extractoptions_t
+{
+    uint32_t Threads;             // The count of workers. (0 uses the hardware thread count, or the concurrency of the executor.)
+    executor_t* Executor;         // The executor the workers and parallel decoding run on. (nullptr uses a pool owned by the extraction.)
+    ExtractIo Io;                 // The I/O backend.
+    ExtractSink Sink;             // The output sink.
+    std::string OutputDir;        // The output directory of the file sink.
+    uint64_t MemoryBudget;        // The bytes of file data all workers may hold at once. (0 buffers whole files without a limit.)
+    HugePages Pages;              // The huge pages mode of the buffers and the archive mapping.
+    bool Numa;                    // Flag if workers are pinned per NUMA node, with node-local buffers and entry ranges.
+    uint64_t SpillMemory;         // The bytes of a streamed PAK file held in memory before it is spilled to a temporary file.
+    std::string SpillDir;         // The directory of the spill file of a streamed PAK file.
+    std::string Priority;         // The path of a list of file names extracted before the others. (Empty if none.)
+    std::vector<posthook_t> Post; // The post-process hooks run on each file before it is written.
+};
+
+/**
+ * Extraction Result Structure
+ *
+ */
+struct extractresult_t
+{
+    uint64_t Files;         // The count of files extracted.
+    uint64_t Failures;      // The count of files that failed to extract.
+    uint64_t Skipped;       // The count of files a post-process hook dropped. (Not counted in Files.)
+    uint64_t BytesIn;       // The count of compressed bytes read.
+    uint64_t BytesOut;      // The count of decompressed bytes produced.
+    uint64_t PeakHeld;      // The most bytes of file data held at once under a memory budget.
+    uint64_t PriorityFiles; // The count of entries named in the priority list.
+    double PriorityReady;   // The seconds until every priority entry was extracted.
+};
+
+/**
+ * The most decompressed bytes a worker decodes before writing them out when a memory budget is set.
+ */
+constexpr uint64_t EXTRACT_STREAM_WINDOW = 4 * 1024 * 1024;
+
+/**
+ * The default bytes of a PAK file read from a stream that are held in memory before it is spilled to a temporary file.
+ */
+constexpr uint64_t EXTRACT_SPILL_MEMORY = 256 * 1024 * 1024;
+
+/**
+ * The fewest chunks of a window decoded as one part when a window is split over the executor. (256 KB of file data.)
+ */
+constexpr std::size_t EXTRACT_DECODE_PART = 64;
+
+/**
+ * Returns the default extraction options. (One thread, stdio, written to the 'dump' directory.)
+ *
+ * @return {extractoptions_t} The default options.
+ */
+extractoptions_t extract_default_options(void);
+
+/**
+ * Parses an I/O backend name.
+ *
+ * @param {char*} value - The backend name. (stdio or mmap)
+ * @param {ExtractIo&} io - The value to receive the backend.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_parse_io(const char* value, ExtractIo& io);
+
+/**
+ * Parses an output sink name.
+ *
+ * @param {char*} value - The sink name. (file or null)
+ * @param {ExtractSink&} sink - The value to receive the sink.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_parse_sink(const char* value, ExtractSink& sink);
+
+/**
+ * Returns the name of an I/O backend.
+ *
+ * @param {ExtractIo} io - The backend.
+ * @return {char*} The backend name.
+ */
+const char* extract_io_name(const ExtractIo io);
+
+/**
+ * Returns the name of an output sink.
+ *
+ * @param {ExtractSink} sink - The sink.
+ * @return {char*} The sink name.
+ */
+const char* extract_sink_name(const ExtractSink sink);
+
+/**
+ * Resolves the output name of each file entry; entries without a name are given a numbered unknown file name.
+ *
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries.
+ * @param {std::vector<std::tuple<uint32_t, std::string>>&} strings - The string table entries.
+ * @param {std::vector<std::string>&} names - The vector to receive the name of each entry.
+ */
+void extract_resolve_names(const std::vector<pakfileentry_t>& entries, const std::vector<std::tuple<uint32_t, std::string>>& strings, std::vector<std::string>& names);
+
+/**
+ * Extracts the given file entries of a PAK file.
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries to extract.
+ * @param {std::vector<std::string>&} names - The output name of each entry.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True if the PAK file could be opened with the requested backend, false otherwise.
+ */
+bool extract_entries(const char* path, const pakheader_t* header, const std::vector<pakfileentry_t>& entries, const std::vector<std::string>& names, const extractoptions_t& opts, extractresult_t& result);
+
+/**
+ * Extracts the given file entries of a PAK file held in memory. (The files are always decoded straight from memory.)
+ *
+ * @param {uint8_t*} data - The PAK file data.
+ * @param {uint64_t} size - The size of the PAK file data.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries to extract.
+ * @param {std::vector<std::string>&} names - The output name of each entry.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_entries_image(const uint8_t* data, const uint64_t size, const pakheader_t* header, const std::vector<pakfileentry_t>& entries, const std::vector<std::string>& names,
+    const extractoptions_t& opts, extractresult_t& result);
+
+/**
+ * Reads the tables of a Kaiko compressed PAK file and extracts all of its file entries.
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_pak(const char* path, const extractoptions_t& opts, extractresult_t& result);
+
+#endif // DEPAK_EXTRACT_H_INCLUDED
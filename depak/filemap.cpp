@@ -0,0 +1,116 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Read-only memory mapped files.
+ */
+#include <Windows.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "filemap.h"
+
+/**
+ * Maps a whole file into memory for reading.
+ *
+ * @param {char*} path - The file path.
+ * @param {filemap_t&} map - The map to populate.
+ * @param {HugePages} pages - The huge pages mode. (Mappings of files only take the transparent huge page hint.)
+ * @return {bool} True on success, false otherwise.
+ */
+bool filemap_open(const char* path, filemap_t& map, const HugePages pages)
+{
+    map = filemap_t{};
+
+#if defined(_WIN32)
+    const auto file = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size{};
+    if (!::GetFileSizeEx(file, &size) || size.QuadPart == 0 || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    const auto mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    const auto data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+    {
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        return false;
+    }
+
+    // Views of files cannot use large pages on Windows..
+    (void)pages;
+
+    map.Data    = (const uint8_t*)data;
+    map.Size    = (uint64_t)size.QuadPart;
+    map.File    = file;
+    map.Mapping = mapping;
+    return true;
+#else
+    const auto fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    const auto data = ::mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // Page cache backed mappings can only be collapsed into huge pages by the kernel (read-only THP for file systems);
+    // the hint is given for either mode and simply ignored where unsupported..
+    if (pages != HugePages::Off)
+        huge_advise(data, (std::size_t)st.st_size);
+
+    map.Data = (const uint8_t*)data;
+    map.Size = (uint64_t)st.st_size;
+    map.File = (void*)(intptr_t)fd;
+    return true;
+#endif
+}
+
+/**
+ * Unmaps a mapped file.
+ *
+ * @param {filemap_t&} map - The map to close.
+ */
+void filemap_close(filemap_t& map)
+{
+    if (map.Data == nullptr)
+        return;
+
+#if defined(_WIN32)
+    ::UnmapViewOfFile(map.Data);
+    ::CloseHandle(map.Mapping);
+    ::CloseHandle(map.File);
+#else
+    ::munmap((void*)map.Data, (std::size_t)map.Size);
+    ::close((int)(intptr_t)map.File);
+#endif
+
+    map = filemap_t{};
+}
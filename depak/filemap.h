@@ -0,0 +1,43 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Read-only memory mapped files.
+ */
+#ifndef DEPAK_FILEMAP_H_INCLUDED
+#define DEPAK_FILEMAP_H_INCLUDED
+
+#include <cstdint>
+
+#include "hugepages.h"
+
+/**
+ * File Map Structure
+ *
+ */
+struct filemap_t
+{
+    const uint8_t* Data; // The mapped file data.
+    uint64_t Size;       // The size of the mapped file.
+    void* File;          // The platform file handle.
+    void* Mapping;       // The platform mapping handle. (Windows only.)
+};
+
+/**
+ * Maps a whole file into memory for reading.
+ *
+ * @param {char*} path - The file path.
+ * @param {filemap_t&} map - The map to populate.
+ * @param {HugePages} pages - The huge pages mode. (Mappings of files only take the transparent huge page hint.)
+ * @return {bool} True on success, false otherwise.
+ */
+bool filemap_open(const char* path, filemap_t& map, const HugePages pages = HugePages::Off);
+
+/**
+ * Unmaps a mapped file.
+ *
+ * @param {filemap_t&} map - The map to close.
+ */
+void filemap_close(filemap_t& map);
+
+#endif // DEPAK_FILEMAP_H_INCLUDED
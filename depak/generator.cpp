@@ -0,0 +1,496 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Synthetic PAK file generator used for testing and benchmarking.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "aplib.h"
+#include "generator.h"
+#include "logger.h"
+
+/**
+ * Generator Random State Structure
+ *
+ * splitmix64; used instead of the standard distributions so output is identical across platforms.
+ */
+struct genrng_t
+{
+    uint64_t State;
+};
+
+/**
+ * Returns the next random value of the given state.
+ *
+ * @param {genrng_t&} rng - The random state.
+ * @return {uint64_t} The next random value.
+ */
+static uint64_t gen_next(genrng_t& rng)
+{
+    auto z = (rng.State += 0x9E3779B97F4A7C15ull);
+    z      = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z      = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Returns a uniform random value in [0, 1).
+ *
+ * @param {genrng_t&} rng - The random state.
+ * @return {double} The random value.
+ */
+static double gen_unit(genrng_t& rng)
+{
+    return (double)(gen_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Returns the random state for the given entry and stream. Each entry has independent streams so any
+ * entry can be reproduced without generating the ones before it.
+ *
+ * @param {genoptions_t&} opts - The generator options.
+ * @param {uint64_t} index - The index of the entry.
+ * @param {uint64_t} stream - The stream id.
+ * @return {genrng_t} The random state.
+ */
+static genrng_t gen_rng(const genoptions_t& opts, const uint64_t index, const uint64_t stream)
+{
+    genrng_t rng{opts.Seed ^ (index * 0xD1B54A32D192ED03ull) ^ (stream << 56)};
+    gen_next(rng);
+    return rng;
+}
+
+/**
+ * Returns the data profile of the given entry.
+ *
+ * @param {genoptions_t&} opts - The generator options.
+ * @param {uint64_t} index - The index of the entry.
+ * @return {GenProfile} The data profile.
+ */
+static GenProfile gen_file_profile(const genoptions_t& opts, const uint64_t index)
+{
+    if (opts.Profile != GenProfile::Mixed)
+        return opts.Profile;
+
+    auto rng     = gen_rng(opts, index, 0);
+    const auto u = gen_unit(rng);
+    if (u < 0.35)
+        return GenProfile::Text;
+    if (u < 0.65)
+        return GenProfile::Binary;
+    if (u < 0.85)
+        return GenProfile::Random;
+    return GenProfile::Zeros;
+}
+
+/**
+ * Returns the size of the given entry.
+ *
+ * @param {genoptions_t&} opts - The generator options.
+ * @param {genrng_t&} rng - The random state.
+ * @return {uint64_t} The file size.
+ */
+static uint64_t gen_file_size(const genoptions_t& opts, genrng_t& rng)
+{
+    double size = 0;
+    switch (opts.SizeDist)
+    {
+        case GenSizeDist::Fixed:
+            size = opts.SizeA;
+            break;
+        case GenSizeDist::Uniform:
+            size = opts.SizeA + std::floor((opts.SizeB - opts.SizeA + 1) * gen_unit(rng));
+            break;
+        case GenSizeDist::LogNormal:
+        {
+            const auto u1 = 1.0 - gen_unit(rng);
+            const auto u2 = gen_unit(rng);
+            size          = std::floor(opts.SizeA * std::exp(opts.SizeB * std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2)));
+            break;
+        }
+    }
+
+    return (uint64_t)std::clamp(size, 0.0, (double)std::min<uint64_t>(opts.MaxSize, 0xFFFFFFFF));
+}
+
+/**
+ * Fills a buffer with data of the given profile.
+ *
+ * @param {GenProfile} profile - The data profile.
+ * @param {genrng_t&} rng - The random state.
+ * @param {std::vector<uint8_t>&} data - The buffer to fill.
+ */
+static void gen_fill(const GenProfile profile, genrng_t& rng, std::vector<uint8_t>& data)
+{
+    static const char* words[] = {
+        u8"<item", u8"</item>", u8"name=", u8"value=", u8"type=", u8"\"true\"", u8"\"false\"", u8"id=",
+        u8"amalur", u8"reckoning", u8"sword", u8"shield", u8"fate", u8"weaver", u8"quest", u8"dialog",
+        u8"faction", u8"house", u8"ballads", u8"scholia", u8"rathir", u8"dalentarth", u8"detyre", u8"klurikon",
+        u8"health", u8"mana", u8"damage", u8"armor", u8"chance", u8"the", u8"of", u8"and",
+    };
+
+    const auto size = data.size();
+    switch (profile)
+    {
+        case GenProfile::Zeros:
+        case GenProfile::Mixed:
+            std::fill(data.begin(), data.end(), (uint8_t)0);
+            break;
+
+        case GenProfile::Text:
+        {
+            std::size_t pos = 0;
+            while (pos < size)
+            {
+                const auto r    = gen_next(rng);
+                const auto word = words[r % std::size(words)];
+                const auto len  = std::min(std::strlen(word), size - pos);
+                std::memcpy(data.data() + pos, word, len);
+                pos += len;
+
+                if (pos < size)
+                    data[pos++] = (r >> 32) % 10 == 0 ? '\n' : ' ';
+            }
+            break;
+        }
+
+        case GenProfile::Binary:
+        {
+            // Records of a shared template with a counter and a few mutated bytes..
+            uint8_t record[32]{};
+            for (auto& b : record)
+                b = (uint8_t)gen_next(rng);
+
+            for (std::size_t pos = 0, n = 0; pos < size; pos += sizeof(record), n++)
+            {
+                const auto r = gen_next(rng);
+                std::memcpy(record, &n, 4);
+                record[4 + (r % 28)] = (uint8_t)(r >> 8);
+                std::memcpy(data.data() + pos, record, std::min(sizeof(record), size - pos));
+            }
+            break;
+        }
+
+        case GenProfile::Random:
+        {
+            for (std::size_t pos = 0; pos < size; pos += 8)
+            {
+                const auto r = gen_next(rng);
+                std::memcpy(data.data() + pos, &r, std::min<std::size_t>(8, size - pos));
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * Returns the default generator options.
+ *
+ * @return {genoptions_t} The default generator options.
+ */
+genoptions_t gen_default_options(void)
+{
+    genoptions_t opts{};
+    opts.EntryCount   = 1000;
+    opts.SpecialCount = 0;
+    opts.SizeDist     = GenSizeDist::LogNormal;
+    opts.SizeA        = 16384;
+    opts.SizeB        = 1.5;
+    opts.MaxSize      = 64 * 1024 * 1024;
+    opts.Profile      = GenProfile::Mixed;
+    opts.NameMin      = 16;
+    opts.NameMax      = 48;
+    opts.Alignment    = 0x10;
+    opts.Seed         = 1;
+    return opts;
+}
+
+/**
+ * Parses a size distribution specification. (fixed:<n>, uniform:<min>:<max> or lognormal:<median>:<sigma>)
+ *
+ * @param {char*} spec - The specification string.
+ * @param {genoptions_t&} opts - The options to update.
+ * @return {bool} True on success, false otherwise.
+ */
+bool gen_parse_size(const char* spec, genoptions_t& opts)
+{
+    double a = 0, b = 0;
+    if (::sscanf_s(spec, u8"fixed:%lf", &a) == 1 && a >= 0)
+    {
+        opts.SizeDist = GenSizeDist::Fixed;
+        opts.SizeA    = a;
+        return true;
+    }
+    if (::sscanf_s(spec, u8"uniform:%lf:%lf", &a, &b) == 2 && a >= 0 && b >= a)
+    {
+        opts.SizeDist = GenSizeDist::Uniform;
+        opts.SizeA    = a;
+        opts.SizeB    = b;
+        return true;
+    }
+    if (::sscanf_s(spec, u8"lognormal:%lf:%lf", &a, &b) == 2 && a > 0 && b >= 0)
+    {
+        opts.SizeDist = GenSizeDist::LogNormal;
+        opts.SizeA    = a;
+        opts.SizeB    = b;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Parses a data profile name. (zeros, text, binary, random or mixed)
+ *
+ * @param {char*} name - The profile name.
+ * @param {genoptions_t&} opts - The options to update.
+ * @return {bool} True on success, false otherwise.
+ */
+bool gen_parse_profile(const char* name, genoptions_t& opts)
+{
+    static const std::tuple<const char*, GenProfile> profiles[] = {
+        {u8"zeros", GenProfile::Zeros},
+        {u8"text", GenProfile::Text},
+        {u8"binary", GenProfile::Binary},
+        {u8"random", GenProfile::Random},
+        {u8"mixed", GenProfile::Mixed},
+    };
+
+    for (const auto& p : profiles)
+    {
+        if (::strcmp(name, std::get<0>(p)) == 0)
+        {
+            opts.Profile = std::get<1>(p);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Generates the name of a synthetic file entry.
+ *
+ * @param {genoptions_t&} opts - The generator options.
+ * @param {uint64_t} index - The index of the entry.
+ * @return {std::string} The file name.
+ */
+std::string gen_file_name(const genoptions_t& opts, const uint64_t index)
+{
+    static const char* exts[][3] = {
+        {u8".dat", u8".pad", u8".bnk"}, // Zeros
+        {u8".xml", u8".txt", u8".lua"}, // Text
+        {u8".bin", u8".mesh", u8".anim"}, // Binary
+        {u8".dds", u8".ogg", u8".wav"}, // Random
+    };
+    static const char* dirs[] = {u8"art", u8"audio", u8"data", u8"scripts", u8"ui", u8"world"};
+
+    auto rng         = gen_rng(opts, index, 2);
+    const auto r     = gen_next(rng);
+    const auto range = opts.NameMax > opts.NameMin ? opts.NameMax - opts.NameMin + 1 : 1;
+    const auto len   = opts.NameMin + (uint32_t)(r % range);
+
+    // The name is '<dir>_<filler>_<index>.<ext>', with the filler padding it to the requested length..
+    char suffix[32]{};
+    sprintf_s(suffix, u8"_%08llX%s", (unsigned long long)index, exts[(int)gen_file_profile(opts, index) % 4][(r >> 32) % 3]);
+
+    std::string name = dirs[(r >> 40) % std::size(dirs)];
+    if (len > name.size() + ::strlen(suffix) + 1)
+    {
+        name += '_';
+        while (name.size() + ::strlen(suffix) < len)
+            name += (char)('a' + gen_next(rng) % 26);
+    }
+    name += suffix;
+
+    return name;
+}
+
+/**
+ * Returns the file id (crc) of a synthetic file entry. Ids are unique per index.
+ *
+ * @param {genoptions_t&} opts - The generator options.
+ * @param {uint64_t} index - The index of the entry.
+ * @return {uint32_t} The file id.
+ */
+uint32_t gen_file_id(const genoptions_t& opts, const uint64_t index)
+{
+    // murmur3 finalizer; a bijection so unique indexes produce unique ids..
+    auto h = (uint32_t)index + (uint32_t)opts.Seed;
+    h ^= h >> 16;
+    h *= 0x85EBCA6B;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * Writes a synthetic Kaiko compressed PAK file.
+ *
+ * @param {char*} path - The output file path.
+ * @param {genoptions_t&} opts - The generator options.
+ * @return {bool} True on success, false otherwise.
+ */
+bool gen_write_pak(const char* path, const genoptions_t& opts)
+{
+    // Validate the options..
+    if (opts.EntryCount == 0 || opts.EntryCount >= 0xFFFFFFFF || opts.Alignment == 0 || opts.NameMin == 0 || opts.NameMax < opts.NameMin)
+    {
+        log_error(u8"[!] Error: Invalid generator options.\r\n");
+        return false;
+    }
+
+    FILE* f = nullptr;
+    if (fopen_s(&f, path, u8"wb") != ERROR_SUCCESS)
+    {
+        log_error(u8"[!] Error: Failed to open output file for writing: %s\r\n", path);
+        return false;
+    }
+
+    std::vector<char> iobuf(4 * 1024 * 1024);
+    setvbuf(f, iobuf.data(), _IOFBF, iobuf.size());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    uint64_t offset = 0;
+    bool ok         = true;
+
+    const auto write = [&](const void* data, const std::size_t size) {
+        if (size > 0)
+            ok &= fwrite(data, size, 1, f) == 1;
+        offset += size;
+    };
+    const auto align = [&]() -> bool {
+        static const uint8_t zeros[256]{};
+        while (offset % opts.Alignment != 0)
+            write(zeros, (std::size_t)std::min<uint64_t>(sizeof(zeros), opts.Alignment - offset % opts.Alignment));
+        return offset / opts.Alignment <= 0xFFFFFFFF;
+    };
+
+    // Reserve the header; it is written once the entry table offset is known..
+    pakheader_t header{};
+    write(&header, sizeof(header));
+
+    std::vector<pakfileentry_t> entries;
+    std::vector<uint8_t> stringTable;
+    std::vector<uint8_t> fileData;
+    std::vector<uint8_t> chunkData;
+    std::vector<uint32_t> chunkSizes;
+    std::vector<uint8_t> workmem(aP_workmem_size(PAK_CHUNK_SIZE));
+
+    entries.reserve((std::size_t)opts.EntryCount + 1);
+
+    uint64_t totalSize = 0;
+    for (uint64_t x = 0; x < opts.EntryCount && ok; x++)
+    {
+        if (!align())
+        {
+            log_error(u8"[!] Error: Archive exceeds the maximum addressable size.\r\n");
+            ok = false;
+            break;
+        }
+
+        // Generate the file data..
+        auto rng = gen_rng(opts, x, 1);
+        fileData.resize((std::size_t)gen_file_size(opts, rng));
+        gen_fill(gen_file_profile(opts, x), rng, fileData);
+
+        // Compress the file data in chunks..
+        const auto chunks = (uint32_t)((fileData.size() + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE);
+        chunkSizes.resize(chunks);
+        chunkData.resize((std::size_t)chunks * aP_max_packed_size(PAK_CHUNK_SIZE));
+
+        std::size_t packed = 0;
+        for (uint32_t y = 0; y < chunks; y++)
+        {
+            const auto len = std::min<std::size_t>(PAK_CHUNK_SIZE, fileData.size() - (std::size_t)y * PAK_CHUNK_SIZE);
+            const auto res = aP_pack(fileData.data() + (std::size_t)y * PAK_CHUNK_SIZE, chunkData.data() + packed, (unsigned int)len, workmem.data(), nullptr, nullptr);
+            if (res == APLIB_ERROR || res == 0)
+            {
+                log_error(u8"[!] Error: Failed to compress generated data.\r\n");
+                ok = false;
+                break;
+            }
+
+            chunkSizes[y] = res;
+            packed += res;
+        }
+
+        // Write the file block..
+        const auto position = (uint32_t)(offset / opts.Alignment);
+        const auto fileSize = (uint32_t)fileData.size();
+        write(&fileSize, 4);
+        write(&chunks, 4);
+        write(chunkSizes.data(), chunkSizes.size() * 4);
+        write(chunkData.data(), packed);
+
+        entries.push_back({gen_file_id(opts, x), position, fileSize});
+        totalSize += fileSize;
+
+        // Store the file name..
+        const auto name      = gen_file_name(opts, x);
+        const uint32_t id[2] = {gen_file_id(opts, x), (uint32_t)name.size()};
+        stringTable.insert(stringTable.end(), (const uint8_t*)id, (const uint8_t*)id + sizeof(id));
+        stringTable.insert(stringTable.end(), name.begin(), name.end());
+
+        if ((x + 1) % 100000 == 0)
+            log_info(u8"[!] Info: Generated %llu of %llu entries..\r\n", (unsigned long long)(x + 1), (unsigned long long)opts.EntryCount);
+    }
+
+    // Write the string table as the last data block..
+    if (ok && !align())
+    {
+        log_error(u8"[!] Error: Archive exceeds the maximum addressable size.\r\n");
+        ok = false;
+    }
+
+    if (ok)
+    {
+        const uint32_t table[2] = {(uint32_t)stringTable.size(), 0};
+        entries.push_back({gen_file_id(opts, opts.EntryCount), (uint32_t)(offset / opts.Alignment), table[0]});
+        write(table, sizeof(table));
+        write(stringTable.data(), stringTable.size());
+    }
+
+    // Write the entry table, ordered by id like the game archives..
+    header.Signature     = PakFileType::KaikoCompressedLE;
+    header.IsValid       = 1;
+    header.Unknown00     = opts.Alignment;
+    header.Unknown01     = 0x100;
+    header.EntriesOffset = offset;
+
+    std::sort(entries.begin(), entries.end(), [](const pakfileentry_t& a, const pakfileentry_t& b) -> bool {
+        return a.Crc < b.Crc;
+    });
+
+    const uint32_t counts[2] = {(uint32_t)entries.size(), opts.SpecialCount};
+    write(counts, sizeof(counts));
+    write(entries.data(), entries.size() * sizeof(pakfileentry_t));
+
+    // Special entries are not understood yet; write zeroed placeholder records..
+    const pakfileentry_t special{};
+    for (uint32_t x = 0; x < opts.SpecialCount; x++)
+        write(&special, sizeof(special));
+
+    // Write the header..
+    ok &= _fseeki64(f, 0, SEEK_SET) == 0;
+    ok &= fwrite(&header, sizeof(header), 1, f) == 1;
+    ok &= fclose(f) == 0;
+
+    if (!ok)
+    {
+        log_error(u8"[!] Error: Failed to write the generated PAK file.\r\n");
+        return false;
+    }
+
+    const auto secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    log_info(u8"[!] Info: Generated %llu entries; %.2f MB of file data in a %.2f MB archive. (%.2fs)\r\n",
+        (unsigned long long)opts.EntryCount, (double)totalSize / (1024.0 * 1024.0), (double)offset / (1024.0 * 1024.0), secs);
+    return true;
+}
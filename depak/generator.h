@@ -0,0 +1,109 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Synthetic PAK file generator used for testing and benchmarking.
+ */
+#ifndef DEPAK_GENERATOR_H_INCLUDED
+#define DEPAK_GENERATOR_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include "pak.h"
+
+/**
+ * Generator File Size Distribution Enumeration
+ *
+ */
+enum class GenSizeDist
+{
+    Fixed,     // Every file is SizeA bytes.
+    Uniform,   // File sizes are uniform between SizeA and SizeB bytes.
+    LogNormal, // File sizes are log-normal with a median of SizeA bytes and a sigma of SizeB.
+};
+
+/**
+ * Generator Data Profile Enumeration
+ *
+ */
+enum class GenProfile
+{
+    Zeros,  // Zero filled data. (Compresses extremely well.)
+    Text,   // Word based text data. (Compresses well.)
+    Binary, // Structured record data. (Compresses moderately.)
+    Random, // Random data. (Incompressible.)
+    Mixed,  // A per-file mix of the other profiles.
+};
+
+/**
+ * Generator Options Structure
+ *
+ */
+struct genoptions_t
+{
+    uint64_t EntryCount;   // The count of file entries to generate. (The string table is added on top.)
+    uint32_t SpecialCount; // The count of special entries to generate.
+    GenSizeDist SizeDist;  // The file size distribution.
+    double SizeA;          // The first size distribution parameter.
+    double SizeB;          // The second size distribution parameter.
+    uint64_t MaxSize;      // The maximum size of a single file.
+    GenProfile Profile;    // The file data profile.
+    uint32_t NameMin;      // The minimum file name length.
+    uint32_t NameMax;      // The maximum file name length.
+    uint32_t Alignment;    // The file data alignment. (pakheader_t::Unknown00)
+    uint64_t Seed;         // The random seed; equal options and seeds produce identical files.
+};
+
+/**
+ * Returns the default generator options.
+ *
+ * @return {genoptions_t} The default generator options.
+ */
+genoptions_t gen_default_options(void);
+
+/**
+ * Parses a size distribution specification. (fixed:<n>, uniform:<min>:<max> or lognormal:<median>:<sigma>)
+ *
+ * @param {char*} spec - The specification string.
+ * @param {genoptions_t&} opts - The options to update.
+ * @return {bool} True on success, false otherwise.
+ */
+bool gen_parse_size(const char* spec, genoptions_t& opts);
+
+/**
+ * Parses a data profile name. (zeros, text, binary, random or mixed)
+ *
+ * @param {char*} name - The profile name.
+ * @param {genoptions_t&} opts - The options to update.
+ * @return {bool} True on success, false otherwise.
+ */
+bool gen_parse_profile(const char* name, genoptions_t& opts);
+
+/**
+ * Generates the name of a synthetic file entry.
+ *
+ * @param {genoptions_t&} opts - The generator options.
+ * @param {uint64_t} index - The index of the entry.
+ * @return {std::string} The file name.
+ */
+std::string gen_file_name(const genoptions_t& opts, const uint64_t index);
+
+/**
+ * Returns the file id (crc) of a synthetic file entry. Ids are unique per index.
+ *
+ * @param {genoptions_t&} opts - The generator options.
+ * @param {uint64_t} index - The index of the entry.
+ * @return {uint32_t} The file id.
+ */
+uint32_t gen_file_id(const genoptions_t& opts, const uint64_t index);
+
+/**
+ * Writes a synthetic Kaiko compressed PAK file.
+ *
+ * @param {char*} path - The output file path.
+ * @param {genoptions_t&} opts - The generator options.
+ * @return {bool} True on success, false otherwise.
+ */
+bool gen_write_pak(const char* path, const genoptions_t& opts);
+
+#endif // DEPAK_GENERATOR_H_INCLUDED
@@ -0,0 +1,223 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Huge page backed allocations and mapping hints.
+ */
+#include <Windows.h>
+#include <atomic>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <sys/mman.h>
+#endif
+
+#include "hugepages.h"
+
+/**
+ * Huge page state.
+ */
+static std::atomic<uint64_t> g_HugeExplicit{0};
+static std::atomic<uint64_t> g_HugeTransparent{0};
+static std::atomic<uint64_t> g_HugeFallbacks{0};
+static std::atomic<bool> g_HugeWarned{false};
+
+/**
+ * Parses a huge pages mode name.
+ *
+ * @param {char*} value - The mode name. (off, thp or explicit)
+ * @param {HugePages&} pages - The value to receive the mode.
+ * @return {bool} True on success, false otherwise.
+ */
+bool huge_parse(const char* value, HugePages& pages)
+{
+    if (::strcmp(value, u8"off") == 0)
+        pages = HugePages::Off;
+    else if (::strcmp(value, u8"thp") == 0)
+        pages = HugePages::Transparent;
+    else if (::strcmp(value, u8"explicit") == 0)
+        pages = HugePages::Explicit;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Returns the name of a huge pages mode.
+ *
+ * @param {HugePages} pages - The mode.
+ * @return {char*} The mode name.
+ */
+const char* huge_name(const HugePages pages)
+{
+    switch (pages)
+    {
+        case HugePages::Transparent:
+            return u8"thp";
+        case HugePages::Explicit:
+            return u8"explicit";
+        default:
+            return u8"off";
+    }
+}
+
+/**
+ * Prints a warning the first time reserved huge pages could not be used.
+ *
+ * @param {char*} reason - The reason.
+ */
+static void huge_warn(const char* reason)
+{
+    if (!g_HugeWarned.exchange(true, std::memory_order_relaxed))
+        printf_s(u8"[!] Warning: Explicit huge pages are unavailable (%s); falling back to smaller pages.\r\n", reason);
+}
+
+#if defined(_WIN32)
+
+/**
+ * Enables the privilege needed to allocate large pages for the process, once.
+ *
+ * @return {std::size_t} The large page size, 0 if large pages cannot be used.
+ */
+static std::size_t huge_large_page_size(void)
+{
+    static const auto size = []() -> std::size_t {
+        HANDLE token = nullptr;
+        if (!::OpenProcessToken(::GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+            return 0;
+
+        TOKEN_PRIVILEGES tp{};
+        tp.PrivilegeCount           = 1;
+        tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+        // AdjustTokenPrivileges succeeds without granting anything, so the last error has to be checked too..
+        const auto ok = ::LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &tp.Privileges[0].Luid) &&
+                        ::AdjustTokenPrivileges(token, FALSE, &tp, 0, nullptr, nullptr) && ::GetLastError() == ERROR_SUCCESS;
+        ::CloseHandle(token);
+
+        return ok ? ::GetLargePageMinimum() : 0;
+    }();
+    return size;
+}
+
+#endif
+
+/**
+ * Allocates page aligned memory with the given huge pages mode, falling back to lesser page kinds when needed.
+ *
+ * @param {std::size_t} size - The required size.
+ * @param {HugePages} pages - The huge pages mode. (Must not be Off.)
+ * @param {std::size_t&} mapped - The value to receive the size of the allocation. (At least the required size.)
+ * @return {void*} The allocated memory, nullptr on failure.
+ */
+void* huge_alloc(const std::size_t size, const HugePages pages, std::size_t& mapped)
+{
+    mapped = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+#if defined(_WIN32)
+    // Windows has no transparent huge pages; only explicit large pages are tried..
+    if (pages == HugePages::Explicit)
+    {
+        const auto large = huge_large_page_size();
+        if (large > 0)
+        {
+            const auto rounded = (size + large - 1) & ~(large - 1);
+            if (const auto p = ::VirtualAlloc(nullptr, rounded, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE))
+            {
+                mapped = rounded;
+                g_HugeExplicit.fetch_add(1, std::memory_order_relaxed);
+                return p;
+            }
+        }
+
+        huge_warn(large > 0 ? u8"out of large pages" : u8"SeLockMemoryPrivilege is not held");
+    }
+
+    g_HugeFallbacks.fetch_add(1, std::memory_order_relaxed);
+    return ::VirtualAlloc(nullptr, mapped, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    if (pages == HugePages::Explicit)
+    {
+        const auto p = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+        {
+            g_HugeExplicit.fetch_add(1, std::memory_order_relaxed);
+            return p;
+        }
+
+        huge_warn(errno == ENOMEM ? u8"none reserved in /proc/sys/vm/nr_hugepages" : ::strerror(errno));
+        g_HugeFallbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Map one extra huge page so the region can be trimmed to a huge page boundary; the kernel only backs aligned
+    // ranges with transparent huge pages..
+    const auto raw = ::mmap(nullptr, mapped + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        return nullptr;
+
+    const auto base  = (uintptr_t)raw;
+    const auto start = (base + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    if (start > base)
+        ::munmap(raw, start - base);
+    ::munmap((void*)(start + mapped), base + HUGE_PAGE_SIZE - start);
+
+    if (huge_advise((void*)start, mapped))
+        g_HugeTransparent.fetch_add(1, std::memory_order_relaxed);
+    else
+        g_HugeFallbacks.fetch_add(1, std::memory_order_relaxed);
+
+    return (void*)start;
+#endif
+}
+
+/**
+ * Releases memory allocated with huge_alloc.
+ *
+ * @param {void*} p - The memory.
+ * @param {std::size_t} mapped - The size of the allocation.
+ */
+void huge_free(void* p, const std::size_t mapped)
+{
+    if (p == nullptr)
+        return;
+
+#if defined(_WIN32)
+    (void)mapped;
+    ::VirtualFree(p, 0, MEM_RELEASE);
+#else
+    ::munmap(p, mapped);
+#endif
+}
+
+/**
+ * Hints that an existing mapping should be backed by transparent huge pages. (Linux only; does nothing elsewhere.)
+ *
+ * @param {void*} p - The start of the mapping.
+ * @param {std::size_t} size - The size of the mapping.
+ * @return {bool} True if the hint was accepted, false otherwise.
+ */
+bool huge_advise(const void* p, const std::size_t size)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    return ::madvise((void*)p, size, MADV_HUGEPAGE) == 0;
+#else
+    (void)p;
+    (void)size;
+    return false;
+#endif
+}
+
+/**
+ * Returns the huge page allocation statistics.
+ *
+ * @return {hugestats_t} The statistics.
+ */
+hugestats_t huge_stats(void)
+{
+    hugestats_t stats{};
+    stats.Explicit    = g_HugeExplicit.load(std::memory_order_relaxed);
+    stats.Transparent = g_HugeTransparent.load(std::memory_order_relaxed);
+    stats.Fallbacks   = g_HugeFallbacks.load(std::memory_order_relaxed);
+    return stats;
+}
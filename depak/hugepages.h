@@ -0,0 +1,91 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Huge page backed allocations and mapping hints.
+ */
+#ifndef DEPAK_HUGEPAGES_H_INCLUDED
+#define DEPAK_HUGEPAGES_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The huge page size allocations are rounded up to. (The x86-64 and arm64 default.)
+ */
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+/**
+ * Huge Pages Enumeration
+ *
+ */
+enum class HugePages
+{
+    Off,         // Regular pages.
+    Transparent, // Regular pages with a transparent huge page hint. (Linux madvise(MADV_HUGEPAGE).)
+    Explicit,    // Reserved huge pages. (Linux MAP_HUGETLB, Windows MEM_LARGE_PAGES.) Falls back to Transparent.
+};
+
+/**
+ * Huge Page Statistics Structure
+ *
+ */
+struct hugestats_t
+{
+    uint64_t Explicit;    // The count of allocations backed by reserved huge pages.
+    uint64_t Transparent; // The count of allocations given the transparent huge page hint.
+    uint64_t Fallbacks;   // The count of allocations that fell back to a lesser page kind.
+};
+
+/**
+ * Parses a huge pages mode name.
+ *
+ * @param {char*} value - The mode name. (off, thp or explicit)
+ * @param {HugePages&} pages - The value to receive the mode.
+ * @return {bool} True on success, false otherwise.
+ */
+bool huge_parse(const char* value, HugePages& pages);
+
+/**
+ * Returns the name of a huge pages mode.
+ *
+ * @param {HugePages} pages - The mode.
+ * @return {char*} The mode name.
+ */
+const char* huge_name(const HugePages pages);
+
+/**
+ * Allocates page aligned memory with the given huge pages mode, falling back to lesser page kinds when needed.
+ *
+ * @param {std::size_t} size - The required size.
+ * @param {HugePages} pages - The huge pages mode. (Must not be Off.)
+ * @param {std::size_t&} mapped - The value to receive the size of the allocation. (At least the required size.)
+ * @return {void*} The allocated memory, nullptr on failure.
+ */
+void* huge_alloc(const std::size_t size, const HugePages pages, std::size_t& mapped);
+
+/**
+ * Releases memory allocated with huge_alloc.
+ *
+ * @param {void*} p - The memory.
+ * @param {std::size_t} mapped - The size of the allocation.
+ */
+void huge_free(void* p, const std::size_t mapped);
+
+/**
+ * Hints that an existing mapping should be backed by transparent huge pages. (Linux only; does nothing elsewhere.)
+ *
+ * @param {void*} p - The start of the mapping.
+ * @param {std::size_t} size - The size of the mapping.
+ * @return {bool} True if the hint was accepted, false otherwise.
+ */
+bool huge_advise(const void* p, const std::size_t size);
+
+/**
+ * Returns the huge page allocation statistics.
+ *
+ * @return {hugestats_t} The statistics.
+ */
+hugestats_t huge_stats(void);
+
+#endif // DEPAK_HUGEPAGES_H_INCLUDED
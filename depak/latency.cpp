@@ -0,0 +1,383 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Log-linear (HDR-style) latency histograms for file extraction and reads.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "latency.h"
+
+/**
+ * Latency Block Structure
+ *
+ * Each thread owns its own block; blocks are merged when printed.
+ */
+struct latencyblock_t
+{
+    histogram_t Histograms[(int)LatencyKind::Count]; // The histogram of each latency kind.
+    latencyfile_t Slowest[LATENCY_SLOWEST];          // The slowest files, unordered.
+};
+
+/**
+ * Latency state.
+ */
+static std::atomic<bool> g_LatencyEnabled{false};
+static std::mutex g_LatencyMutex;
+static std::vector<std::unique_ptr<latencyblock_t>> g_LatencyBlocks;
+
+/**
+ * The display and json names of the latency kinds.
+ */
+static const char* g_LatencyKindNames[] = {
+    u8"file",
+    u8"read",
+};
+
+/**
+ * The percentiles that are reported.
+ */
+static const double g_LatencyPercentiles[] = {50.0, 90.0, 99.0, 99.9};
+
+/**
+ * Returns the index of the highest set bit of a non-zero value.
+ *
+ * @param {uint64_t} value - The value.
+ * @return {uint32_t} The bit index.
+ */
+static uint32_t hist_msb(const uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanReverse64(&index, value);
+    return index;
+#else
+    return 63 - (uint32_t)__builtin_clzll(value);
+#endif
+}
+
+/**
+ * Returns the bucket index of a value.
+ *
+ * Values below 2^(SUB_BITS+1) have their own bucket; above that each power of two is split into 2^SUB_BITS buckets.
+ *
+ * @param {uint64_t} value - The value.
+ * @return {uint32_t} The bucket index.
+ */
+static uint32_t hist_bucket(const uint64_t value)
+{
+    if (value < (2ull << LATENCY_SUB_BITS))
+        return (uint32_t)value;
+
+    const auto shift = hist_msb(value) - LATENCY_SUB_BITS;
+    return (shift << LATENCY_SUB_BITS) + (uint32_t)(value >> shift);
+}
+
+/**
+ * Returns the highest value that falls into a bucket.
+ *
+ * @param {uint32_t} index - The bucket index.
+ * @return {uint64_t} The highest value of the bucket.
+ */
+static uint64_t hist_bucket_high(const uint32_t index)
+{
+    if (index < (2u << LATENCY_SUB_BITS))
+        return index;
+
+    const auto shift = (index >> LATENCY_SUB_BITS) - 1;
+    const auto mant  = (uint64_t)(index - (shift << LATENCY_SUB_BITS));
+    return ((mant + 1) << shift) - 1;
+}
+
+/**
+ * Records a value into a histogram.
+ *
+ * @param {histogram_t&} h - The histogram.
+ * @param {uint64_t} value - The value to record.
+ */
+void hist_record(histogram_t& h, const uint64_t value)
+{
+    h.Counts[hist_bucket(value)]++;
+    h.Min = h.Count == 0 ? value : std::min(h.Min, value);
+    h.Max = std::max(h.Max, value);
+    h.Total += value;
+    h.Count++;
+}
+
+/**
+ * Adds the values of one histogram into another.
+ *
+ * @param {histogram_t&} dst - The histogram to add into.
+ * @param {histogram_t&} src - The histogram to add.
+ */
+void hist_merge(histogram_t& dst, const histogram_t& src)
+{
+    if (src.Count == 0)
+        return;
+
+    for (uint32_t x = 0; x < LATENCY_BUCKETS; x++)
+        dst.Counts[x] += src.Counts[x];
+
+    dst.Min = dst.Count == 0 ? src.Min : std::min(dst.Min, src.Min);
+    dst.Max = std::max(dst.Max, src.Max);
+    dst.Total += src.Total;
+    dst.Count += src.Count;
+}
+
+/**
+ * Returns the value at the given percentile of a histogram.
+ *
+ * @param {histogram_t&} h - The histogram.
+ * @param {double} pct - The percentile. (0 to 100)
+ * @return {uint64_t} The highest value equivalent to the bucket holding the percentile, clamped to the recorded maximum.
+ */
+uint64_t hist_percentile(const histogram_t& h, const double pct)
+{
+    if (h.Count == 0)
+        return 0;
+
+    const auto target = std::max<uint64_t>(1, (uint64_t)((pct / 100.0) * (double)h.Count + 0.5));
+
+    uint64_t seen = 0;
+    for (uint32_t x = 0; x < LATENCY_BUCKETS; x++)
+    {
+        seen += h.Counts[x];
+        if (seen >= target)
+            return std::min(hist_bucket_high(x), h.Max);
+    }
+    return h.Max;
+}
+
+/**
+ * Returns the calling threads latency block.
+ *
+ * @return {latencyblock_t*} The latency block of the calling thread.
+ */
+static latencyblock_t* latency_thread(void)
+{
+    thread_local latencyblock_t* block = nullptr;
+    if (block == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(g_LatencyMutex);
+        g_LatencyBlocks.push_back(std::make_unique<latencyblock_t>());
+        block = g_LatencyBlocks.back().get();
+    }
+    return block;
+}
+
+/**
+ * Merges the blocks of all threads.
+ *
+ * @param {histogram_t*} histograms - The histograms to merge into. (One per latency kind.)
+ * @param {std::vector<latencyfile_t>&} slowest - The vector to receive the slowest files, slowest first.
+ */
+static void latency_merge(histogram_t* histograms, std::vector<latencyfile_t>& slowest)
+{
+    std::lock_guard<std::mutex> lock(g_LatencyMutex);
+    for (const auto& b : g_LatencyBlocks)
+    {
+        for (auto x = 0; x < (int)LatencyKind::Count; x++)
+            hist_merge(histograms[x], b->Histograms[x]);
+        for (const auto& s : b->Slowest)
+        {
+            if (s.Nanoseconds > 0)
+                slowest.push_back(s);
+        }
+    }
+
+    std::sort(slowest.begin(), slowest.end(), [](const latencyfile_t& a, const latencyfile_t& b) -> bool { return a.Nanoseconds > b.Nanoseconds; });
+    if (slowest.size() > LATENCY_SLOWEST)
+        slowest.resize(LATENCY_SLOWEST);
+}
+
+/**
+ * Enables latency recording.
+ */
+void latency_enable(void)
+{
+    g_LatencyEnabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * Returns if latency recording is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool latency_enabled(void)
+{
+    return g_LatencyEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Records a latency into the calling threads histogram of the given kind.
+ *
+ * @param {LatencyKind} kind - The latency kind.
+ * @param {uint64_t} ns - The latency in nanoseconds.
+ */
+void latency_record(const LatencyKind kind, const uint64_t ns)
+{
+    if (!latency_enabled())
+        return;
+
+    hist_record(latency_thread()->Histograms[(int)kind], ns);
+}
+
+/**
+ * Records the extraction latency of a file, keeping track of the slowest files.
+ *
+ * @param {uint64_t} ns - The latency in nanoseconds.
+ * @param {char*} name - The file name.
+ * @param {uint64_t} bytes - The decompressed size of the file.
+ */
+void latency_record_file(const uint64_t ns, const char* name, const uint64_t bytes)
+{
+    if (!latency_enabled())
+        return;
+
+    auto block = latency_thread();
+    hist_record(block->Histograms[(int)LatencyKind::File], ns);
+
+    // Replace the fastest of the kept files if this one is slower..
+    auto fastest = std::min_element(std::begin(block->Slowest), std::end(block->Slowest), [](const latencyfile_t& a, const latencyfile_t& b) -> bool {
+        return a.Nanoseconds < b.Nanoseconds;
+    });
+    if (fastest->Nanoseconds >= ns)
+        return;
+
+    fastest->Nanoseconds = ns;
+    fastest->Bytes       = bytes;
+
+    const auto len = ::strlen(name);
+    const auto src = len >= sizeof(fastest->Name) ? name + len - (sizeof(fastest->Name) - 1) : name;
+    ::memcpy(fastest->Name, src, ::strlen(src) + 1);
+}
+
+/**
+ * Prints the latency percentiles of each kind and the slowest files.
+ */
+void latency_print(void)
+{
+    if (!latency_enabled())
+        return;
+
+    histogram_t histograms[(int)LatencyKind::Count]{};
+    std::vector<latencyfile_t> slowest;
+    latency_merge(histograms, slowest);
+
+    const auto ms = [](const uint64_t ns) -> double { return (double)ns / 1000000.0; };
+
+    printf_s(u8"\r\n[!] Latency: (milliseconds)\r\n");
+    printf_s(u8"    %-6s %10s %10s %10s %10s %10s %10s %10s\r\n", u8"Kind", u8"Count", u8"p50", u8"p90", u8"p99", u8"p99.9", u8"Max", u8"Mean");
+    for (auto x = 0; x < (int)LatencyKind::Count; x++)
+    {
+        const auto& h = histograms[x];
+        if (h.Count == 0)
+            continue;
+
+        printf_s(u8"    %-6s %10llu", g_LatencyKindNames[x], (unsigned long long)h.Count);
+        for (const auto p : g_LatencyPercentiles)
+            printf_s(u8" %10.3f", ms(hist_percentile(h, p)));
+        printf_s(u8" %10.3f %10.3f\r\n", ms(h.Max), ms(h.Total / h.Count));
+    }
+
+    if (slowest.empty())
+        return;
+
+    printf_s(u8"    Slowest files:\r\n");
+    for (const auto& s : slowest)
+        printf_s(u8"      %10.3f ms %12llu bytes  %s\r\n", ms(s.Nanoseconds), (unsigned long long)s.Bytes, s.Name);
+}
+
+/**
+ * Writes the latency histograms and the slowest files to a json file.
+ *
+ * @param {char*} path - The output json file path.
+ * @return {bool} True on success, false otherwise.
+ */
+bool latency_write_json(const char* path)
+{
+    histogram_t histograms[(int)LatencyKind::Count]{};
+    std::vector<latencyfile_t> slowest;
+    latency_merge(histograms, slowest);
+
+    FILE* f = nullptr;
+    if (fopen_s(&f, path, u8"wb") != ERROR_SUCCESS)
+    {
+        printf_s(u8"[!] Error: Failed to open latency file for writing: %s\r\n", path);
+        return false;
+    }
+
+    fprintf_s(f, u8"{\n");
+    for (auto x = 0; x < (int)LatencyKind::Count; x++)
+    {
+        const auto& h = histograms[x];
+
+        fprintf_s(f, u8"  \"%s\": {\"count\": %llu, \"min_ns\": %llu, \"max_ns\": %llu, \"mean_ns\": %llu", g_LatencyKindNames[x],
+            (unsigned long long)h.Count, (unsigned long long)h.Min, (unsigned long long)h.Max, (unsigned long long)(h.Count > 0 ? h.Total / h.Count : 0));
+        for (const auto p : g_LatencyPercentiles)
+            fprintf_s(f, u8", \"p%g_ns\": %llu", p, (unsigned long long)hist_percentile(h, p));
+
+        // Write the non-empty buckets as [highest value, count] pairs so the full distribution can be plotted..
+        fprintf_s(f, u8",\n    \"buckets\": [");
+        bool first = true;
+        for (uint32_t b = 0; b < LATENCY_BUCKETS; b++)
+        {
+            if (h.Counts[b] == 0)
+                continue;
+
+            fprintf_s(f, u8"%s[%llu, %llu]", first ? u8"" : u8", ", (unsigned long long)hist_bucket_high(b), (unsigned long long)h.Counts[b]);
+            first = false;
+        }
+        fprintf_s(f, u8"]},\n");
+    }
+
+    fprintf_s(f, u8"  \"slowest\": [");
+    for (std::size_t x = 0; x < slowest.size(); x++)
+    {
+        // Escape the name for json..
+        std::string name;
+        for (auto p = (const unsigned char*)slowest[x].Name; *p; p++)
+        {
+            if (*p == '"' || *p == '\\')
+                name += '\\';
+            if (*p >= 0x20)
+                name += (char)*p;
+        }
+
+        fprintf_s(f, u8"%s\n    {\"name\": \"%s\", \"ns\": %llu, \"bytes\": %llu}", x == 0 ? u8"" : u8",", name.c_str(),
+            (unsigned long long)slowest[x].Nanoseconds, (unsigned long long)slowest[x].Bytes);
+    }
+    fprintf_s(f, u8"\n  ]\n}\n");
+    fclose(f);
+
+    printf_s(u8"[!] Info: Wrote latency histograms to: %s\r\n", path);
+    return true;
+}
+
+/**
+ * Constructor and Destructor
+ *
+ * @param {LatencyKind} kind - The kind to record the scope into.
+ */
+latencyscope_t::latencyscope_t(const LatencyKind kind)
+    : m_Kind(kind)
+    , m_Active(latency_enabled())
+{
+    if (m_Active)
+        m_Begin = std::chrono::steady_clock::now();
+}
+latencyscope_t::~latencyscope_t(void)
+{
+    if (m_Active)
+        latency_record(m_Kind, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Begin).count());
+}
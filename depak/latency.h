@@ -0,0 +1,149 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Log-linear (HDR-style) latency histograms for file extraction and reads.
+ */
+#ifndef DEPAK_LATENCY_H_INCLUDED
+#define DEPAK_LATENCY_H_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Latency Kind Enumeration
+ *
+ */
+enum class LatencyKind
+{
+    File, // Extracting a single file. (Name resolve, read, decode and write.)
+    Read, // A single entry or range read through the reader api.
+    Count
+};
+
+/**
+ * The count of sub-buckets per power of two, as a bit count. (32 sub-buckets; values are kept within ~3%.)
+ */
+constexpr uint32_t LATENCY_SUB_BITS = 5;
+
+/**
+ * The count of buckets needed to cover every 64bit value.
+ */
+constexpr uint32_t LATENCY_BUCKETS = (64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS;
+
+/**
+ * The count of slowest files kept per thread.
+ */
+constexpr uint32_t LATENCY_SLOWEST = 8;
+
+/**
+ * Histogram Structure
+ *
+ */
+struct histogram_t
+{
+    uint64_t Counts[LATENCY_BUCKETS]; // The count of values recorded per bucket.
+    uint64_t Count;                   // The total count of values recorded.
+    uint64_t Total;                   // The sum of all values recorded.
+    uint64_t Min;                     // The smallest value recorded.
+    uint64_t Max;                     // The largest value recorded.
+};
+
+/**
+ * Slow File Structure
+ *
+ */
+struct latencyfile_t
+{
+    uint64_t Nanoseconds; // The time taken to extract the file.
+    uint64_t Bytes;       // The decompressed size of the file.
+    char Name[64];        // The file name. (Tail of long names.)
+};
+
+/**
+ * Records a value into a histogram.
+ *
+ * @param {histogram_t&} h - The histogram.
+ * @param {uint64_t} value - The value to record.
+ */
+void hist_record(histogram_t& h, const uint64_t value);
+
+/**
+ * Adds the values of one histogram into another.
+ *
+ * @param {histogram_t&} dst - The histogram to add into.
+ * @param {histogram_t&} src - The histogram to add.
+ */
+void hist_merge(histogram_t& dst, const histogram_t& src);
+
+/**
+ * Returns the value at the given percentile of a histogram.
+ *
+ * @param {histogram_t&} h - The histogram.
+ * @param {double} pct - The percentile. (0 to 100)
+ * @return {uint64_t} The highest value equivalent to the bucket holding the percentile, clamped to the recorded maximum.
+ */
+uint64_t hist_percentile(const histogram_t& h, const double pct);
+
+/**
+ * Enables latency recording.
+ */
+void latency_enable(void);
+
+/**
+ * Returns if latency recording is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool latency_enabled(void);
+
+/**
+ * Records a latency into the calling threads histogram of the given kind.
+ *
+ * @param {LatencyKind} kind - The latency kind.
+ * @param {uint64_t} ns - The latency in nanoseconds.
+ */
+void latency_record(const LatencyKind kind, const uint64_t ns);
+
+/**
+ * Records the extraction latency of a file, keeping track of the slowest files.
+ *
+ * @param {uint64_t} ns - The latency in nanoseconds.
+ * @param {char*} name - The file name.
+ * @param {uint64_t} bytes - The decompressed size of the file.
+ */
+void latency_record_file(const uint64_t ns, const char* name, const uint64_t bytes);
+
+/**
+ * Prints the latency percentiles of each kind and the slowest files.
+ */
+void latency_print(void);
+
+/**
+ * Writes the latency histograms and the slowest files to a json file.
+ *
+ * @param {char*} path - The output json file path.
+ * @return {bool} True on success, false otherwise.
+ */
+bool latency_write_json(const char* path);
+
+/**
+ * Latency Scope Structure
+ *
+ * Records the time between its construction and destruction into the given kind.
+ */
+struct latencyscope_t
+{
+    latencyscope_t(const LatencyKind kind);
+    ~latencyscope_t(void);
+
+    latencyscope_t(const latencyscope_t&) = delete;
+    latencyscope_t& operator=(const latencyscope_t&) = delete;
+
+private:
+    LatencyKind m_Kind;
+    bool m_Active;
+    std::chrono::steady_clock::time_point m_Begin;
+};
+
+#endif // DEPAK_LATENCY_H_INCLUDED
@@ -0,0 +1,212 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Stable C api of the depak shared library. (libdepak.so / libdepak.dll)
+ */
+#include <Windows.h>
+
+#include "libdepak.h"
+#include "pakreader.h"
+
+/**
+ * Archive Structure
+ *
+ */
+struct depak_archive
+{
+    pakreader_t* Reader; // The reader over the opened PAK file.
+};
+
+/**
+ * Returns the api version the library was built with. (DEPAK_API_VERSION)
+ *
+ * @return {uint32_t} The api version.
+ */
+uint32_t depak_api_version(void)
+{
+    return DEPAK_API_VERSION;
+}
+
+/**
+ * Opens a PAK file and parses its tables.
+ *
+ * @param {char*} path - The PAK file path.
+ * @return {depak_archive*} The archive on success, nullptr otherwise.
+ */
+depak_archive* depak_open(const char* path)
+{
+    if (path == nullptr)
+        return nullptr;
+
+    // No C++ exception may cross the C api; a damaged archive fails to open instead..
+    pakreader_t* reader = nullptr;
+    try
+    {
+        reader = pak_open(path);
+        if (reader == nullptr)
+            return nullptr;
+
+        return new depak_archive{reader};
+    }
+    catch (...)
+    {
+        pak_close(reader);
+        return nullptr;
+    }
+}
+
+/**
+ * Closes an archive and releases its resources.
+ *
+ * @param {depak_archive*} archive - The archive to close. (May be nullptr.)
+ */
+void depak_close(depak_archive* archive)
+{
+    if (archive == nullptr)
+        return;
+
+    pak_close(archive->Reader);
+    delete archive;
+}
+
+/**
+ * Returns the count of file entries of an archive.
+ *
+ * @param {depak_archive*} archive - The archive.
+ * @return {uint64_t} The count of file entries. (0 if the archive is nullptr.)
+ */
+uint64_t depak_entry_count(const depak_archive* archive)
+{
+    return archive == nullptr ? 0 : pak_entry_count(archive->Reader);
+}
+
+/**
+ * Returns the table information of a file entry. Entries are indexed in file position order.
+ *
+ * @param {depak_archive*} archive - The archive.
+ * @param {uint64_t} index - The entry index.
+ * @param {depak_entry_info*} info - The structure to populate.
+ * @return {int32_t} DEPAK_OK on success, DEPAK_ERROR_ARGUMENT otherwise.
+ */
+int32_t depak_entry(const depak_archive* archive, const uint64_t index, depak_entry_info* info)
+{
+    if (archive == nullptr || info == nullptr)
+        return DEPAK_ERROR_ARGUMENT;
+
+    try
+    {
+        const auto e = index < pak_entry_count(archive->Reader) ? pak_entry(archive->Reader, (std::size_t)index) : nullptr;
+        if (e == nullptr)
+            return DEPAK_ERROR_ARGUMENT;
+
+        info->Crc        = e->Crc;
+        info->Position   = e->Position;
+        info->Offset     = (uint64_t)e->Position * pak_header(archive->Reader)->Unknown00;
+        info->StoredSize = e->Size;
+        info->Name       = pak_entry_name(archive->Reader, (std::size_t)index);
+        return DEPAK_OK;
+    }
+    catch (...)
+    {
+        return DEPAK_ERROR_ARGUMENT;
+    }
+}
+
+/**
+ * Finds a file entry by its name.
+ *
+ * @param {depak_archive*} archive - The archive.
+ * @param {char*} name - The entry name, exactly as stored in the string table.
+ * @param {uint64_t*} index - Receives the entry index.
+ * @return {int32_t} DEPAK_OK on success, DEPAK_ERROR_NOT_FOUND or DEPAK_ERROR_ARGUMENT otherwise.
+ */
+int32_t depak_find(const depak_archive* archive, const char* name, uint64_t* index)
+{
+    if (archive == nullptr || name == nullptr || index == nullptr)
+        return DEPAK_ERROR_ARGUMENT;
+
+    try
+    {
+        std::size_t found = 0;
+        if (!pak_find_entry(archive->Reader, name, found))
+            return DEPAK_ERROR_NOT_FOUND;
+
+        *index = found;
+        return DEPAK_OK;
+    }
+    catch (...)
+    {
+        return DEPAK_ERROR_NOT_FOUND;
+    }
+}
+
+/**
+ * Returns the decoded size of a file entry.
+ *
+ * @param {depak_archive*} archive - The archive.
+ * @param {uint64_t} index - The entry index.
+ * @param {uint64_t*} size - Receives the decoded size.
+ * @return {int32_t} DEPAK_OK on success, an error status otherwise.
+ */
+int32_t depak_entry_size(depak_archive* archive, const uint64_t index, uint64_t* size)
+{
+    if (archive == nullptr || size == nullptr || index >= pak_entry_count(archive->Reader))
+        return DEPAK_ERROR_ARGUMENT;
+
+    try
+    {
+        return pak_entry_file_size(archive->Reader, (std::size_t)index, *size) ? DEPAK_OK : DEPAK_ERROR_READ;
+    }
+    catch (...)
+    {
+        return DEPAK_ERROR_READ;
+    }
+}
+
+/**
+ * Reads and decodes a whole file entry into a caller buffer.
+ *
+ * @param {depak_archive*} archive - The archive.
+ * @param {uint64_t} index - The entry index.
+ * @param {void*} buffer - The buffer to receive the decoded data. (May be nullptr when capacity is 0.)
+ * @param {uint64_t} capacity - The size of the buffer.
+ * @param {uint64_t*} size - Receives the decoded size; also set when the buffer is too small.
+ * @return {int32_t} DEPAK_OK on success, an error status otherwise.
+ */
+int32_t depak_read(depak_archive* archive, const uint64_t index, void* buffer, const uint64_t capacity, uint64_t* size)
+{
+    return depak_read_range(archive, index, 0, UINT64_MAX, buffer, capacity, size);
+}
+
+/**
+ * Reads and decodes a byte range of a file entry into a caller buffer; only the chunks covering the range are read.
+ *
+ * @param {depak_archive*} archive - The archive.
+ * @param {uint64_t} index - The entry index.
+ * @param {uint64_t} offset - The offset into the decoded file.
+ * @param {uint64_t} length - The count of bytes to read. (Clamped to the end of the file.)
+ * @param {void*} buffer - The buffer to receive the decoded bytes. (May be nullptr when capacity is 0.)
+ * @param {uint64_t} capacity - The size of the buffer.
+ * @param {uint64_t*} size - Receives the count of bytes in the range; also set when the buffer is too small.
+ * @return {int32_t} DEPAK_OK on success, an error status otherwise.
+ */
+int32_t depak_read_range(depak_archive* archive, const uint64_t index, const uint64_t offset, const uint64_t length, void* buffer, const uint64_t capacity, uint64_t* size)
+{
+    if (archive == nullptr || size == nullptr || (buffer == nullptr && capacity != 0) || index >= pak_entry_count(archive->Reader))
+        return DEPAK_ERROR_ARGUMENT;
+
+    // Decoded straight into the caller buffer; a range larger than the buffer is reported before anything is read..
+    try
+    {
+        *size = 0;
+        if (pak_read_range_buffer(archive->Reader, (std::size_t)index, offset, length, (uint8_t*)buffer, capacity, *size))
+            return DEPAK_OK;
+
+        return *size > capacity ? DEPAK_ERROR_BUFFER : DEPAK_ERROR_READ;
+    }
+    catch (...)
+    {
+        return DEPAK_ERROR_READ;
+    }
+}
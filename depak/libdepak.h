@@ -0,0 +1,166 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Stable C api of the depak shared library. (libdepak.so / libdepak.dll)
+ *
+ * The library is built from the same reader as the dumper and lets other tools open PAK files, list their entries and
+ * read decoded file data without running the dumper. The header is plain C so it can be used from C, C++ and any
+ * language with a C foreign function interface (ctypes, P/Invoke, etc.)
+ *
+ * Rules of the api:
+ *
+ *   - Functions that can fail return a DEPAK_* status; 0 is success and every error is negative.
+ *   - Data is always read into buffers owned by the caller. A buffer that is too small fails with DEPAK_ERROR_BUFFER
+ *     and still reports the size that is needed; passing a nullptr buffer with a capacity of 0 only queries the size.
+ *   - An archive may be read from multiple threads at once; file access is serialized and decoding runs on the
+ *     calling thread. Closing an archive must not race any other call on it.
+ *   - Strings returned by the library stay valid until the archive is closed.
+ *   - Structures are only ever extended at the end; DEPAK_API_VERSION is raised when that happens.
+ */
+#ifndef DEPAK_LIBDEPAK_H_INCLUDED
+#define DEPAK_LIBDEPAK_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(DEPAK_BUILD_LIBRARY)
+#define DEPAK_API __declspec(dllexport)
+#else
+#define DEPAK_API __declspec(dllimport)
+#endif
+#else
+#define DEPAK_API __attribute__((visibility("default")))
+#endif
+
+/**
+ * The version of the api described by this header.
+ */
+#define DEPAK_API_VERSION 1
+
+/**
+ * Api status codes.
+ */
+#define DEPAK_OK              0  // Success.
+#define DEPAK_ERROR_ARGUMENT  -1 // A required argument is nullptr or an index is out of range.
+#define DEPAK_ERROR_NOT_FOUND -2 // No entry has the given name.
+#define DEPAK_ERROR_READ      -3 // The entry data could not be read from the PAK file.
+#define DEPAK_ERROR_BUFFER    -4 // The caller buffer is too small; the needed size is still reported.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * Archive (Opaque)
+     *
+     * An opened PAK file.
+     */
+    typedef struct depak_archive depak_archive;
+
+    /**
+     * Entry Information Structure
+     *
+     */
+    typedef struct depak_entry_info
+    {
+        uint32_t Crc;        // The file name id that links the entry to the string table.
+        uint32_t Position;   // The position of the file data block. (In units of the header alignment.)
+        uint64_t Offset;     // The byte offset of the file data block.
+        uint32_t StoredSize; // The stored size of the file data block.
+        const char* Name;    // The entry name. (nullptr if the entry is not named in the string table.)
+    } depak_entry_info;
+
+    /**
+     * Returns the api version the library was built with. (DEPAK_API_VERSION)
+     *
+     * @return {uint32_t} The api version.
+     */
+    DEPAK_API uint32_t depak_api_version(void);
+
+    /**
+     * Opens a PAK file and parses its tables.
+     *
+     * @param {char*} path - The PAK file path.
+     * @return {depak_archive*} The archive on success, nullptr otherwise.
+     */
+    DEPAK_API depak_archive* depak_open(const char* path);
+
+    /**
+     * Closes an archive and releases its resources.
+     *
+     * @param {depak_archive*} archive - The archive to close. (May be nullptr.)
+     */
+    DEPAK_API void depak_close(depak_archive* archive);
+
+    /**
+     * Returns the count of file entries of an archive.
+     *
+     * @param {depak_archive*} archive - The archive.
+     * @return {uint64_t} The count of file entries. (0 if the archive is nullptr.)
+     */
+    DEPAK_API uint64_t depak_entry_count(const depak_archive* archive);
+
+    /**
+     * Returns the table information of a file entry. Entries are indexed in file position order.
+     *
+     * @param {depak_archive*} archive - The archive.
+     * @param {uint64_t} index - The entry index.
+     * @param {depak_entry_info*} info - The structure to populate.
+     * @return {int32_t} DEPAK_OK on success, DEPAK_ERROR_ARGUMENT otherwise.
+     */
+    DEPAK_API int32_t depak_entry(const depak_archive* archive, uint64_t index, depak_entry_info* info);
+
+    /**
+     * Finds a file entry by its name.
+     *
+     * @param {depak_archive*} archive - The archive.
+     * @param {char*} name - The entry name, exactly as stored in the string table.
+     * @param {uint64_t*} index - Receives the entry index.
+     * @return {int32_t} DEPAK_OK on success, DEPAK_ERROR_NOT_FOUND or DEPAK_ERROR_ARGUMENT otherwise.
+     */
+    DEPAK_API int32_t depak_find(const depak_archive* archive, const char* name, uint64_t* index);
+
+    /**
+     * Returns the decoded size of a file entry.
+     *
+     * @param {depak_archive*} archive - The archive.
+     * @param {uint64_t} index - The entry index.
+     * @param {uint64_t*} size - Receives the decoded size.
+     * @return {int32_t} DEPAK_OK on success, an error status otherwise.
+     */
+    DEPAK_API int32_t depak_entry_size(depak_archive* archive, uint64_t index, uint64_t* size);
+
+    /**
+     * Reads and decodes a whole file entry into a caller buffer.
+     *
+     * @param {depak_archive*} archive - The archive.
+     * @param {uint64_t} index - The entry index.
+     * @param {void*} buffer - The buffer to receive the decoded data. (May be nullptr when capacity is 0.)
+     * @param {uint64_t} capacity - The size of the buffer.
+     * @param {uint64_t*} size - Receives the decoded size; also set when the buffer is too small.
+     * @return {int32_t} DEPAK_OK on success, an error status otherwise.
+     */
+    DEPAK_API int32_t depak_read(depak_archive* archive, uint64_t index, void* buffer, uint64_t capacity, uint64_t* size);
+
+    /**
+     * Reads and decodes a byte range of a file entry into a caller buffer; only the chunks covering the range are read.
+     *
+     * @param {depak_archive*} archive - The archive.
+     * @param {uint64_t} index - The entry index.
+     * @param {uint64_t} offset - The offset into the decoded file.
+     * @param {uint64_t} length - The count of bytes to read. (Clamped to the end of the file.)
+     * @param {void*} buffer - The buffer to receive the decoded bytes. (May be nullptr when capacity is 0.)
+     * @param {uint64_t} capacity - The size of the buffer.
+     * @param {uint64_t*} size - Receives the count of bytes in the range; also set when the buffer is too small.
+     * @return {int32_t} DEPAK_OK on success, an error status otherwise.
+     */
+    DEPAK_API int32_t depak_read_range(depak_archive* archive, uint64_t index, uint64_t offset, uint64_t length, void* buffer, uint64_t capacity, uint64_t* size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEPAK_LIBDEPAK_H_INCLUDED
@@ -0,0 +1,305 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Buffered console logging and the rate-limited progress line.
+ */
+#include <Windows.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "logger.h"
+
+/**
+ * The interval between progress line redraws.
+ */
+constexpr auto LOG_PROGRESS_INTERVAL = std::chrono::milliseconds(250);
+
+/**
+ * The amount of pending output that wakes the writer early.
+ */
+constexpr std::size_t LOG_FLUSH_SIZE = 64 * 1024;
+
+/**
+ * Logger state.
+ */
+static LogLevel g_LogLevel = LogLevel::Normal;
+static std::mutex g_LogMutex;
+static std::condition_variable g_LogCondition;
+static std::string g_LogBuffer;
+static std::thread g_LogThread;
+static bool g_LogRunning = false;
+
+/**
+ * Progress state.
+ */
+static std::atomic<bool> g_ProgressActive{false};
+static std::atomic<uint64_t> g_ProgressFiles{0};
+static std::atomic<uint64_t> g_ProgressBytes{0};
+static uint64_t g_ProgressTotal = 0;
+static std::chrono::steady_clock::time_point g_ProgressStart;
+static bool g_ProgressDrawn  = false;
+static bool g_ProgressFinish = false;
+
+/**
+ * Draws the progress line. Called by the console writer, or directly once it has stopped.
+ *
+ * @param {bool} final - Flag if this is the last draw of the line.
+ */
+static void progress_draw(const bool final)
+{
+    const auto files = g_ProgressFiles.load(std::memory_order_relaxed);
+    const auto bytes = g_ProgressBytes.load(std::memory_order_relaxed);
+    const auto secs  = std::chrono::duration<double>(std::chrono::steady_clock::now() - g_ProgressStart).count();
+    const auto mbs   = secs > 0 ? ((double)bytes / (1024.0 * 1024.0)) / secs : 0.0;
+    const auto pct   = g_ProgressTotal > 0 ? (double)files * 100.0 / (double)g_ProgressTotal : 100.0;
+
+    char eta[32] = u8"--:--";
+    if (files > 0 && files < g_ProgressTotal)
+    {
+        const auto remain = (uint64_t)(secs * (double)(g_ProgressTotal - files) / (double)files);
+        sprintf_s(eta, u8"%02llu:%02llu", (unsigned long long)(remain / 60), (unsigned long long)(remain % 60));
+    }
+    else if (files >= g_ProgressTotal)
+        sprintf_s(eta, u8"00:00");
+
+    printf_s(u8"\r[!] Progress: %llu/%llu files (%5.1f%%), %.1f MB, %.1f MB/s, ETA %s   %s",
+        (unsigned long long)files, (unsigned long long)g_ProgressTotal, pct, (double)bytes / (1024.0 * 1024.0), mbs, eta, final ? u8"\r\n" : u8"");
+    fflush(stdout);
+
+    g_ProgressDrawn = !final;
+}
+
+/**
+ * Writes pending output to the console, moving past an unfinished progress line first.
+ *
+ * @param {std::string&} pending - The pending output.
+ */
+static void logger_write(const std::string& pending)
+{
+    if (pending.empty())
+        return;
+
+    if (g_ProgressDrawn)
+    {
+        printf_s(u8"\r\n");
+        g_ProgressDrawn = false;
+    }
+
+    fwrite(pending.data(), 1, pending.size(), stdout);
+    fflush(stdout);
+}
+
+/**
+ * The background console writer.
+ */
+static void logger_thread(void)
+{
+    std::string pending;
+    auto lastDraw = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(g_LogMutex);
+    while (g_LogRunning)
+    {
+        g_LogCondition.wait_for(lock, LOG_PROGRESS_INTERVAL, [] { return !g_LogRunning || g_ProgressFinish || g_LogBuffer.size() >= LOG_FLUSH_SIZE; });
+
+        pending.swap(g_LogBuffer);
+        const auto finish = g_ProgressFinish;
+        lock.unlock();
+
+        logger_write(pending);
+        pending.clear();
+
+        // Redraw the progress line at most once per interval..
+        const auto now = std::chrono::steady_clock::now();
+        if (finish)
+            progress_draw(true);
+        else if (g_ProgressActive.load(std::memory_order_relaxed) && now - lastDraw >= LOG_PROGRESS_INTERVAL)
+        {
+            progress_draw(false);
+            lastDraw = now;
+        }
+
+        lock.lock();
+        if (finish)
+        {
+            g_ProgressFinish = false;
+            g_LogCondition.notify_all();
+        }
+    }
+
+    pending.swap(g_LogBuffer);
+    lock.unlock();
+
+    logger_write(pending);
+}
+
+/**
+ * Formats and queues (or prints) a message.
+ *
+ * @param {char*} fmt - The format string.
+ * @param {va_list} args - The format arguments.
+ */
+static void logger_append(const char* fmt, va_list args)
+{
+    char buffer[1024]{};
+    vsnprintf_s(buffer, sizeof(buffer), _TRUNCATE, fmt, args);
+
+    std::lock_guard<std::mutex> lock(g_LogMutex);
+    if (!g_LogRunning)
+    {
+        printf_s(u8"%s", buffer);
+        return;
+    }
+
+    g_LogBuffer += buffer;
+    if (g_LogBuffer.size() >= LOG_FLUSH_SIZE)
+        g_LogCondition.notify_all();
+}
+
+/**
+ * Starts the background console writer. Until started (and after stopping), messages are printed directly.
+ *
+ * @param {LogLevel} level - The log level.
+ */
+void logger_start(const LogLevel level)
+{
+    std::lock_guard<std::mutex> lock(g_LogMutex);
+
+    g_LogLevel = level;
+    if (g_LogRunning)
+        return;
+
+    g_LogRunning = true;
+    g_LogThread  = std::thread(logger_thread);
+}
+
+/**
+ * Flushes all pending output, finishes the progress line and stops the background console writer.
+ */
+void logger_stop(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_LogMutex);
+        if (!g_LogRunning)
+            return;
+
+        g_LogRunning = false;
+    }
+
+    g_LogCondition.notify_all();
+    g_LogThread.join();
+
+    if (g_ProgressActive.exchange(false))
+        progress_draw(true);
+}
+
+/**
+ * Returns the current log level.
+ *
+ * @return {LogLevel} The log level.
+ */
+LogLevel logger_level(void)
+{
+    return g_LogLevel;
+}
+
+/**
+ * Logs a message at the normal level.
+ *
+ * @param {char*} fmt - The format string.
+ */
+void log_info(const char* fmt, ...)
+{
+    if (g_LogLevel < LogLevel::Normal)
+        return;
+
+    va_list args;
+    va_start(args, fmt);
+    logger_append(fmt, args);
+    va_end(args);
+}
+
+/**
+ * Logs a message at the verbose level.
+ *
+ * @param {char*} fmt - The format string.
+ */
+void log_verbose(const char* fmt, ...)
+{
+    if (g_LogLevel < LogLevel::Verbose)
+        return;
+
+    va_list args;
+    va_start(args, fmt);
+    logger_append(fmt, args);
+    va_end(args);
+}
+
+/**
+ * Logs an error message; errors are printed at every level.
+ *
+ * @param {char*} fmt - The format string.
+ */
+void log_error(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    logger_append(fmt, args);
+    va_end(args);
+}
+
+/**
+ * Starts the progress line.
+ *
+ * The line is only shown at the normal level; verbose output already reports every file.
+ *
+ * @param {uint64_t} totalFiles - The total count of files that will be processed.
+ */
+void progress_begin(const uint64_t totalFiles)
+{
+    g_ProgressFiles  = 0;
+    g_ProgressBytes  = 0;
+    g_ProgressTotal  = totalFiles;
+    g_ProgressStart  = std::chrono::steady_clock::now();
+    g_ProgressActive = g_LogLevel == LogLevel::Normal;
+}
+
+/**
+ * Adds processed files and bytes to the progress line.
+ *
+ * @param {uint64_t} files - The count of files processed.
+ * @param {uint64_t} bytes - The count of bytes written.
+ */
+void progress_add(const uint64_t files, const uint64_t bytes)
+{
+    g_ProgressFiles.fetch_add(files, std::memory_order_relaxed);
+    g_ProgressBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/**
+ * Finishes the progress line.
+ */
+void progress_end(void)
+{
+    if (!g_ProgressActive.exchange(false))
+        return;
+
+    std::unique_lock<std::mutex> lock(g_LogMutex);
+    if (!g_LogRunning)
+    {
+        lock.unlock();
+        progress_draw(true);
+        return;
+    }
+
+    // Have the writer draw the final line after the output queued before it..
+    g_ProgressFinish = true;
+    g_LogCondition.notify_all();
+    g_LogCondition.wait(lock, [] { return !g_ProgressFinish; });
+}
@@ -0,0 +1,83 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Buffered console logging and the rate-limited progress line.
+ */
+#ifndef DEPAK_LOGGER_H_INCLUDED
+#define DEPAK_LOGGER_H_INCLUDED
+
+#include <cstdint>
+
+/**
+ * Log Level Enumeration
+ *
+ */
+enum class LogLevel
+{
+    Quiet,   // Only errors are printed.
+    Normal,  // Summary messages and a progress line are printed.
+    Verbose, // Every parsed entry and saved file is printed.
+};
+
+/**
+ * Starts the background console writer. Until started (and after stopping), messages are printed directly.
+ *
+ * @param {LogLevel} level - The log level.
+ */
+void logger_start(const LogLevel level);
+
+/**
+ * Flushes all pending output, finishes the progress line and stops the background console writer.
+ */
+void logger_stop(void);
+
+/**
+ * Returns the current log level.
+ *
+ * @return {LogLevel} The log level.
+ */
+LogLevel logger_level(void);
+
+/**
+ * Logs a message at the normal level.
+ *
+ * @param {char*} fmt - The format string.
+ */
+void log_info(const char* fmt, ...);
+
+/**
+ * Logs a message at the verbose level.
+ *
+ * @param {char*} fmt - The format string.
+ */
+void log_verbose(const char* fmt, ...);
+
+/**
+ * Logs an error message; errors are printed at every level.
+ *
+ * @param {char*} fmt - The format string.
+ */
+void log_error(const char* fmt, ...);
+
+/**
+ * Starts the progress line.
+ *
+ * @param {uint64_t} totalFiles - The total count of files that will be processed.
+ */
+void progress_begin(const uint64_t totalFiles);
+
+/**
+ * Adds processed files and bytes to the progress line.
+ *
+ * @param {uint64_t} files - The count of files processed.
+ * @param {uint64_t} bytes - The count of bytes written.
+ */
+void progress_add(const uint64_t files, const uint64_t bytes);
+
+/**
+ * Finishes the progress line.
+ */
+void progress_end(void);
+
+#endif // DEPAK_LOGGER_H_INCLUDED
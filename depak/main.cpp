@@ -9,269 +9,466 @@
  */
 #include <Windows.h>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <string>
 #include <vector>
 
-#pragma comment(lib, "aplib.lib")
-#include "aplib.h"
-
-/**
- * PAK Header Structure
- *
- */
-struct pakheader_t
-{
-    uint32_t Signature;     // The file type signature.
-    uint32_t IsValid;       // Flag to determine if the file should be processed.
-    uint32_t Unknown00;     // Unknown - 0x00000010 - Used for the header-skip alignment for reading entries.
-    uint32_t Unknown01;     // Unknown - 0x00000100 - Used for the decompression alignment block sizes.
-    uint64_t EntriesOffset; // Offset to the block of entry information.
-    uint32_t Unknown02;     // Unknown - 0x00000000
-    uint32_t Unknown03;     // Unknown - 0x00000000
-};
-
-/**
- * PAK File Entry Structure
- *
- */
-struct pakfileentry_t
-{
-    uint32_t Crc;      // Used as the file name id which links to the string table id.
-    uint32_t Position; // The position where the file data block is stored.
-    uint32_t Size;     // The size of the file.
-};
-
-/**
- * PAK File Name Structure
- *
- */
-struct pakfilename_t
-{
-    uint32_t FileId;   // Links to the file entry crc.
-    uint32_t NameSize; // The size of the file name.
-    char Name[];       // The file name.
-};
-
-/**
- * PAK File Format Enumeration
- *
- */
-enum PakFileType
-{
-    CompressedBE      = 0x4B504B62,
-    CompressedLE      = 0x6C4B504B,
-    UncompressedBE    = 0x624B4150,
-    UncompressedLE    = 0x6C4B4150,
-    KaikoCompressedBE = 0x6252414B,
-    KaikoCompressedLE = 0x6C52414B,
-};
-
-/**
- * Saves a compressed file from a parent PAK file.
- *
- * @param {FILE*} f - The opened file pointer.
- * @param {std::string&} name - The file name.
- * @param {uint64_t} offset - The offset to the file data.
- * @param {uint32_t} size - The size of the file.
- */
-void save_compressed_file(FILE* f, const std::string& name, const uint64_t offset, const uint32_t size)
-{
-    // Step the file to the entry location..
-    _fseeki64(f, offset, SEEK_SET);
-
-    // Read the compressed file information..
-    uint32_t fileSize = 0;
-    uint32_t chunks   = 0;
-    fread(&fileSize, 4, 1, f);
-    fread(&chunks, 4, 1, f);
-
-    // Read and process the compressed data chunks..
-    std::vector<uint32_t> chunkSizes;
-    if (chunks > 0)
-    {
-        // Read the chunk sizes table..
-        for (std::size_t x = 0; x < chunks; x++)
-        {
-            uint32_t chunk = 0;
-            fread(&chunk, 4, 1, f);
-            chunkSizes.push_back(chunk);
-        }
-
-        // Read and decompress the chunks..
-        std::vector<uint8_t> fileData;
-        for (std::size_t x = 0; x < chunks; x++)
-        {
-            std::vector<uint8_t> bufferEnc(chunkSizes[x], u8'\0');
-            std::vector<uint8_t> bufferDec(4096, u8'\0');
-
-            // Read the current chunk encrypted data..
-            fread(bufferEnc.data(), 1, chunkSizes[x], f);
-
-            // Decompress the chunk data..
-            auto decSize = aP_depack_asm(bufferEnc.data(), bufferDec.data());
-            fileData.insert(fileData.end(), bufferDec.begin(), bufferDec.begin() + decSize);
-        }
-
-        // Save the decompressed file..
-        char filePath[MAX_PATH]{};
-        sprintf_s(filePath, u8"dump//%s", name.c_str());
-
-        FILE* out = nullptr;
-        if (fopen_s(&out, filePath, u8"wb") != ERROR_SUCCESS)
-            printf_s(u8"[!] Error: Failed to dump file: %s\r\n", filePath);
-        else
-        {
-            fwrite(fileData.data(), fileData.size(), 1, out);
-            fclose(out);
-        }
-    }
-}
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "analyze.h"
+#include "bufferpool.h"
+#include "codecbench.h"
+#include "entryview.h"
+#include "extract.h"
+#include "generator.h"
+#include "latency.h"
+#include "logger.h"
+#include "memstats.h"
+#include "metrics.h"
+#include "pak.h"
+#include "pakreader.h"
+#include "perf.h"
+#include "readbench.h"
+#include "recover.h"
+#include "stats.h"
+#include "stream.h"
+#include "tablebench.h"
+#include "trace.h"
 
 /**
  * Unsupported PAK file processor.
  */
 void process_pak_unsupported(void)
 {
-    printf_s(u8"[!] Error: PAK file type unsupported!\r\n");
+    log_error(u8"[!] Error: PAK file type unsupported!\r\n");
 }
 
 /**
  * PAK file processor for the file type: PakFileType::KaikoCompressedLE
  * 
  * @param {FILE*} f - The opened file pointer.
+ * @param {char*} path - The path of the opened file.
  * @param {long long} fileSize - The total size of the opened file.
  * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {extractoptions_t&} opts - The extraction options.
  */
-void process_pak_karl(FILE* f, const long long fileSize, const pakheader_t* header)
+void process_pak_karl(FILE* f, const char* path, const long long fileSize, const pakheader_t* header, const extractoptions_t& opts)
 {
     // Validate the incoming information..
     if (f == nullptr || fileSize == 0 || header->IsValid == 0)
     {
-        printf_s(u8"[!] Error: Invalid PAK information; cannot process.\r\n");
+        log_error(u8"[!] Error: Invalid PAK information; cannot process.\r\n");
         return;
     }
 
-    printf_s(u8"[!] Info: Processing PAK file type: Kaiko Compressed (Little Endian)\r\n\r\n");
+    log_info(u8"[!] Info: Processing PAK file type: Kaiko Compressed (Little Endian)\r\n\r\n");
 
-    std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> fileEntries;
+    std::vector<pakfileentry_t> fileEntries;
     std::vector<std::tuple<uint32_t, std::string>> stringEntries;
 
-    // Step the file to the entry table..
-    _fseeki64(f, header->EntriesOffset, SEEK_SET);
-
-    // Read the entry table information..
-    uint32_t eCount = 0; // The count of entries..
+    // Read the entry table..
     uint32_t sCount = 0; // The count of special entries..
-    fread(&eCount, 4, 1, f);
-    fread(&sCount, 4, 1, f);
+    if (!pak_read_entries(f, header, fileEntries, sCount))
+    {
+        log_error(u8"[!] Error: Failed to read the entries table; cannot continue to parse.\r\n");
+        return;
+    }
 
-    printf_s(u8"[!] Info: Entry Count: %d\r\n", eCount);
-    printf_s(u8"[!] Info: Entry Count: %d (Special)\r\n\r\n", sCount);
+    log_info(u8"[!] Info: Entry Count: %d\r\n", (uint32_t)fileEntries.size());
+    log_info(u8"[!] Info: Entry Count: %d (Special)\r\n\r\n", sCount);
 
     // Process the entries..
-    if (eCount > 0)
+    if (fileEntries.size() > 0 && logger_level() == LogLevel::Verbose)
     {
-        printf_s(u8"[!] Info: Parsing entries table...\r\n");
-
-        auto count = eCount;
-
-        do
-        {
-            // Read the current entry..
-            pakfileentry_t entry{};
-            fread(&entry, sizeof(entry), 1, f);
-
-            printf_s(u8"[!] Info: Entry found: (Crc: %08X)(Pos: %08X)(Size: %08X)\r\n", entry.Crc, entry.Position, entry.Size);
-
-            // Store the entry information..
-            fileEntries.push_back({entry.Crc, entry.Position, entry.Size});
-            count--;
-        } while (count > 0);
+        log_verbose(u8"[!] Info: Parsing entries table...\r\n");
 
-        // Sort the file list by its file position..
-        std::sort(fileEntries.begin(), fileEntries.end(), [](const std::tuple<uint32_t, uint32_t, uint32_t>& a, const std::tuple<uint32_t, uint32_t, uint32_t>& b) -> bool {
-            return std::get<1>(a) < std::get<1>(b);
-        });
+        for (const auto& entry : fileEntries)
+            log_verbose(u8"[!] Info: Entry found: (Crc: %08X)(Pos: %08X)(Size: %08X)\r\n", entry.Crc, entry.Position, entry.Size);
     }
 
     // Process the special entries..
     if (sCount > 0)
     {
-        printf_s(u8"[!] Info: Parsing special entries table...\r\n");
-        printf_s(u8"[!] Warning: Special entries are not currently supported.\r\n");
+        log_info(u8"[!] Info: Parsing special entries table...\r\n");
+        log_info(u8"[!] Warning: Special entries are not currently supported.\r\n");
     }
 
     // Process the string table entries (if available)..
-    if (eCount > 0)
+    if (fileEntries.size() > 0)
     {
-        printf_s(u8"[!] Info: Parsing strings table for file names...\r\n");
+        log_verbose(u8"[!] Info: Parsing strings table for file names...\r\n");
 
         // Obtain the string table entry..
         auto fileEntry = fileEntries.back();
         fileEntries.pop_back();
 
-        // Step the file to the string entry table..
-        _fseeki64(f, (uint64_t)std::get<1>(fileEntry) * header->Unknown00, SEEK_SET);
-
-        // Read the string table header..
-        uint32_t tSize = 0; // The string table size..
-        uint32_t unk00 = 0; // Unknown (Padding?)
-        fread(&tSize, 4, 1, f);
-        fread(&unk00, 4, 1, f);
-
-        // Validate the string table size..
-        if (tSize == 0)
+        // Parse the string table..
+        if (!pak_read_names(f, header, fileEntry, stringEntries))
         {
-            printf_s(u8"[!] Error: Invalid string table size; cannot continue to parse.\r\n");
+            log_error(u8"[!] Error: Invalid string table size; cannot continue to parse.\r\n");
             return;
         }
+    }
 
-        uint32_t sSize = 0;
+    // Resolve the output file names..
+    std::vector<std::string> names;
+    extract_resolve_names(fileEntries, stringEntries, names);
 
-        // Parse the string table..
-        do
-        {
-            // Read the file name data..
-            pakfilename_t name{0, 0};
-            fread(&name, sizeof(pakfilename_t), 1, f);
-
-            // Read the file name..
-            std::string fname(name.NameSize, u8'\0');
-            fread(fname.data(), 1, name.NameSize, f);
-
-            // Store the name entry..
-            stringEntries.push_back({name.FileId, fname});
-            sSize += sizeof(pakfilename_t) + name.NameSize;
-        } while (sSize < tSize);
+    // Finally, dump the files to disc with their proper names..
+    extractresult_t result{};
+    if (!extract_entries(path, header, fileEntries, names, opts, result))
+        return;
+
+    if (opts.Threads != 1 || opts.Io != ExtractIo::Stdio || opts.Sink != ExtractSink::File)
+        log_info(u8"[!] Info: Extracted %llu files (%llu failed) with %s / %s.\r\n", (unsigned long long)result.Files, (unsigned long long)result.Failures,
+            extract_io_name(opts.Io), extract_sink_name(opts.Sink));
+    if (opts.MemoryBudget > 0)
+        log_info(u8"[!] Info: Held at most %.2f MB of file data. (Budget: %.2f MB)\r\n", (double)result.PeakHeld / (1024.0 * 1024.0), (double)opts.MemoryBudget / (1024.0 * 1024.0));
+}
+
+/**
+ * PAK file processor for dumps limited to some of the files. (Only PakFileType::KaikoCompressedLE.)
+ *
+ * The entries are walked through a lazy view, so the decoded size is only read for the entries whose extension
+ * already matched.
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {std::vector<std::string>&} only - The extensions to keep. (Empty for every extension.)
+ * @param {uint64_t} minSize - The smallest decoded size to keep.
+ * @param {extractoptions_t&} opts - The extraction options.
+ */
+void process_pak_filtered(const char* path, const std::vector<std::string>& only, const uint64_t minSize, const extractoptions_t& opts)
+{
+    const auto reader = pak_open(path);
+    if (reader == nullptr)
+    {
+        log_error(u8"[!] Error: Failed to read the PAK file tables; cannot continue to parse.\r\n");
+        return;
     }
 
-    // Create the output dump folder..
-    ::CreateDirectory(u8"dump", nullptr);
+    log_info(u8"[!] Info: Processing PAK file type: Kaiko Compressed (Little Endian)\r\n\r\n");
+    log_info(u8"[!] Info: Entry Count: %d\r\n", pak_table_count(reader));
+    log_info(u8"[!] Info: Entry Count: %d (Special)\r\n\r\n", pak_special_count(reader));
 
-    // Finally, dump the files to disc with their proper names..
-    std::size_t unknownFileCount = 0;
-    std::for_each(fileEntries.begin(), fileEntries.end(), [&f, &header, &stringEntries, &unknownFileCount](const std::tuple<uint32_t, uint32_t, uint32_t>& e) {
-        // Obtain the files name if available..
-        const auto sentry = std::find_if(stringEntries.begin(), stringEntries.end(), [&e](const std::tuple<uint32_t, std::string>& se) -> bool { return std::get<0>(se) == std::get<0>(e); });
-        auto name         = sentry != stringEntries.end() ? std::get<1>(*sentry) : u8"";
-
-        // Construct an invalid file name if one was not found..
-        if (name.length() == 0)
+    const auto selected = pak_entries(reader)
+                          | entry_filter([&](const pakentry_t& e) -> bool {
+                                return only.empty() || std::any_of(only.begin(), only.end(), [&](const std::string& ext) -> bool { return e.has_extension(ext.c_str()); });
+                            })
+                          | entry_filter([&](const pakentry_t& e) -> bool { return minSize == 0 || e.file_size() >= minSize; });
+
+    extractresult_t result{};
+    if (extract_view(reader, selected, opts, result))
+        log_info(u8"[!] Info: Extracted %llu of %zu files (%llu failed) with %s / %s.\r\n", (unsigned long long)result.Files, pak_entry_count(reader),
+            (unsigned long long)result.Failures, extract_io_name(opts.Io), extract_sink_name(opts.Sink));
+
+    pak_close(reader);
+}
+
+/**
+ * PAK file processor for PAK files with a damaged header or entry table. (Any signature.)
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {uint32_t} alignment - The alignment of the file data. (0 uses the header alignment.)
+ * @param {extractoptions_t&} opts - The extraction options.
+ */
+void process_pak_recover(const char* path, const uint32_t alignment, const extractoptions_t& opts)
+{
+    extractresult_t result{};
+    if (!recover_pak(path, alignment, opts, result))
+        return;
+
+    log_info(u8"[!] Info: Recovered %llu files (%llu failed) with %s.\r\n", (unsigned long long)result.Files, (unsigned long long)result.Failures, extract_sink_name(opts.Sink));
+}
+
+/**
+ * PAK file processor for PAK files read from a non-seekable stream. (Only PakFileType::KaikoCompressedLE.)
+ *
+ * @param {FILE*} f - The opened input stream.
+ * @param {extractoptions_t&} opts - The extraction options.
+ */
+void process_pak_stream(FILE* f, const extractoptions_t& opts)
+{
+    extractresult_t result{};
+    if (!extract_stream(f, opts, result))
+        return;
+
+    log_info(u8"[!] Info: Extracted %llu files (%llu failed) with %s / %s.\r\n", (unsigned long long)result.Files, (unsigned long long)result.Failures,
+        extract_io_name(opts.Io), extract_sink_name(opts.Sink));
+    if (opts.MemoryBudget > 0)
+        log_info(u8"[!] Info: Held at most %.2f MB of file data. (Budget: %.2f MB)\r\n", (double)result.PeakHeld / (1024.0 * 1024.0), (double)opts.MemoryBudget / (1024.0 * 1024.0));
+}
+
+/**
+ * Command Line Options Structure
+ *
+ */
+struct options_t
+{
+    std::string Command;           // The requested command. (Empty for the default dump command.)
+    std::string Input;             // The input PAK file path. (The output PAK file path for generate.)
+    LogLevel Level;                // The console log level.
+    bool Stats;                    // Flag if per-phase statistics are printed after dumping.
+    bool Stream;                   // Flag if the input is read front to back as a non-seekable stream.
+    bool PerfCounters;             // Flag if hardware performance counters are printed after dumping.
+    bool Memory;                   // Flag if heap allocation accounting is printed after dumping.
+    bool Latency;                  // Flag if latency percentiles are printed after dumping.
+    std::string LatencyJson;       // The path to write the latency histograms to as json. (Empty if disabled.)
+    extractoptions_t Extract;      // The extraction options.
+    std::vector<std::string> Only; // The extensions to dump. (Empty for every file.)
+    uint64_t MinSize;              // The smallest decoded size of the files to dump.
+    std::string Trace;             // The path to write a Chrome trace-event file to. (Empty if disabled.)
+    std::string Metrics;           // The path to write Prometheus metrics to. (Empty if disabled.)
+    uint32_t MetricsInterval;      // The interval between metrics writes in milliseconds.
+    uint32_t SampleCount;          // codec-bench: The maximum count of entries to sample. (0 for all.)
+    genoptions_t Generate;         // generate: The generator options.
+    uint32_t ReadCount;            // read-bench: The count of random reads.
+    uint64_t ReadLength;           // read-bench: The length of each range read. (0 for whole entries.)
+    uint64_t ReadSeed;             // read-bench: The random seed.
+    uint64_t TableEntries;         // table-bench: The largest table size to parse.
+    uint32_t TableRepeat;          // table-bench: The count of timed runs per step.
+    uint64_t TableSeed;            // table-bench: The random seed.
+    double AnalyzeSample;          // analyze: The percentage of chunks decoded for timing. (0 to skip decoding.)
+    uint32_t RecoverAlignment;     // recover: The alignment of the file data. (0 uses the header alignment.)
+};
+
+/**
+ * Prints the command line usage information.
+ */
+void print_usage(void)
+{
+    printf_s(u8"Usage:\r\n");
+    printf_s(u8"  depak <file.pak>                              - Dumps the files of the PAK file.\r\n");
+    printf_s(u8"  depak [--stream] <pipe> | -                   - Dumps the files of a PAK file read from a pipe or standard input.\r\n");
+    printf_s(u8"  depak analyze [--sample <pct>] <file.pak>     - Reports compression per asset type and the chunk count distribution.\r\n");
+    printf_s(u8"  depak codec-bench [--sample <n>] <file.pak>   - Compares codecs over a sample of the PAK files entries.\r\n");
+    printf_s(u8"  depak generate [options] <out.pak>            - Writes a synthetic PAK file.\r\n");
+    printf_s(u8"  depak read-bench [options] <file.pak>         - Measures random read latency through the reader api.\r\n");
+    printf_s(u8"  depak recover [options] <file.pak>            - Scans a PAK file with a damaged header or entry table for its files and dumps them.\r\n");
+    printf_s(u8"  depak table-bench [options]                   - Measures entry and string table parsing on synthetic tables.\r\n\r\n");
+    printf_s(u8"Options:\r\n");
+    printf_s(u8"  -q, --quiet          - Only prints errors.\r\n");
+    printf_s(u8"  -v, --verbose        - Prints every parsed entry and saved file instead of the progress line.\r\n\r\n");
+    printf_s(u8"Dump options:\r\n");
+    printf_s(u8"  --threads <n>        - The count of extraction threads; 0 uses every hardware thread. (Default: 1)\r\n");
+    printf_s(u8"  --io <backend>       - stdio or mmap. (Default: stdio)\r\n");
+    printf_s(u8"  --sink <sink>        - file or null; null decodes without writing. (Default: file)\r\n");
+    printf_s(u8"  --huge-pages <mode>  - off, thp or explicit; backs the buffers and the mmap mapping with huge pages. (Default: off)\r\n");
+    printf_s(u8"  --memory-budget <mb> - Streams files in windows so all threads together hold at most this much file data.\r\n");
+    printf_s(u8"  --post <hook>        - Runs a post-process hook on each decoded file before it is written; a built-in\r\n");
+    printf_s(u8"                         name (xml-minify) or a shared library path. (May be repeated; run in order.)\r\n");
+    printf_s(u8"  --only <ext>         - Only dumps the files with this extension. (May be repeated.)\r\n");
+    printf_s(u8"  --min-size <kb>      - Only dumps the files of at least this decoded size.\r\n");
+    printf_s(u8"  --priority-list <file>\r\n                       - Extracts the files named in the list (one per line) first, then the rest.\r\n");
+    printf_s(u8"  --stream             - Reads the input front to back without seeking. (Implied for - and pipes.)\r\n");
+    printf_s(u8"  --spill-memory <mb>  - The MB of a streamed PAK file held in memory before it is spilled to disk. (Default: 256)\r\n");
+    printf_s(u8"  --spill-dir <dir>    - The directory of the spill file of a streamed PAK file. (Default: .)\r\n");
+    printf_s(u8"  --numa               - Pins the threads per NUMA node with node-local buffers and a share of the entries each.\r\n");
+    printf_s(u8"  --stats              - Prints per-phase timing and throughput statistics.\r\n");
+    printf_s(u8"  --latency            - Prints per-file extraction latency percentiles and the slowest files.\r\n");
+    printf_s(u8"  --latency-json <out> - Writes the latency histograms as json. (Also for read-bench.)\r\n");
+    printf_s(u8"  --memory             - Prints heap allocations per phase and per file, peak heap and peak RSS.\r\n");
+    printf_s(u8"  --perf-counters      - Prints cycles, IPC and branch / cache misses per KB of the read, decode and write phases. (Linux)\r\n");
+    printf_s(u8"  --trace <out.json>   - Writes per-thread read, decode and write spans in Chrome trace-event format.\r\n");
+    printf_s(u8"  --metrics <out.prom> - Writes Prometheus metrics to the file every interval. (Also for read-bench.)\r\n");
+    printf_s(u8"  --metrics-interval <ms>\r\n                       - The interval between metrics writes. (Default: 1000)\r\n\r\n");
+    printf_s(u8"Analyze options:\r\n");
+    printf_s(u8"  --sample <pct>       - Decodes this percentage of the chunks to measure decode time per MB. (Default: 0)\r\n\r\n");
+    printf_s(u8"Generate options:\r\n");
+    printf_s(u8"  --entries <n>        - The count of file entries. (Default: 1000)\r\n");
+    printf_s(u8"  --size <dist>        - fixed:<n>, uniform:<min>:<max> or lognormal:<median>:<sigma>. (Default: lognormal:16384:1.5)\r\n");
+    printf_s(u8"  --max-size <n>       - The maximum size of a single file. (Default: 67108864)\r\n");
+    printf_s(u8"  --profile <name>     - zeros, text, binary, random or mixed. (Default: mixed)\r\n");
+    printf_s(u8"  --names <min>:<max>  - The file name length range. (Default: 16:48)\r\n");
+    printf_s(u8"  --special <n>        - The count of special entries. (Default: 0)\r\n");
+    printf_s(u8"  --alignment <n>      - The file data alignment. (Default: 16)\r\n");
+    printf_s(u8"  --seed <n>           - The random seed. (Default: 1)\r\n\r\n");
+    printf_s(u8"Read-bench options:\r\n");
+    printf_s(u8"  --reads <n>          - The count of random reads. (Default: 10000)\r\n");
+    printf_s(u8"  --length <n>         - The length of each range read; 0 reads whole entries. (Default: 65536)\r\n");
+    printf_s(u8"  --seed <n>           - The random seed. (Default: 1)\r\n\r\n");
+    printf_s(u8"Recover options:\r\n");
+    printf_s(u8"  --alignment <n>      - The file data alignment scanned at. (Default: the header alignment, or 16 if damaged)\r\n");
+    printf_s(u8"  --threads <n>        - The count of scan and extraction threads; 0 uses every hardware thread. (Default: 1)\r\n");
+    printf_s(u8"  --sink <sink>        - file or null; null decodes without writing. (Default: file)\r\n\r\n");
+    printf_s(u8"Table-bench options:\r\n");
+    printf_s(u8"  --entries <n>        - The largest table size; sizes run from 10000 up in steps of ten. (Default: 10000000)\r\n");
+    printf_s(u8"  --repeat <n>         - The count of timed runs per step; the fastest is reported. (Default: 3)\r\n");
+    printf_s(u8"  --seed <n>           - The random seed. (Default: 1)\r\n");
+}
+
+/**
+ * Parses the command line options.
+ *
+ * @param {int32_t} argc - The count of parameters passed to the application.
+ * @param {char*[]} argv - The array of parameters passed to the application.
+ * @param {options_t&} opts - The options to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool parse_options(int32_t argc, char* argv[], options_t& opts)
+{
+    opts.Level           = LogLevel::Normal;
+    opts.SampleCount     = 500;
+    opts.Generate        = gen_default_options();
+    opts.Extract         = extract_default_options();
+    opts.MetricsInterval = 1000;
+    opts.ReadCount       = 10000;
+    opts.ReadLength      = 65536;
+    opts.ReadSeed        = 1;
+    opts.TableEntries    = 10000000;
+    opts.TableRepeat     = 3;
+    opts.TableSeed       = 1;
+
+    // Commands are given as the first parameter..
+    static const char* commands[] = {u8"analyze", u8"codec-bench", u8"generate", u8"read-bench", u8"recover", u8"table-bench"};
+
+    int32_t x = 1;
+    if (argc > 1 && std::any_of(std::begin(commands), std::end(commands), [&](const char* c) -> bool { return ::strcmp(argv[1], c) == 0; }))
+        opts.Command = argv[x++];
+
+    for (; x < argc; x++)
+    {
+        const auto arg   = argv[x];
+        const auto value = x + 1 < argc ? argv[x + 1] : nullptr;
+        const auto is    = [&](const char* cmd, const char* name) -> bool {
+            return opts.Command == cmd && value != nullptr && ::strcmp(arg, name) == 0;
+        };
+
+        bool valid = true;
+        if (::strcmp(arg, u8"-q") == 0 || ::strcmp(arg, u8"--quiet") == 0)
+        {
+            opts.Level = LogLevel::Quiet;
+            continue;
+        }
+        if (::strcmp(arg, u8"-v") == 0 || ::strcmp(arg, u8"--verbose") == 0)
         {
-            char fileName[MAX_PATH]{};
-            sprintf_s(fileName, u8"%08X.unknown_file", unknownFileCount);
-            name = fileName;
+            opts.Level = LogLevel::Verbose;
+            continue;
+        }
+        if (opts.Command.empty() && ::strcmp(arg, u8"--stats") == 0)
+        {
+            opts.Stats = true;
+            continue;
+        }
+        if (opts.Command.empty() && ::strcmp(arg, u8"--stream") == 0)
+        {
+            opts.Stream = true;
+            continue;
+        }
+        if (opts.Command.empty() && ::strcmp(arg, u8"--numa") == 0)
+        {
+            opts.Extract.Numa = true;
+            continue;
+        }
+        if (opts.Command.empty() && ::strcmp(arg, u8"--latency") == 0)
+        {
+            opts.Latency = true;
+            continue;
+        }
+        if (opts.Command.empty() && ::strcmp(arg, u8"--memory") == 0)
+        {
+            opts.Memory = true;
+            continue;
+        }
+        if (opts.Command.empty() && ::strcmp(arg, u8"--perf-counters") == 0)
+        {
+            opts.PerfCounters = true;
+            continue;
+        }
 
-            unknownFileCount++;
+        if (is(u8"", u8"--trace"))
+            opts.Trace = value;
+        else if (is(u8"", u8"--threads") || is(u8"recover", u8"--threads"))
+            opts.Extract.Threads = ::strtoul(value, nullptr, 10);
+        else if (is(u8"", u8"--io"))
+            valid = extract_parse_io(value, opts.Extract.Io);
+        else if (is(u8"", u8"--sink") || is(u8"recover", u8"--sink"))
+            valid = extract_parse_sink(value, opts.Extract.Sink);
+        else if (is(u8"", u8"--huge-pages"))
+            valid = huge_parse(value, opts.Extract.Pages);
+        else if (is(u8"", u8"--memory-budget"))
+            valid = (opts.Extract.MemoryBudget = ::strtoull(value, nullptr, 10) * 1024 * 1024) > 0;
+        else if (is(u8"", u8"--post"))
+        {
+            opts.Extract.Post.emplace_back();
+            valid = post_load(value, opts.Extract.Post.back());
+        }
+        else if (is(u8"", u8"--only"))
+            opts.Only.push_back(value[0] == '.' ? value : std::string(u8".") + value);
+        else if (is(u8"", u8"--min-size"))
+            opts.MinSize = ::strtoull(value, nullptr, 10) * 1024;
+        else if (is(u8"", u8"--priority-list"))
+            opts.Extract.Priority = value;
+        else if (is(u8"", u8"--spill-memory"))
+            opts.Extract.SpillMemory = ::strtoull(value, nullptr, 10) * 1024 * 1024;
+        else if (is(u8"", u8"--spill-dir"))
+            opts.Extract.SpillDir = value;
+        else if (is(u8"", u8"--latency-json") || is(u8"read-bench", u8"--latency-json"))
+            opts.LatencyJson = value;
+        else if (is(u8"", u8"--metrics") || is(u8"read-bench", u8"--metrics"))
+            opts.Metrics = value;
+        else if (is(u8"", u8"--metrics-interval") || is(u8"read-bench", u8"--metrics-interval"))
+            valid = (opts.MetricsInterval = ::strtoul(value, nullptr, 10)) > 0;
+        else if (is(u8"analyze", u8"--sample"))
+            valid = (opts.AnalyzeSample = ::strtod(value, nullptr)) >= 0 && opts.AnalyzeSample <= 100;
+        else if (is(u8"codec-bench", u8"--sample"))
+            opts.SampleCount = ::strtoul(value, nullptr, 10);
+        else if (is(u8"generate", u8"--entries"))
+            opts.Generate.EntryCount = ::strtoull(value, nullptr, 10);
+        else if (is(u8"generate", u8"--size"))
+            valid = gen_parse_size(value, opts.Generate);
+        else if (is(u8"generate", u8"--max-size"))
+            opts.Generate.MaxSize = ::strtoull(value, nullptr, 10);
+        else if (is(u8"generate", u8"--profile"))
+            valid = gen_parse_profile(value, opts.Generate);
+        else if (is(u8"generate", u8"--names"))
+            valid = ::sscanf_s(value, u8"%u:%u", &opts.Generate.NameMin, &opts.Generate.NameMax) == 2;
+        else if (is(u8"generate", u8"--special"))
+            opts.Generate.SpecialCount = ::strtoul(value, nullptr, 10);
+        else if (is(u8"generate", u8"--alignment"))
+            opts.Generate.Alignment = ::strtoul(value, nullptr, 10);
+        else if (is(u8"generate", u8"--seed"))
+            opts.Generate.Seed = ::strtoull(value, nullptr, 10);
+        else if (is(u8"read-bench", u8"--reads"))
+            opts.ReadCount = ::strtoul(value, nullptr, 10);
+        else if (is(u8"read-bench", u8"--length"))
+            opts.ReadLength = ::strtoull(value, nullptr, 10);
+        else if (is(u8"read-bench", u8"--seed"))
+            opts.ReadSeed = ::strtoull(value, nullptr, 10);
+        else if (is(u8"recover", u8"--alignment"))
+            valid = (opts.RecoverAlignment = ::strtoul(value, nullptr, 10)) > 0;
+        else if (is(u8"table-bench", u8"--entries"))
+            opts.TableEntries = ::strtoull(value, nullptr, 10);
+        else if (is(u8"table-bench", u8"--repeat"))
+            opts.TableRepeat = std::max(1ul, ::strtoul(value, nullptr, 10));
+        else if (is(u8"table-bench", u8"--seed"))
+            opts.TableSeed = ::strtoull(value, nullptr, 10);
+        else if (arg[0] == '-' && arg[1] == '-')
+        {
+            printf_s(u8"[!] Error: Unknown option: %s\r\n", arg);
+            return false;
+        }
+        else
+        {
+            opts.Input = arg;
+            continue;
         }
 
-        printf_s(u8"[!] Info: Saving file: %s\r\n", name.c_str());
+        if (!valid)
+        {
+            printf_s(u8"[!] Error: Invalid value for option %s: %s\r\n", arg, value);
+            return false;
+        }
 
-        // Dump the file..
-        save_compressed_file(f, name, (uint64_t)std::get<1>(e) * header->Unknown00, std::get<2>(e));
-    });
+        x++;
+    }
+
+    return true;
 }
 
 /**
@@ -283,59 +480,185 @@ void process_pak_karl(FILE* f, const long long fileSize, const pakheader_t* head
  */
 int32_t __cdecl main(int32_t argc, char* argv[])
 {
-    printf_s(u8"Kingdoms of Amalur: Rereckoning PAK Dumper\r\n");
-    printf_s(u8"(c) 2020 atom0s [atom0s@live.com]\r\n\r\n");
-    printf_s(u8"Personal site: https://atom0s.com/\r\n");
-    printf_s(u8"Donations    : https://paypal.me/atom0s\r\n\r\n");
+    // Parse the command line options..
+    options_t opts{};
+    const auto parsed = parse_options(argc, argv, opts);
+
+    // Start the console writer before any command runs so every command honors -q and -v..
+    logger_start(opts.Level);
+
+    if (opts.Level != LogLevel::Quiet)
+    {
+        printf_s(u8"Kingdoms of Amalur: Rereckoning PAK Dumper\r\n");
+        printf_s(u8"(c) 2020 atom0s [atom0s@live.com]\r\n\r\n");
+        printf_s(u8"Personal site: https://atom0s.com/\r\n");
+        printf_s(u8"Donations    : https://paypal.me/atom0s\r\n\r\n");
+    }
+
+    if (!parsed)
+    {
+        print_usage();
+        logger_stop();
+        return 0;
+    }
+
+    // Generate a synthetic PAK file..
+    if (opts.Command == u8"generate")
+    {
+        if (opts.Input.empty())
+        {
+            printf_s(u8"[!] Error: No output file given.\r\n\r\n");
+            print_usage();
+            logger_stop();
+            return 0;
+        }
+
+        gen_write_pak(opts.Input.c_str(), opts.Generate);
+
+        log_info(u8"\r\n\r\nDone!\r\n\r\n");
+        logger_stop();
+        return 0;
+    }
+
+    // Measure table parsing on synthetic tables..
+    if (opts.Command == u8"table-bench")
+    {
+        table_bench(opts.TableEntries, opts.TableRepeat, opts.TableSeed);
+
+        log_info(u8"\r\n\r\nDone!\r\n\r\n");
+        logger_stop();
+        return 0;
+    }
 
-    // Validate the incoming requested PAK file to dump..
-    if (argc < 2 || ::GetFileAttributes(argv[1]) == INVALID_FILE_ATTRIBUTES)
+    // Validate the incoming requested PAK file to dump; '-' reads standard input..
+    const auto standardInput = opts.Input == u8"-";
+    if (opts.Input.empty() || (!standardInput && ::GetFileAttributes(opts.Input.c_str()) == INVALID_FILE_ATTRIBUTES))
     {
-        printf_s(u8"[!] Error: No input file given.\r\n");
+        printf_s(u8"[!] Error: No input file given.\r\n\r\n");
+        print_usage();
+        logger_stop();
         return 0;
     }
 
+    stats_enable(opts.Stats);
+    if (opts.Memory)
+        mem_enable();
+    if (opts.Latency || !opts.LatencyJson.empty() || opts.Command == u8"read-bench")
+        latency_enable();
+    if (opts.PerfCounters)
+        perf_enable();
+    if (!opts.Trace.empty())
+        trace_open(opts.Trace.c_str());
+    if (!opts.Metrics.empty())
+        metrics_start(opts.Metrics.c_str(), opts.MetricsInterval);
+    const auto start = std::chrono::steady_clock::now();
+
     // Open the given file for reading..
     FILE* f = nullptr;
-    if (fopen_s(&f, argv[1], u8"rb") != ERROR_SUCCESS)
+    if (standardInput)
+    {
+#if defined(_WIN32)
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        f = stdin;
+    }
+    else if (fopen_s(&f, opts.Input.c_str(), u8"rb") != ERROR_SUCCESS)
     {
         printf_s(u8"[!] Error: Failed to open PAK file for reading.\r\n");
+        logger_stop();
         return 0;
     }
 
-    // Obtain the total file size..
-    _fseeki64(f, 0, SEEK_END);
-    const auto size = _ftelli64(f);
-    _fseeki64(f, 0, SEEK_SET);
-
-    // Validate the size is big enough for a PAK file header at least..
-    if (size < sizeof(pakheader_t))
+    // Inputs that cannot seek (pipes, standard input) are read front to back instead..
+    const auto stream = opts.Stream || standardInput || _fseeki64(f, 0, SEEK_END) != 0;
+    if (stream && (!opts.Only.empty() || opts.MinSize > 0))
     {
-        fclose(f);
-
-        printf_s(u8"[!] Error: Invalid file size; cannot parse PAK file.\r\n");
+        printf_s(u8"[!] Error: --only and --min-size need a seekable PAK file.\r\n");
+        if (f != stdin)
+            fclose(f);
+        logger_stop();
+        return 0;
+    }
+    if (stream && !opts.Command.empty())
+    {
+        printf_s(u8"[!] Error: The %s command needs a seekable PAK file.\r\n", opts.Command.c_str());
+        if (f != stdin)
+            fclose(f);
+        logger_stop();
         return 0;
     }
 
-    // Read the PAK header..
     pakheader_t header{};
-    fread(&header, sizeof(pakheader_t), 1, f);
+    long long size = 0;
+    if (!stream)
+    {
+        statscope_t scope(StatPhase::Header);
+
+        // Obtain the total file size..
+        size = _ftelli64(f);
+        _fseeki64(f, 0, SEEK_SET);
 
-    // Process the PAK file based on its signature type..
-    switch (header.Signature)
+        // Validate the size is big enough for a PAK file header at least..
+        if (size < (long long)sizeof(pakheader_t))
+        {
+            fclose(f);
+
+            printf_s(u8"[!] Error: Invalid file size; cannot parse PAK file.\r\n");
+            logger_stop();
+            return 0;
+        }
+
+        // Read the PAK header..
+        fread(&header, sizeof(pakheader_t), 1, f);
+    }
+
+    // Streams are checked once their header has been read; recovery does not trust the header at all..
+    if (stream)
+        process_pak_stream(f, opts.Extract);
+    else if (opts.Command == u8"recover")
+        process_pak_recover(opts.Input.c_str(), opts.RecoverAlignment, opts.Extract);
+    else
     {
-        case PakFileType::KaikoCompressedLE:
-            process_pak_karl(f, size, &header);
-            break;
-
-        // Unsupported formats..
-        default:
-            process_pak_unsupported();
-            break;
+        // Process the PAK file based on its signature type..
+        switch (header.Signature)
+        {
+            case PakFileType::KaikoCompressedLE:
+                if (opts.Command == u8"analyze")
+                    analyze_pak(f, &header, opts.AnalyzeSample);
+                else if (opts.Command == u8"codec-bench")
+                    codec_bench(f, &header, opts.SampleCount);
+                else if (opts.Command == u8"read-bench")
+                    read_bench(opts.Input.c_str(), opts.ReadCount, opts.ReadLength, opts.ReadSeed);
+                else if (!opts.Only.empty() || opts.MinSize > 0)
+                    process_pak_filtered(opts.Input.c_str(), opts.Only, opts.MinSize, opts.Extract);
+                else
+                    process_pak_karl(f, opts.Input.c_str(), size, &header, opts.Extract);
+                break;
+
+            // Unsupported formats..
+            default:
+                process_pak_unsupported();
+                break;
+        }
     }
 
-    printf_s(u8"\r\n\r\nDone!\r\n\r\n");
+    logger_stop();
+    trace_flush();
+    metrics_stop();
+
+    if (opts.Stats)
+        stats_print(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    perf_print();
+    mem_print();
+    pool_print();
+    latency_print();
+    if (!opts.LatencyJson.empty())
+        latency_write_json(opts.LatencyJson.c_str());
 
-    fclose(f);
+    post_unload();
+    log_info(u8"\r\n\r\nDone!\r\n\r\n");
+
+    if (f != stdin)
+        fclose(f);
     return 0;
 }
@@ -0,0 +1,142 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Global allocation operator replacements feeding the heap allocation accounting. (Linked into the depak executable
+ * only; libdepak, the Python module and other hosts of the core keep their own allocator.)
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#include "memstats.h"
+
+/**
+ * The size of the header in front of every block; it holds the bytes the block added to the live heap, so blocks
+ * allocated before accounting was enabled are never taken off of it.
+ */
+constexpr std::size_t MEM_HEADER = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+/**
+ * Allocates a heap block behind its header.
+ *
+ * @param {std::size_t} size - The requested size.
+ * @param {std::size_t} alignment - The alignment of the block.
+ * @return {void*} The block on success, nullptr otherwise.
+ */
+static void* mem_alloc(const std::size_t size, const std::size_t alignment)
+{
+    // Over-aligned blocks keep their alignment by using a whole alignment step as the header..
+    const auto header = std::max(alignment, MEM_HEADER);
+    if (size > SIZE_MAX - header)
+        return nullptr;
+
+    void* block = nullptr;
+#if defined(_WIN32)
+    block = alignment > MEM_HEADER ? ::_aligned_malloc(header + size, alignment) : std::malloc(header + size);
+#else
+    if (alignment <= MEM_HEADER)
+        block = std::malloc(header + size);
+    else if (::posix_memalign(&block, alignment, header + size) != 0)
+        block = nullptr;
+#endif
+    if (block == nullptr)
+        return nullptr;
+
+    const auto p     = (uint8_t*)block + header;
+    const auto bytes = mem_record_alloc(size);
+    ::memcpy(p - sizeof(bytes), &bytes, sizeof(bytes));
+    return p;
+}
+
+/**
+ * Releases a heap block allocated by mem_alloc.
+ *
+ * @param {void*} p - The block.
+ * @param {std::size_t} alignment - The alignment the block was allocated with.
+ */
+static void mem_free(void* p, const std::size_t alignment)
+{
+    if (p == nullptr)
+        return;
+
+    uint64_t bytes = 0;
+    ::memcpy(&bytes, (uint8_t*)p - sizeof(bytes), sizeof(bytes));
+    mem_record_free(bytes);
+
+    const auto block = (uint8_t*)p - std::max(alignment, MEM_HEADER);
+#if defined(_WIN32)
+    if (alignment > MEM_HEADER)
+        ::_aligned_free(block);
+    else
+        std::free(block);
+#else
+    std::free(block);
+#endif
+}
+
+/**
+ * Global allocation operator replacements.
+ *
+ * The nothrow and sized forms of the standard library forward to these, so every operator new allocation is seen.
+ */
+void* operator new(std::size_t size)
+{
+    const auto p = mem_alloc(size, MEM_HEADER);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    const auto p = mem_alloc(size, (std::size_t)alignment);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return ::operator new(size, alignment);
+}
+void operator delete(void* p) noexcept
+{
+    mem_free(p, MEM_HEADER);
+}
+void operator delete[](void* p) noexcept
+{
+    ::operator delete(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+    ::operator delete(p);
+}
+void operator delete[](void* p, std::size_t) noexcept
+{
+    ::operator delete(p);
+}
+void operator delete(void* p, std::align_val_t alignment) noexcept
+{
+    mem_free(p, (std::size_t)alignment);
+}
+void operator delete[](void* p, std::align_val_t alignment) noexcept
+{
+    ::operator delete(p, alignment);
+}
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+    ::operator delete(p, alignment);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+    ::operator delete(p, alignment);
+}
@@ -0,0 +1,205 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Heap allocation accounting per phase and per file, and peak RSS sampling.
+ */
+#include <Windows.h>
+#include <atomic>
+
+#if defined(_WIN32)
+#include <Psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include "memstats.h"
+#include "stats.h"
+
+/**
+ * Memory Phase Counters Structure
+ *
+ */
+struct memphase_t
+{
+    std::atomic<uint64_t> Allocs; // The count of allocations made in the phase.
+    std::atomic<uint64_t> Bytes;  // The count of bytes requested in the phase.
+};
+
+/**
+ * Memory accounting state.
+ *
+ * Everything here is constant-initialized so the allocation hook is safe to run before (and after) any other
+ * static construction.
+ */
+static std::atomic<bool> g_MemEnabled{false};
+static memphase_t g_MemPhases[(int)StatPhase::Count + 1];
+static std::atomic<int64_t> g_MemLive{0};
+static std::atomic<int64_t> g_MemPeak{0};
+static std::atomic<uint64_t> g_MemFiles{0};
+static std::atomic<uint64_t> g_MemFileAllocs{0};
+static std::atomic<uint64_t> g_MemFileMaxAllocs{0};
+static std::atomic<uint64_t> g_MemFileMaxBytes{0};
+static std::atomic<uint64_t> g_MemFileZero{0};
+static thread_local int32_t t_MemPhase = (int32_t)StatPhase::Count;
+static thread_local memsnapshot_t t_MemThread{};
+
+/**
+ * Raises an atomic maximum to the given value.
+ *
+ * @param {std::atomic<T>&} max - The maximum to raise.
+ * @param {T} value - The new value.
+ */
+template<typename T>
+static void mem_raise(std::atomic<T>& max, const T value)
+{
+    auto current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * Accounts a new heap allocation.
+ *
+ * @param {std::size_t} size - The requested size.
+ * @return {uint64_t} The bytes added to the live heap, to be handed back to mem_record_free. (0 when disabled.)
+ */
+uint64_t mem_record_alloc(const std::size_t size)
+{
+    if (!g_MemEnabled.load(std::memory_order_relaxed))
+        return 0;
+
+    auto& phase = g_MemPhases[t_MemPhase];
+    phase.Allocs.fetch_add(1, std::memory_order_relaxed);
+    phase.Bytes.fetch_add(size, std::memory_order_relaxed);
+
+    t_MemThread.Allocs++;
+    t_MemThread.Bytes += size;
+
+    mem_raise(g_MemPeak, g_MemLive.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size);
+    return size;
+}
+
+/**
+ * Accounts a heap block being released.
+ *
+ * @param {uint64_t} bytes - The bytes the block added to the live heap. (From mem_record_alloc.)
+ */
+void mem_record_free(const uint64_t bytes)
+{
+    if (bytes != 0)
+        g_MemLive.fetch_sub((int64_t)bytes, std::memory_order_relaxed);
+}
+
+/**
+ * Enables heap allocation accounting.
+ */
+void mem_enable(void)
+{
+    g_MemEnabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * Returns if heap allocation accounting is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool mem_enabled(void)
+{
+    return g_MemEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Sets the phase the calling threads allocations are accounted to.
+ *
+ * @param {int32_t} phase - The phase index. (StatPhase::Count for allocations outside of any phase.)
+ * @return {int32_t} The previous phase index.
+ */
+int32_t mem_set_phase(const int32_t phase)
+{
+    const auto previous = t_MemPhase;
+    t_MemPhase          = phase;
+    return previous;
+}
+
+/**
+ * Returns the calling threads allocation counters.
+ *
+ * @return {memsnapshot_t} The allocation counters.
+ */
+memsnapshot_t mem_snapshot(void)
+{
+    return t_MemThread;
+}
+
+/**
+ * Records an extracted file and the allocations made by the calling thread since the given snapshot.
+ *
+ * @param {memsnapshot_t&} begin - The snapshot taken before the file was processed.
+ */
+void mem_add_file(const memsnapshot_t& begin)
+{
+    if (!mem_enabled())
+        return;
+
+    const auto allocs = t_MemThread.Allocs - begin.Allocs;
+    const auto bytes  = t_MemThread.Bytes - begin.Bytes;
+
+    g_MemFiles.fetch_add(1, std::memory_order_relaxed);
+    g_MemFileAllocs.fetch_add(allocs, std::memory_order_relaxed);
+    mem_raise(g_MemFileMaxAllocs, allocs);
+    mem_raise(g_MemFileMaxBytes, bytes);
+    if (allocs == 0)
+        g_MemFileZero.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Returns the peak resident set size of the process.
+ *
+ * @return {uint64_t} The peak resident set size in bytes.
+ */
+uint64_t mem_peak_rss(void)
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (!::GetProcessMemoryInfo(::GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return 0;
+    return pmc.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    if (::getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+/**
+ * Prints the allocation accounting summary.
+ */
+void mem_print(void)
+{
+    if (!mem_enabled())
+        return;
+
+    const auto mb = [](const double bytes) -> double { return bytes / (1024.0 * 1024.0); };
+
+    printf_s(u8"\r\n[!] Memory: (operator new allocations; summed over threads)\r\n");
+    printf_s(u8"    %-14s %12s %12s\r\n", u8"Phase", u8"Allocs", u8"MB");
+    for (auto x = 0; x <= (int)StatPhase::Count; x++)
+    {
+        const auto allocs = g_MemPhases[x].Allocs.load(std::memory_order_relaxed);
+        const auto bytes  = g_MemPhases[x].Bytes.load(std::memory_order_relaxed);
+        printf_s(u8"    %-14s %12llu %12.2f\r\n", x < (int)StatPhase::Count ? stats_phase_name((StatPhase)x) : u8"other",
+            (unsigned long long)allocs, mb((double)bytes));
+    }
+
+    const auto files = g_MemFiles.load(std::memory_order_relaxed);
+    printf_s(u8"    Files          : %llu (%llu without allocations)\r\n", (unsigned long long)files, (unsigned long long)g_MemFileZero.load(std::memory_order_relaxed));
+    printf_s(u8"    Allocs / file  : %.2f avg, %llu max\r\n", files > 0 ? (double)g_MemFileAllocs.load(std::memory_order_relaxed) / (double)files : 0.0,
+        (unsigned long long)g_MemFileMaxAllocs.load(std::memory_order_relaxed));
+    printf_s(u8"    Bytes / file   : %.2f MB max requested\r\n", mb((double)g_MemFileMaxBytes.load(std::memory_order_relaxed)));
+    printf_s(u8"    Peak heap      : %.2f MB\r\n", mb((double)g_MemPeak.load(std::memory_order_relaxed)));
+    printf_s(u8"    Peak RSS       : %.2f MB\r\n", mb((double)mem_peak_rss()));
+}
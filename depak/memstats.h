@@ -0,0 +1,87 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Heap allocation accounting per phase and per file, and peak RSS sampling.
+ */
+#ifndef DEPAK_MEMSTATS_H_INCLUDED
+#define DEPAK_MEMSTATS_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+enum class StatPhase;
+
+/**
+ * Memory Snapshot Structure
+ *
+ * The allocation counters of a single thread at a point in time.
+ */
+struct memsnapshot_t
+{
+    uint64_t Allocs; // The count of allocations made by the thread.
+    uint64_t Bytes;  // The count of bytes requested by the thread.
+};
+
+/**
+ * Enables heap allocation accounting.
+ */
+void mem_enable(void);
+
+/**
+ * Returns if heap allocation accounting is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool mem_enabled(void);
+
+/**
+ * Accounts a new heap allocation. (Called by the allocation operator replacements of memhooks.cpp.)
+ *
+ * @param {std::size_t} size - The requested size.
+ * @return {uint64_t} The bytes added to the live heap, to be handed back to mem_record_free. (0 when disabled.)
+ */
+uint64_t mem_record_alloc(const std::size_t size);
+
+/**
+ * Accounts a heap block being released. (Called by the allocation operator replacements of memhooks.cpp.)
+ *
+ * @param {uint64_t} bytes - The bytes the block added to the live heap. (From mem_record_alloc.)
+ */
+void mem_record_free(const uint64_t bytes);
+
+/**
+ * Sets the phase the calling threads allocations are accounted to.
+ *
+ * @param {int32_t} phase - The phase index. (StatPhase::Count for allocations outside of any phase.)
+ * @return {int32_t} The previous phase index.
+ */
+int32_t mem_set_phase(const int32_t phase);
+
+/**
+ * Returns the calling threads allocation counters.
+ *
+ * @return {memsnapshot_t} The allocation counters.
+ */
+memsnapshot_t mem_snapshot(void);
+
+/**
+ * Records an extracted file and the allocations made by the calling thread since the given snapshot.
+ *
+ * @param {memsnapshot_t&} begin - The snapshot taken before the file was processed.
+ */
+void mem_add_file(const memsnapshot_t& begin);
+
+/**
+ * Returns the peak resident set size of the process.
+ *
+ * @return {uint64_t} The peak resident set size in bytes.
+ */
+uint64_t mem_peak_rss(void);
+
+/**
+ * Prints the allocation accounting summary.
+ */
+void mem_print(void);
+
+#endif // DEPAK_MEMSTATS_H_INCLUDED
@@ -0,0 +1,296 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Service metrics exported in the Prometheus text format.
+ */
+#include <Windows.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "memstats.h"
+#include "metrics.h"
+
+/**
+ * Metrics Block Structure
+ *
+ * The counters of a single thread. Only the owning thread writes them, so updates are a relaxed load and store
+ * without a locked instruction; the exporter reads them with relaxed loads. Aligned so blocks never share a cache line.
+ */
+struct alignas(64) metricsblock_t
+{
+    std::atomic<uint64_t> Values[(int)MetricCounter::Count];
+};
+
+/**
+ * Metric Description Structure
+ *
+ */
+struct metricdesc_t
+{
+    const char* Name; // The exported metric name.
+    const char* Help; // The metric help text.
+    double Scale;     // The factor applied when exporting. (Converts nanoseconds to seconds.)
+};
+
+/**
+ * The exported counters, in MetricCounter order.
+ */
+static const metricdesc_t g_MetricCounters[] = {
+    {u8"depak_files_total", u8"Files extracted.", 1.0},
+    {u8"depak_file_bytes_total", u8"Decompressed bytes of the extracted files.", 1.0},
+    {u8"depak_compressed_bytes_total", u8"Compressed bytes read for the extracted files.", 1.0},
+    {u8"depak_reads_total", u8"Reads served through the reader api.", 1.0},
+    {u8"depak_read_bytes_total", u8"Decompressed bytes served through the reader api.", 1.0},
+    {u8"depak_read_seconds_total", u8"Time spent reading compressed data.", 1e-9},
+    {u8"depak_decode_seconds_total", u8"Time spent decompressing data.", 1e-9},
+    {u8"depak_write_seconds_total", u8"Time spent writing decompressed data.", 1e-9},
+    {u8"depak_errors_total", u8"Failed extractions and reads.", 1.0},
+};
+
+/**
+ * The exported gauges, in MetricGauge order.
+ */
+static const metricdesc_t g_MetricGauges[] = {
+    {u8"depak_queue_depth", u8"Entries waiting to be extracted.", 1.0},
+    {u8"depak_active_workers", u8"Extraction workers running.", 1.0},
+    {u8"depak_inflight_reads", u8"Reader api reads in progress, including those waiting for the file.", 1.0},
+};
+
+/**
+ * Metrics state.
+ */
+static std::atomic<bool> g_MetricsEnabled{false};
+static std::mutex g_MetricsMutex;
+static std::vector<std::unique_ptr<metricsblock_t>> g_MetricsBlocks;
+static std::atomic<int64_t> g_MetricsGauges[(int)MetricGauge::Count];
+static std::chrono::steady_clock::time_point g_MetricsStart = std::chrono::steady_clock::now();
+
+/**
+ * Metrics writer state.
+ */
+static std::mutex g_MetricsWriterMutex;
+static std::condition_variable g_MetricsWriterCondition;
+static std::thread g_MetricsWriterThread;
+static std::string g_MetricsWriterPath;
+static bool g_MetricsWriterRunning = false;
+
+/**
+ * Returns the calling threads metrics block.
+ *
+ * @return {metricsblock_t*} The block of the calling thread.
+ */
+static metricsblock_t* metrics_thread(void)
+{
+    thread_local metricsblock_t* block = nullptr;
+    if (block == nullptr)
+    {
+        // Blocks are owned by the registry so counts of finished threads are kept..
+        std::lock_guard<std::mutex> lock(g_MetricsMutex);
+        g_MetricsBlocks.push_back(std::make_unique<metricsblock_t>());
+        block = g_MetricsBlocks.back().get();
+    }
+    return block;
+}
+
+/**
+ * Enables metrics collection. Counting stays off (and costs a single flag check) until enabled.
+ */
+void metrics_enable(void)
+{
+    g_MetricsEnabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * Returns if metrics collection is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool metrics_enabled(void)
+{
+    return g_MetricsEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Adds to a counter of the calling thread. Each thread owns its counters, so this never contends.
+ *
+ * @param {MetricCounter} counter - The counter.
+ * @param {uint64_t} value - The value to add.
+ */
+void metrics_add(const MetricCounter counter, const uint64_t value)
+{
+    if (!metrics_enabled())
+        return;
+
+    auto& v = metrics_thread()->Values[(int)counter];
+    v.store(v.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * Adds to a gauge.
+ *
+ * @param {MetricGauge} gauge - The gauge.
+ * @param {int64_t} delta - The value to add. (Negative to subtract.)
+ */
+void metrics_gauge_add(const MetricGauge gauge, const int64_t delta)
+{
+    if (metrics_enabled())
+        g_MetricsGauges[(int)gauge].fetch_add(delta, std::memory_order_relaxed);
+}
+
+/**
+ * Sets a gauge.
+ *
+ * @param {MetricGauge} gauge - The gauge.
+ * @param {int64_t} value - The value.
+ */
+void metrics_gauge_set(const MetricGauge gauge, const int64_t value)
+{
+    if (metrics_enabled())
+        g_MetricsGauges[(int)gauge].store(value, std::memory_order_relaxed);
+}
+
+/**
+ * Formats the current metrics in the Prometheus text exposition format.
+ *
+ * @return {std::string} The formatted metrics.
+ */
+std::string metrics_format(void)
+{
+    uint64_t totals[(int)MetricCounter::Count]{};
+    {
+        std::lock_guard<std::mutex> lock(g_MetricsMutex);
+        for (const auto& b : g_MetricsBlocks)
+        {
+            for (auto x = 0; x < (int)MetricCounter::Count; x++)
+                totals[x] += b->Values[x].load(std::memory_order_relaxed);
+        }
+    }
+
+    std::string out;
+    char line[256]{};
+
+    const auto add = [&](const metricdesc_t& d, const char* type, const double value) {
+        sprintf_s(line, u8"# HELP %s %s\n# TYPE %s %s\n%s %.17g\n", d.Name, d.Help, d.Name, type, d.Name, value);
+        out += line;
+    };
+
+    for (auto x = 0; x < (int)MetricCounter::Count; x++)
+        add(g_MetricCounters[x], u8"counter", (double)totals[x] * g_MetricCounters[x].Scale);
+    for (auto x = 0; x < (int)MetricGauge::Count; x++)
+        add(g_MetricGauges[x], u8"gauge", (double)g_MetricsGauges[x].load(std::memory_order_relaxed));
+
+    add({u8"depak_uptime_seconds", u8"Time since the process started.", 1.0}, u8"gauge", std::chrono::duration<double>(std::chrono::steady_clock::now() - g_MetricsStart).count());
+    add({u8"depak_peak_rss_bytes", u8"Peak resident set size of the process.", 1.0}, u8"gauge", (double)mem_peak_rss());
+
+    return out;
+}
+
+/**
+ * Writes the current metrics to a file. The file is replaced atomically so scrapers never see a partial file.
+ *
+ * @param {char*} path - The file path.
+ * @return {bool} True on success, false otherwise.
+ */
+bool metrics_write(const char* path)
+{
+    const auto text = metrics_format();
+    const auto temp = std::string(path) + u8".tmp";
+
+    FILE* f = nullptr;
+    if (fopen_s(&f, temp.c_str(), u8"wb") != ERROR_SUCCESS)
+        return false;
+
+    const auto written = fwrite(text.data(), 1, text.size(), f) == text.size();
+    if (fclose(f) != 0 || !written)
+        return false;
+
+#if defined(_WIN32)
+    return ::MoveFileExA(temp.c_str(), path, MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+    return std::rename(temp.c_str(), path) == 0;
+#endif
+}
+
+/**
+ * Background metrics writer thread.
+ *
+ * @param {uint32_t} intervalMs - The interval between writes in milliseconds.
+ */
+static void metrics_thread_writer(const uint32_t intervalMs)
+{
+    std::unique_lock<std::mutex> lock(g_MetricsWriterMutex);
+    while (g_MetricsWriterRunning)
+    {
+        g_MetricsWriterCondition.wait_for(lock, std::chrono::milliseconds(intervalMs));
+
+        // Write outside of the lock so stopping is never delayed by a slow disk..
+        const auto path = g_MetricsWriterPath;
+        lock.unlock();
+        metrics_write(path.c_str());
+        lock.lock();
+    }
+}
+
+/**
+ * Enables metrics collection and starts a background thread that writes them to a file at the given interval.
+ *
+ * @param {char*} path - The file path.
+ * @param {uint32_t} intervalMs - The interval between writes in milliseconds.
+ */
+void metrics_start(const char* path, const uint32_t intervalMs)
+{
+    metrics_enable();
+
+    std::lock_guard<std::mutex> lock(g_MetricsWriterMutex);
+    if (g_MetricsWriterRunning)
+        return;
+
+    g_MetricsWriterPath    = path;
+    g_MetricsWriterRunning = true;
+    g_MetricsWriterThread  = std::thread(metrics_thread_writer, intervalMs == 0 ? 1000 : intervalMs);
+}
+
+/**
+ * Stops the background writer after writing the metrics one last time.
+ */
+void metrics_stop(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_MetricsWriterMutex);
+        if (!g_MetricsWriterRunning)
+            return;
+
+        g_MetricsWriterRunning = false;
+    }
+
+    g_MetricsWriterCondition.notify_all();
+    g_MetricsWriterThread.join();
+
+    if (!metrics_write(g_MetricsWriterPath.c_str()))
+        printf_s(u8"[!] Error: Failed to write metrics file: %s\r\n", g_MetricsWriterPath.c_str());
+}
+
+/**
+ * Constructor and Destructor
+ *
+ * @param {MetricGauge} gauge - The gauge to add one to for the lifetime of the scope.
+ */
+metricsgauge_t::metricsgauge_t(const MetricGauge gauge)
+    : m_Gauge(gauge)
+    , m_Enabled(metrics_enabled())
+{
+    if (m_Enabled)
+        g_MetricsGauges[(int)m_Gauge].fetch_add(1, std::memory_order_relaxed);
+}
+metricsgauge_t::~metricsgauge_t(void)
+{
+    if (m_Enabled)
+        g_MetricsGauges[(int)m_Gauge].fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,125 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Service metrics exported in the Prometheus text format.
+ */
+#ifndef DEPAK_METRICS_H_INCLUDED
+#define DEPAK_METRICS_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Metric Counter Enumeration
+ *
+ */
+enum class MetricCounter
+{
+    Files,           // Files extracted.
+    FileBytes,       // Decompressed bytes of the extracted files.
+    CompressedBytes, // Compressed bytes read for the extracted files.
+    Reads,           // Reads served through the reader api.
+    ReadBytes,       // Decompressed bytes served through the reader api.
+    ReadNs,          // Time spent reading compressed data.
+    DecodeNs,        // Time spent decompressing data.
+    WriteNs,         // Time spent writing decompressed data.
+    Errors,          // Failed extractions and reads.
+    Count
+};
+
+/**
+ * Metric Gauge Enumeration
+ *
+ */
+enum class MetricGauge
+{
+    QueueDepth,    // Entries waiting to be extracted.
+    ActiveWorkers, // Extraction workers running.
+    InFlightReads, // Reader api reads in progress, including those waiting for the file.
+    Count
+};
+
+/**
+ * Enables metrics collection. Counting stays off (and costs a single flag check) until enabled.
+ */
+void metrics_enable(void);
+
+/**
+ * Returns if metrics collection is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool metrics_enabled(void);
+
+/**
+ * Adds to a counter of the calling thread. Each thread owns its counters, so this never contends.
+ *
+ * @param {MetricCounter} counter - The counter.
+ * @param {uint64_t} value - The value to add.
+ */
+void metrics_add(const MetricCounter counter, const uint64_t value);
+
+/**
+ * Adds to a gauge.
+ *
+ * @param {MetricGauge} gauge - The gauge.
+ * @param {int64_t} delta - The value to add. (Negative to subtract.)
+ */
+void metrics_gauge_add(const MetricGauge gauge, const int64_t delta);
+
+/**
+ * Sets a gauge.
+ *
+ * @param {MetricGauge} gauge - The gauge.
+ * @param {int64_t} value - The value.
+ */
+void metrics_gauge_set(const MetricGauge gauge, const int64_t value);
+
+/**
+ * Formats the current metrics in the Prometheus text exposition format.
+ *
+ * @return {std::string} The formatted metrics.
+ */
+std::string metrics_format(void);
+
+/**
+ * Writes the current metrics to a file. The file is replaced atomically so scrapers never see a partial file.
+ *
+ * @param {char*} path - The file path.
+ * @return {bool} True on success, false otherwise.
+ */
+bool metrics_write(const char* path);
+
+/**
+ * Enables metrics collection and starts a background thread that writes them to a file at the given interval.
+ *
+ * @param {char*} path - The file path.
+ * @param {uint32_t} intervalMs - The interval between writes in milliseconds.
+ */
+void metrics_start(const char* path, const uint32_t intervalMs);
+
+/**
+ * Stops the background writer after writing the metrics one last time.
+ */
+void metrics_stop(void);
+
+/**
+ * Metrics Gauge Scope Structure
+ *
+ * Adds one to a gauge for the lifetime of the scope, when metrics are enabled.
+ */
+struct metricsgauge_t
+{
+    metricsgauge_t(const MetricGauge gauge);
+    ~metricsgauge_t(void);
+
+    metricsgauge_t(const metricsgauge_t&) = delete;
+    metricsgauge_t& operator=(const metricsgauge_t&) = delete;
+
+private:
+    MetricGauge m_Gauge;
+    bool m_Enabled;
+};
+
+#endif // DEPAK_METRICS_H_INCLUDED
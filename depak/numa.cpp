@@ -0,0 +1,189 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * NUMA topology, thread placement and memory binding.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "numa.h"
+
+#if defined(__linux__)
+
+/**
+ * Parses a Linux cpu list. (ie. 0-3,8,10-11)
+ *
+ * @param {char*} list - The cpu list.
+ * @param {std::vector<uint32_t>&} cpus - The vector to receive the processors.
+ */
+static void numa_parse_cpulist(const char* list, std::vector<uint32_t>& cpus)
+{
+    auto p = list;
+    while (*p != '\0' && *p != '\n')
+    {
+        char* end    = nullptr;
+        const auto a = (uint32_t)::strtoul(p, &end, 10);
+        auto b       = a;
+        if (end == p)
+            break;
+
+        p = end;
+        if (*p == '-')
+        {
+            b = (uint32_t)::strtoul(p + 1, &end, 10);
+            p = end;
+        }
+
+        for (auto x = a; x <= b; x++)
+            cpus.push_back(x);
+
+        if (*p == ',')
+            p++;
+    }
+}
+
+#endif
+
+/**
+ * Reads the NUMA nodes of the machine that have processors.
+ *
+ * @param {std::vector<numanode_t>&} nodes - The vector to receive the nodes.
+ * @return {bool} True on success, false if the topology could not be read.
+ */
+bool numa_nodes(std::vector<numanode_t>& nodes)
+{
+    nodes.clear();
+
+#if defined(_WIN32)
+    ULONG highest = 0;
+    if (!::GetNumaHighestNodeNumber(&highest))
+        return false;
+
+    for (ULONG x = 0; x <= highest; x++)
+    {
+        GROUP_AFFINITY affinity{};
+        if (!::GetNumaNodeProcessorMaskEx((USHORT)x, &affinity) || affinity.Mask == 0)
+            continue;
+
+        numanode_t node{};
+        node.Id = x;
+        for (uint32_t bit = 0; bit < 64; bit++)
+        {
+            if (affinity.Mask & ((KAFFINITY)1 << bit))
+                node.Cpus.push_back((uint32_t)affinity.Group * 64 + bit);
+        }
+        nodes.push_back(node);
+    }
+#elif defined(__linux__)
+    // Nodes are listed in sysfs; memory-only nodes have an empty cpu list..
+    FILE* online = nullptr;
+    if (fopen_s(&online, u8"/sys/devices/system/node/online", u8"rb") != ERROR_SUCCESS)
+        return false;
+
+    char list[1024]{};
+    const auto read = fgets(list, sizeof(list), online) != nullptr;
+    fclose(online);
+    if (!read)
+        return false;
+
+    std::vector<uint32_t> ids;
+    numa_parse_cpulist(list, ids);
+
+    for (const auto id : ids)
+    {
+        char path[256]{};
+        sprintf_s(path, u8"/sys/devices/system/node/node%u/cpulist", id);
+
+        FILE* f = nullptr;
+        if (fopen_s(&f, path, u8"rb") != ERROR_SUCCESS)
+            continue;
+
+        char cpus[4096]{};
+        numanode_t node{};
+        node.Id = id;
+        if (fgets(cpus, sizeof(cpus), f) != nullptr)
+            numa_parse_cpulist(cpus, node.Cpus);
+        fclose(f);
+
+        if (!node.Cpus.empty())
+            nodes.push_back(node);
+    }
+#endif
+
+    return !nodes.empty();
+}
+
+/**
+ * Pins the calling thread to the processors of a node.
+ *
+ * @param {numanode_t&} node - The node.
+ * @return {bool} True on success, false otherwise.
+ */
+bool numa_pin_thread(const numanode_t& node)
+{
+    if (node.Cpus.empty())
+        return false;
+
+#if defined(_WIN32)
+    // A thread can only be given processors of a single group; nodes never span groups..
+    GROUP_AFFINITY affinity{};
+    affinity.Group = (WORD)(node.Cpus.front() / 64);
+    for (const auto cpu : node.Cpus)
+    {
+        if (cpu / 64 == affinity.Group)
+            affinity.Mask |= (KAFFINITY)1 << (cpu % 64);
+    }
+    return ::SetThreadGroupAffinity(::GetCurrentThread(), &affinity, nullptr) != FALSE;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : node.Cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+
+    // On Linux the affinity of pid 0 is the affinity of the calling thread..
+    return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Binds a page aligned range of memory to a node. Pages that are not touched yet are then allocated on the node.
+ * (Linux only; elsewhere memory is placed on first touch by the pinned thread.)
+ *
+ * @param {void*} p - The start of the range.
+ * @param {std::size_t} size - The size of the range.
+ * @param {uint32_t} node - The node number.
+ * @return {bool} True on success, false otherwise.
+ */
+bool numa_bind(void* p, const std::size_t size, const uint32_t node)
+{
+#if defined(__linux__) && defined(__NR_mbind)
+    // Preferred instead of bound, so a full node spills over instead of failing the allocation..
+    unsigned long mask[16]{};
+    const auto bits = sizeof(mask[0]) * 8;
+    if (node >= bits * 16)
+        return false;
+
+    mask[node / bits] = 1ul << (node % bits);
+    return ::syscall(__NR_mbind, p, size, MPOL_PREFERRED, mask, bits * 16, 0) == 0;
+#else
+    (void)p;
+    (void)size;
+    (void)node;
+    return false;
+#endif
+}
@@ -0,0 +1,51 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * NUMA topology, thread placement and memory binding.
+ */
+#ifndef DEPAK_NUMA_H_INCLUDED
+#define DEPAK_NUMA_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * NUMA Node Structure
+ *
+ */
+struct numanode_t
+{
+    uint32_t Id;                // The node number.
+    std::vector<uint32_t> Cpus; // The logical processors of the node. (Windows: group * 64 + processor.)
+};
+
+/**
+ * Reads the NUMA nodes of the machine that have processors.
+ *
+ * @param {std::vector<numanode_t>&} nodes - The vector to receive the nodes.
+ * @return {bool} True on success, false if the topology could not be read.
+ */
+bool numa_nodes(std::vector<numanode_t>& nodes);
+
+/**
+ * Pins the calling thread to the processors of a node.
+ *
+ * @param {numanode_t&} node - The node.
+ * @return {bool} True on success, false otherwise.
+ */
+bool numa_pin_thread(const numanode_t& node);
+
+/**
+ * Binds a page aligned range of memory to a node. Pages that are not touched yet are then allocated on the node.
+ * (Linux only; elsewhere memory is placed on first touch by the pinned thread.)
+ *
+ * @param {void*} p - The start of the range.
+ * @param {std::size_t} size - The size of the range.
+ * @param {uint32_t} node - The node number.
+ * @return {bool} True on success, false otherwise.
+ */
+bool numa_bind(void* p, const std::size_t size, const uint32_t node);
+
+#endif // DEPAK_NUMA_H_INCLUDED
@@ -0,0 +1,465 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * PAK file format structures and the shared table / chunk readers.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <numeric>
+
+#pragma comment(lib, "aplib.lib")
+#include "aplib.h"
+#include "pak.h"
+#include "stats.h"
+#include "trace.h"
+
+/**
+ * Returns the count of bytes from the current file position to the end of the file.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {uint64_t&} remaining - The value to receive the count of bytes left.
+ * @return {bool} True on success, false otherwise.
+ */
+static bool pak_remaining(FILE* f, uint64_t& remaining)
+{
+    const auto pos = _ftelli64(f);
+    if (pos < 0 || _fseeki64(f, 0, SEEK_END) != 0)
+        return false;
+
+    const auto end = _ftelli64(f);
+    if (end < pos || _fseeki64(f, pos, SEEK_SET) != 0)
+        return false;
+
+    remaining = (uint64_t)(end - pos);
+    return true;
+}
+
+/**
+ * Parses an entry table held in memory. (The entry and special entry counts followed by the entries.)
+ *
+ * @param {uint8_t*} data - The entry table data.
+ * @param {uint64_t} size - The size of the entry table data.
+ * @param {std::vector<pakfileentry_t>&} entries - The vector to receive the file entries, in table order.
+ * @param {uint32_t&} specialCount - The value to receive the count of special entries.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_parse_entries(const uint8_t* data, const uint64_t size, std::vector<pakfileentry_t>& entries, uint32_t& specialCount)
+{
+    entries.clear();
+    specialCount = 0;
+
+    // Read the entry table information..
+    if (size < 8)
+        return false;
+
+    uint32_t eCount = 0; // The count of entries..
+    ::memcpy(&eCount, data, 4);
+    ::memcpy(&specialCount, data + 4, 4);
+
+    // Validate the entries fit the table..
+    if ((size - 8) / sizeof(pakfileentry_t) < eCount)
+        return false;
+
+    // The entries are stored exactly as laid out in memory, so they are copied as a single block..
+    entries.resize(eCount);
+    if (eCount > 0)
+        ::memcpy(entries.data(), data + 8, (std::size_t)eCount * sizeof(pakfileentry_t));
+
+    return true;
+}
+
+/**
+ * Sorts file entries by their file position.
+ *
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries to sort.
+ */
+void pak_sort_entries(std::vector<pakfileentry_t>& entries)
+{
+    std::sort(entries.begin(), entries.end(), [](const pakfileentry_t& a, const pakfileentry_t& b) -> bool {
+        return a.Position < b.Position;
+    });
+}
+
+/**
+ * Parses the name records of a string table held in memory. (The records following the string table header.)
+ *
+ * @param {uint8_t*} data - The name record data.
+ * @param {uint64_t} size - The size of the name record data.
+ * @param {std::vector<std::tuple<uint32_t, std::string>>&} names - The vector to receive the name entries.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_parse_names(const uint8_t* data, const uint64_t size, std::vector<std::tuple<uint32_t, std::string>>& names)
+{
+    names.clear();
+
+    uint64_t offset = 0;
+    while (offset < size)
+    {
+        // Read the file name data..
+        if (size - offset < sizeof(pakfilename_t))
+            return false;
+
+        pakfilename_t name{0, 0};
+        ::memcpy(&name, data + offset, sizeof(pakfilename_t));
+        offset += sizeof(pakfilename_t);
+
+        // Read the file name..
+        if (size - offset < name.NameSize)
+            return false;
+
+        names.emplace_back(name.FileId, std::string((const char*)data + offset, name.NameSize));
+        offset += name.NameSize;
+    }
+
+    return true;
+}
+
+/**
+ * Builds a lookup of name entries by their file id. When an id is listed more than once, the first entry is used.
+ *
+ * @param {std::vector<std::tuple<uint32_t, std::string>>&} names - The name entries.
+ * @param {std::unordered_map<uint32_t, std::size_t>&} index - The map to receive the index of each file ids name entry.
+ */
+void pak_index_names(const std::vector<std::tuple<uint32_t, std::string>>& names, std::unordered_map<uint32_t, std::size_t>& index)
+{
+    index.clear();
+    index.reserve(names.size());
+
+    for (std::size_t x = 0; x < names.size(); x++)
+        index.emplace(std::get<0>(names[x]), x);
+}
+
+/**
+ * Reads the entry table of a PAK file.
+ *
+ * The returned entries are sorted by their file position; the string table is the last entry.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {std::vector<pakfileentry_t>&} entries - The vector to receive the file entries.
+ * @param {uint32_t&} specialCount - The value to receive the count of special entries.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_entries(FILE* f, const pakheader_t* header, std::vector<pakfileentry_t>& entries, uint32_t& specialCount)
+{
+    statscope_t scope(StatPhase::Entries);
+
+    entries.clear();
+    specialCount = 0;
+
+    // Step the file to the entry table..
+    if (_fseeki64(f, header->EntriesOffset, SEEK_SET) != 0)
+        return false;
+
+    // Read the entry table information..
+    uint32_t eCount = 0; // The count of entries..
+    if (fread(&eCount, 4, 1, f) != 1)
+        return false;
+
+    // The table must fit the file before it is allocated; a damaged count would otherwise ask for gigabytes..
+    uint64_t remaining = 0;
+    if (!pak_remaining(f, remaining) || remaining < 4 || (remaining - 4) / sizeof(pakfileentry_t) < eCount)
+        return false;
+
+    // Read the whole table in one go instead of one entry at a time..
+    std::vector<uint8_t> table(8 + (std::size_t)eCount * sizeof(pakfileentry_t));
+    ::memcpy(table.data(), &eCount, 4);
+    if (fread(table.data() + 4, 1, table.size() - 4, f) != table.size() - 4)
+        return false;
+
+    if (!pak_parse_entries(table.data(), table.size(), entries, specialCount))
+        return false;
+
+    // Sort the file list by its file position..
+    pak_sort_entries(entries);
+
+    return true;
+}
+
+/**
+ * Reads the string table of a PAK file.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {pakfileentry_t&} table - The entry holding the string table.
+ * @param {std::vector<std::tuple<uint32_t, std::string>>&} names - The vector to receive the name entries.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_names(FILE* f, const pakheader_t* header, const pakfileentry_t& table, std::vector<std::tuple<uint32_t, std::string>>& names)
+{
+    statscope_t scope(StatPhase::Strings);
+
+    names.clear();
+
+    // Step the file to the string entry table..
+    if (_fseeki64(f, (uint64_t)table.Position * header->Unknown00, SEEK_SET) != 0)
+        return false;
+
+    // Read the string table header..
+    uint32_t tSize = 0; // The string table size..
+    uint32_t unk00 = 0; // Unknown (Padding?)
+    if (fread(&tSize, 4, 1, f) != 1 || fread(&unk00, 4, 1, f) != 1)
+        return false;
+
+    // Validate the string table size..
+    uint64_t remaining = 0;
+    if (tSize == 0 || !pak_remaining(f, remaining) || remaining < tSize)
+        return false;
+
+    // Read the name records in one go and parse them from memory..
+    std::vector<uint8_t> data(tSize);
+    if (fread(data.data(), 1, data.size(), f) != data.size())
+        return false;
+
+    return pak_parse_names(data.data(), data.size(), names);
+}
+
+/**
+ * Reads the chunk table of a file from a parent PAK file. The file position is left at the start of the chunk data.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {uint64_t} offset - The offset to the file data.
+ * @param {uint32_t&} fileSize - The value to receive the decompressed size of the file.
+ * @param {std::vector<uint32_t>&} chunkSizes - The vector to receive the compressed size of each chunk.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_chunk_table(FILE* f, const uint64_t offset, uint32_t& fileSize, std::vector<uint32_t>& chunkSizes)
+{
+    chunkSizes.clear();
+    fileSize = 0;
+
+    // Step the file to the entry location..
+    if (_fseeki64(f, offset, SEEK_SET) != 0)
+        return false;
+
+    // Read the compressed file information..
+    uint32_t chunks = 0;
+    if (fread(&fileSize, 4, 1, f) != 1 || fread(&chunks, 4, 1, f) != 1)
+        return false;
+
+    if (chunks == 0)
+        return true;
+
+    // Every chunk but the last decompresses to a full PAK_CHUNK_SIZE, so a larger count is damage..
+    if (chunks > ((uint64_t)fileSize + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE)
+        return false;
+
+    // Read the chunk sizes table..
+    chunkSizes.resize(chunks);
+    return fread(chunkSizes.data(), 4, chunks, f) == chunks;
+}
+
+/**
+ * Returns the asset type (lowercase file extension) of the given file name.
+ *
+ * @param {std::string&} name - The file name.
+ * @return {std::string} The asset type.
+ */
+std::string pak_asset_type(const std::string& name)
+{
+    if (name.empty())
+        return u8"(unnamed)";
+
+    const auto dot = name.find_last_of('.');
+    const auto sep = name.find_last_of(u8"/\\");
+    if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+        return u8"(none)";
+
+    auto type = name.substr(dot);
+    std::transform(type.begin(), type.end(), type.begin(), [](const char c) { return (char)::tolower((unsigned char)c); });
+    return type;
+}
+
+/**
+ * Reads the raw compressed chunks of a file from a parent PAK file.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {uint64_t} offset - The offset to the file data.
+ * @param {std::vector<uint32_t>&} chunkSizes - The vector to receive the compressed size of each chunk.
+ * @param {std::vector<uint8_t>&} chunkData - The vector to receive the compressed chunk data.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_chunks(FILE* f, const uint64_t offset, std::vector<uint32_t>& chunkSizes, std::vector<uint8_t>& chunkData)
+{
+    statscope_t scope(StatPhase::Read);
+
+    chunkData.clear();
+
+    // Read the compressed file information and chunk sizes table..
+    uint32_t fileSize = 0;
+    if (!pak_read_chunk_table(f, offset, fileSize, chunkSizes))
+        return false;
+
+    if (chunkSizes.empty())
+        return true;
+
+    // Read the compressed chunk data; the chunks must fit the file before they are allocated..
+    const auto total = std::accumulate(chunkSizes.begin(), chunkSizes.end(), (uint64_t)0);
+
+    uint64_t remaining = 0;
+    if (!pak_remaining(f, remaining) || remaining < total)
+        return false;
+
+    chunkData.resize((std::size_t)total);
+    scope.bytes(total);
+    return total == 0 || fread(chunkData.data(), 1, chunkData.size(), f) == chunkData.size();
+}
+
+/**
+ * Locates the raw compressed chunks of a file inside a PAK file that is mapped into memory.
+ *
+ * @param {uint8_t*} base - The mapped PAK file.
+ * @param {uint64_t} size - The size of the mapped PAK file.
+ * @param {uint64_t} offset - The offset to the file data.
+ * @param {uint32_t&} fileSize - The value to receive the decompressed size of the file.
+ * @param {std::vector<uint32_t>&} chunkSizes - The vector to receive the compressed size of each chunk.
+ * @param {uint8_t*&} chunkData - The pointer to receive the location of the compressed chunk data.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_map_chunks(const uint8_t* base, const uint64_t size, const uint64_t offset, uint32_t& fileSize, std::vector<uint32_t>& chunkSizes, const uint8_t*& chunkData)
+{
+    statscope_t scope(StatPhase::Read);
+
+    chunkSizes.clear();
+    chunkData = nullptr;
+    fileSize  = 0;
+
+    // Read the compressed file information..
+    if (offset > size || size - offset < 8)
+        return false;
+
+    uint32_t chunks = 0;
+    ::memcpy(&fileSize, base + offset, 4);
+    ::memcpy(&chunks, base + offset + 4, 4);
+
+    // Every chunk but the last decompresses to a full PAK_CHUNK_SIZE, so a larger count is damage..
+    if (chunks > ((uint64_t)fileSize + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE)
+        return false;
+
+    // Read the chunk sizes table..
+    const auto table = offset + 8;
+    if ((size - table) / 4 < chunks)
+        return false;
+
+    chunkSizes.resize(chunks);
+    if (chunks > 0)
+        ::memcpy(chunkSizes.data(), base + table, (std::size_t)chunks * 4);
+
+    // Validate the compressed chunk data is inside the mapping..
+    const auto data  = table + (uint64_t)chunks * 4;
+    const auto total = std::accumulate(chunkSizes.begin(), chunkSizes.end(), (uint64_t)0);
+    if (size - data < total)
+        return false;
+
+    chunkData = base + data;
+    scope.bytes(total);
+    return true;
+}
+
+/**
+ * Decompresses the raw chunks of a file, appending the result to the given buffer.
+ *
+ * @param {std::vector<uint32_t>&} chunkSizes - The compressed size of each chunk.
+ * @param {std::vector<uint8_t>&} chunkData - The compressed chunk data.
+ * @param {std::vector<uint8_t>&} fileData - The vector to receive the decompressed file data.
+ * @return {bool} True on success, false if a chunk is damaged.
+ */
+bool pak_decode_chunks(const std::vector<uint32_t>& chunkSizes, const std::vector<uint8_t>& chunkData, std::vector<uint8_t>& fileData)
+{
+    return pak_decode_chunks(chunkSizes, chunkData.data(), fileData);
+}
+
+/**
+ * Decompresses the raw chunks of a file, appending the result to the given buffer.
+ *
+ * @param {std::vector<uint32_t>&} chunkSizes - The compressed size of each chunk.
+ * @param {uint8_t*} chunkData - The compressed chunk data. (Must hold the sum of the chunk sizes.)
+ * @param {std::vector<uint8_t>&} fileData - The vector to receive the decompressed file data.
+ * @return {bool} True on success, false if a chunk is damaged.
+ */
+bool pak_decode_chunks(const std::vector<uint32_t>& chunkSizes, const uint8_t* chunkData, std::vector<uint8_t>& fileData)
+{
+    // Decode straight into the tail of the vector, then trim it to what was decoded..
+    const auto start = fileData.size();
+    fileData.resize(start + chunkSizes.size() * PAK_CHUNK_SIZE);
+
+    std::size_t size = 0;
+    const auto ret   = pak_decode_chunks(chunkSizes.data(), chunkSizes.size(), chunkData, fileData.data() + start, size);
+    fileData.resize(start + size);
+    return ret;
+}
+
+/**
+ * Decompresses a run of raw chunks straight into the given buffer.
+ *
+ * Each chunk is decoded with the bounds checked decoder into its own PAK_CHUNK_SIZE slot, so damaged chunk data
+ * cannot write past the buffer. Every chunk but the last of the run must decode to a full PAK_CHUNK_SIZE; checking the
+ * last one against the size of the file is left to the caller.
+ *
+ * @param {uint32_t*} chunkSizes - The compressed size of each chunk.
+ * @param {std::size_t} count - The count of chunks.
+ * @param {uint8_t*} chunkData - The compressed chunk data. (Must hold the sum of the chunk sizes.)
+ * @param {uint8_t*} fileData - The buffer to receive the decompressed data. (Must hold PAK_CHUNK_SIZE bytes per chunk.)
+ * @param {std::size_t&} size - The value to receive the size of the decompressed data.
+ * @return {bool} True on success, false if a chunk is damaged.
+ */
+bool pak_decode_chunks(const uint32_t* chunkSizes, const std::size_t count, const uint8_t* chunkData, uint8_t* fileData, std::size_t& size)
+{
+    statscope_t scope(StatPhase::Decode);
+
+    std::size_t pos = 0;
+    size            = 0;
+    for (std::size_t x = 0; x < count; x += PAK_TRACE_BATCH)
+    {
+        // Large files record a trace span per batch of chunks..
+        const auto batchStart = size;
+        tracescope_t batch(count > PAK_TRACE_BATCH ? u8"chunk batch" : nullptr);
+
+        for (std::size_t y = x; y < count && y < x + PAK_TRACE_BATCH; y++)
+        {
+            // Decompress the chunk data in place, directly behind the previous chunk..
+            const auto decSize = aP_depack_asm_safe(chunkData + pos, chunkSizes[y], fileData + size, PAK_CHUNK_SIZE);
+            if (decSize == APLIB_ERROR || (y + 1 < count && decSize != PAK_CHUNK_SIZE))
+            {
+                scope.bytes(size);
+                return false;
+            }
+
+            size += decSize;
+            pos += chunkSizes[y];
+        }
+
+        batch.bytes(size - batchStart);
+    }
+
+    scope.bytes(size);
+    return true;
+}
+
+/**
+ * Decompresses a single raw chunk with the bounds checked decoder; damaged chunk data cannot write past the buffer.
+ *
+ * @param {uint8_t*} chunkData - The compressed chunk data.
+ * @param {uint32_t} chunkSize - The compressed size of the chunk.
+ * @param {uint8_t*} fileData - The buffer to receive the decompressed data.
+ * @param {uint32_t} capacity - The size of the buffer.
+ * @param {uint32_t&} size - The value to receive the size of the decompressed data.
+ * @return {bool} True on success, false if the chunk is damaged or does not fit the buffer.
+ */
+bool pak_decode_chunk_checked(const uint8_t* chunkData, const uint32_t chunkSize, uint8_t* fileData, const uint32_t capacity, uint32_t& size)
+{
+    statscope_t scope(StatPhase::Decode);
+
+    size = aP_depack_asm_safe(chunkData, chunkSize, fileData, capacity);
+    if (size == APLIB_ERROR)
+    {
+        size = 0;
+        return false;
+    }
+
+    scope.bytes(size);
+    return true;
+}
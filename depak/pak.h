@@ -0,0 +1,226 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * PAK file format structures and the shared table / chunk readers.
+ */
+#ifndef DEPAK_PAK_H_INCLUDED
+#define DEPAK_PAK_H_INCLUDED
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * PAK Header Structure
+ *
+ */
+struct pakheader_t
+{
+    uint32_t Signature;     // The file type signature.
+    uint32_t IsValid;       // Flag to determine if the file should be processed.
+    uint32_t Unknown00;     // Unknown - 0x00000010 - Used for the header-skip alignment for reading entries.
+    uint32_t Unknown01;     // Unknown - 0x00000100 - Used for the decompression alignment block sizes.
+    uint64_t EntriesOffset; // Offset to the block of entry information.
+    uint32_t Unknown02;     // Unknown - 0x00000000
+    uint32_t Unknown03;     // Unknown - 0x00000000
+};
+
+/**
+ * PAK File Entry Structure
+ *
+ */
+struct pakfileentry_t
+{
+    uint32_t Crc;      // Used as the file name id which links to the string table id.
+    uint32_t Position; // The position where the file data block is stored.
+    uint32_t Size;     // The size of the file.
+};
+
+/**
+ * PAK File Name Structure
+ *
+ */
+struct pakfilename_t
+{
+    uint32_t FileId;   // Links to the file entry crc.
+    uint32_t NameSize; // The size of the file name.
+    char Name[];       // The file name.
+};
+
+/**
+ * PAK File Format Enumeration
+ *
+ */
+enum PakFileType
+{
+    CompressedBE      = 0x4B504B62,
+    CompressedLE      = 0x6C4B504B,
+    UncompressedBE    = 0x624B4150,
+    UncompressedLE    = 0x6C4B4150,
+    KaikoCompressedBE = 0x6252414B,
+    KaikoCompressedLE = 0x6C52414B,
+};
+
+/**
+ * The maximum decompressed size of a single compressed data chunk.
+ */
+constexpr uint32_t PAK_CHUNK_SIZE = 4096;
+
+/**
+ * The count of chunks covered by a single trace span when decoding large files.
+ */
+constexpr uint32_t PAK_TRACE_BATCH = 256;
+
+/**
+ * Parses an entry table held in memory. (The entry and special entry counts followed by the entries.)
+ *
+ * @param {uint8_t*} data - The entry table data.
+ * @param {uint64_t} size - The size of the entry table data.
+ * @param {std::vector<pakfileentry_t>&} entries - The vector to receive the file entries, in table order.
+ * @param {uint32_t&} specialCount - The value to receive the count of special entries.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_parse_entries(const uint8_t* data, const uint64_t size, std::vector<pakfileentry_t>& entries, uint32_t& specialCount);
+
+/**
+ * Sorts file entries by their file position.
+ *
+ * @param {std::vector<pakfileentry_t>&} entries - The file entries to sort.
+ */
+void pak_sort_entries(std::vector<pakfileentry_t>& entries);
+
+/**
+ * Parses the name records of a string table held in memory. (The records following the string table header.)
+ *
+ * @param {uint8_t*} data - The name record data.
+ * @param {uint64_t} size - The size of the name record data.
+ * @param {std::vector<std::tuple<uint32_t, std::string>>&} names - The vector to receive the name entries.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_parse_names(const uint8_t* data, const uint64_t size, std::vector<std::tuple<uint32_t, std::string>>& names);
+
+/**
+ * Builds a lookup of name entries by their file id. When an id is listed more than once, the first entry is used.
+ *
+ * @param {std::vector<std::tuple<uint32_t, std::string>>&} names - The name entries.
+ * @param {std::unordered_map<uint32_t, std::size_t>&} index - The map to receive the index of each file ids name entry.
+ */
+void pak_index_names(const std::vector<std::tuple<uint32_t, std::string>>& names, std::unordered_map<uint32_t, std::size_t>& index);
+
+/**
+ * Reads the entry table of a PAK file.
+ *
+ * The returned entries are sorted by their file position; the string table is the last entry.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {std::vector<pakfileentry_t>&} entries - The vector to receive the file entries.
+ * @param {uint32_t&} specialCount - The value to receive the count of special entries.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_entries(FILE* f, const pakheader_t* header, std::vector<pakfileentry_t>& entries, uint32_t& specialCount);
+
+/**
+ * Reads the string table of a PAK file.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {pakheader_t*} header - The parsed PAK header.
+ * @param {pakfileentry_t&} table - The entry holding the string table.
+ * @param {std::vector<std::tuple<uint32_t, std::string>>&} names - The vector to receive the name entries.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_names(FILE* f, const pakheader_t* header, const pakfileentry_t& table, std::vector<std::tuple<uint32_t, std::string>>& names);
+
+/**
+ * Reads the chunk table of a file from a parent PAK file. The file position is left at the start of the chunk data.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {uint64_t} offset - The offset to the file data.
+ * @param {uint32_t&} fileSize - The value to receive the decompressed size of the file.
+ * @param {std::vector<uint32_t>&} chunkSizes - The vector to receive the compressed size of each chunk.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_chunk_table(FILE* f, const uint64_t offset, uint32_t& fileSize, std::vector<uint32_t>& chunkSizes);
+
+/**
+ * Returns the asset type (lowercase file extension) of the given file name.
+ *
+ * @param {std::string&} name - The file name.
+ * @return {std::string} The asset type. ('(unnamed)' for an empty name, '(none)' without an extension.)
+ */
+std::string pak_asset_type(const std::string& name);
+
+/**
+ * Reads the raw compressed chunks of a file from a parent PAK file.
+ *
+ * @param {FILE*} f - The opened file pointer.
+ * @param {uint64_t} offset - The offset to the file data.
+ * @param {std::vector<uint32_t>&} chunkSizes - The vector to receive the compressed size of each chunk.
+ * @param {std::vector<uint8_t>&} chunkData - The vector to receive the compressed chunk data.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_chunks(FILE* f, const uint64_t offset, std::vector<uint32_t>& chunkSizes, std::vector<uint8_t>& chunkData);
+
+/**
+ * Locates the raw compressed chunks of a file inside a PAK file that is mapped into memory.
+ *
+ * @param {uint8_t*} base - The mapped PAK file.
+ * @param {uint64_t} size - The size of the mapped PAK file.
+ * @param {uint64_t} offset - The offset to the file data.
+ * @param {uint32_t&} fileSize - The value to receive the decompressed size of the file.
+ * @param {std::vector<uint32_t>&} chunkSizes - The vector to receive the compressed size of each chunk.
+ * @param {uint8_t*&} chunkData - The pointer to receive the location of the compressed chunk data.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_map_chunks(const uint8_t* base, const uint64_t size, const uint64_t offset, uint32_t& fileSize, std::vector<uint32_t>& chunkSizes, const uint8_t*& chunkData);
+
+/**
+ * Decompresses the raw chunks of a file, appending the result to the given buffer.
+ *
+ * @param {std::vector<uint32_t>&} chunkSizes - The compressed size of each chunk.
+ * @param {std::vector<uint8_t>&} chunkData - The compressed chunk data.
+ * @param {std::vector<uint8_t>&} fileData - The vector to receive the decompressed file data.
+ * @return {bool} True on success, false if a chunk is damaged.
+ */
+bool pak_decode_chunks(const std::vector<uint32_t>& chunkSizes, const std::vector<uint8_t>& chunkData, std::vector<uint8_t>& fileData);
+
+/**
+ * Decompresses the raw chunks of a file, appending the result to the given buffer.
+ *
+ * @param {std::vector<uint32_t>&} chunkSizes - The compressed size of each chunk.
+ * @param {uint8_t*} chunkData - The compressed chunk data. (Must hold the sum of the chunk sizes.)
+ * @param {std::vector<uint8_t>&} fileData - The vector to receive the decompressed file data.
+ * @return {bool} True on success, false if a chunk is damaged.
+ */
+bool pak_decode_chunks(const std::vector<uint32_t>& chunkSizes, const uint8_t* chunkData, std::vector<uint8_t>& fileData);
+
+/**
+ * Decompresses a run of raw chunks straight into the given buffer. (Every chunk but the last of the run must decode
+ * to a full PAK_CHUNK_SIZE.)
+ *
+ * @param {uint32_t*} chunkSizes - The compressed size of each chunk.
+ * @param {std::size_t} count - The count of chunks.
+ * @param {uint8_t*} chunkData - The compressed chunk data. (Must hold the sum of the chunk sizes.)
+ * @param {uint8_t*} fileData - The buffer to receive the decompressed data. (Must hold PAK_CHUNK_SIZE bytes per chunk.)
+ * @param {std::size_t&} size - The value to receive the size of the decompressed data.
+ * @return {bool} True on success, false if a chunk is damaged.
+ */
+bool pak_decode_chunks(const uint32_t* chunkSizes, const std::size_t count, const uint8_t* chunkData, uint8_t* fileData, std::size_t& size);
+
+/**
+ * Decompresses a single raw chunk with the bounds checked decoder; damaged chunk data cannot write past the buffer.
+ *
+ * @param {uint8_t*} chunkData - The compressed chunk data.
+ * @param {uint32_t} chunkSize - The compressed size of the chunk.
+ * @param {uint8_t*} fileData - The buffer to receive the decompressed data.
+ * @param {uint32_t} capacity - The size of the buffer.
+ * @param {uint32_t&} size - The value to receive the size of the decompressed data.
+ * @return {bool} True on success, false if the chunk is damaged or does not fit the buffer.
+ */
+bool pak_decode_chunk_checked(const uint8_t* chunkData, const uint32_t chunkSize, uint8_t* fileData, const uint32_t capacity, uint32_t& size);
+
+#endif // DEPAK_PAK_H_INCLUDED
@@ -0,0 +1,548 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Random access reader api over a PAK file.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+
+#include "latency.h"
+#include "metrics.h"
+#include "pakreader.h"
+
+/**
+ * PAK Reader Structure
+ *
+ */
+struct pakreader_t
+{
+    std::string Path;                                    // The PAK file path.
+    FILE* File;                                          // The opened PAK file.
+    uint64_t Size;                                       // The size of the PAK file.
+    std::mutex FileMutex;                                // Serializes access to the file position.
+    pakheader_t Header;                                  // The PAK header.
+    std::vector<pakfileentry_t> Entries;                 // The file entries, sorted by position. (Without the string table.)
+    uint32_t TableCount;                                 // The count of entries of the entry table. (With the string table.)
+    uint32_t SpecialCount;                               // The count of special entries following the entry table.
+    std::vector<std::string> Names;                      // The name of each file entry. (Empty if unnamed.)
+    std::unordered_map<std::string, std::size_t> Lookup; // The entry index of each name.
+    std::unordered_map<std::size_t, uint32_t> Unnamed;   // The unknown file number of each unnamed entry.
+};
+
+/**
+ * Opens a PAK file for reading and parses its tables.
+ *
+ * @param {char*} path - The PAK file path.
+ * @return {pakreader_t*} The reader on success, nullptr otherwise.
+ */
+pakreader_t* pak_open(const char* path)
+{
+    FILE* f = nullptr;
+    if (fopen_s(&f, path, u8"rb") != ERROR_SUCCESS)
+        return nullptr;
+
+    auto reader  = new pakreader_t();
+    reader->Path = path;
+    reader->File = f;
+
+    // Read and validate the header..
+    if (_fseeki64(f, 0, SEEK_END) != 0 || (reader->Size = (uint64_t)_ftelli64(f)) < sizeof(pakheader_t) || _fseeki64(f, 0, SEEK_SET) != 0 ||
+        fread(&reader->Header, sizeof(pakheader_t), 1, f) != 1 || reader->Header.Signature != PakFileType::KaikoCompressedLE || reader->Header.IsValid == 0)
+    {
+        pak_close(reader);
+        return nullptr;
+    }
+
+    // Read the entry table; the string table is the last entry..
+    if (!pak_read_entries(f, &reader->Header, reader->Entries, reader->SpecialCount) || reader->Entries.empty())
+    {
+        pak_close(reader);
+        return nullptr;
+    }
+
+    reader->TableCount = (uint32_t)reader->Entries.size();
+    const auto table   = reader->Entries.back();
+    reader->Entries.pop_back();
+
+    std::vector<std::tuple<uint32_t, std::string>> names;
+    if (!pak_read_names(f, &reader->Header, table, names))
+    {
+        pak_close(reader);
+        return nullptr;
+    }
+
+    // Resolve the entry names..
+    std::unordered_map<uint32_t, std::size_t> index;
+    pak_index_names(names, index);
+
+    reader->Names.resize(reader->Entries.size());
+    for (std::size_t x = 0; x < reader->Entries.size(); x++)
+    {
+        const auto iter = index.find(reader->Entries[x].Crc);
+        if (iter != index.end())
+            reader->Names[x] = std::get<1>(names[iter->second]);
+
+        // Unnamed entries are numbered the same way the dumper numbers them..
+        if (reader->Names[x].empty())
+            reader->Unnamed.emplace(x, (uint32_t)reader->Unnamed.size());
+        else
+            reader->Lookup.emplace(reader->Names[x], x);
+    }
+
+    return reader;
+}
+
+/**
+ * Closes a reader and releases its resources.
+ *
+ * @param {pakreader_t*} reader - The reader to close.
+ */
+void pak_close(pakreader_t* reader)
+{
+    if (reader == nullptr)
+        return;
+
+    if (reader->File != nullptr)
+        fclose(reader->File);
+
+    delete reader;
+}
+
+/**
+ * Returns the path of the PAK file a reader was opened from.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {char*} The PAK file path.
+ */
+const char* pak_path(const pakreader_t* reader)
+{
+    return reader->Path.c_str();
+}
+
+/**
+ * Returns the header of a reader.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {pakheader_t*} The PAK header.
+ */
+const pakheader_t* pak_header(const pakreader_t* reader)
+{
+    return &reader->Header;
+}
+
+/**
+ * Returns the count of file entries of a reader. (The string table is not included.)
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {std::size_t} The count of file entries.
+ */
+std::size_t pak_entry_count(const pakreader_t* reader)
+{
+    return reader->Entries.size();
+}
+
+/**
+ * Returns the count of entries of the entry table of a reader. (The string table included, as the table stores it.)
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {uint32_t} The count of entry table entries.
+ */
+uint32_t pak_table_count(const pakreader_t* reader)
+{
+    return reader->TableCount;
+}
+
+/**
+ * Returns the count of special entries of a reader.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {uint32_t} The count of special entries.
+ */
+uint32_t pak_special_count(const pakreader_t* reader)
+{
+    return reader->SpecialCount;
+}
+
+/**
+ * Returns a file entry of a reader.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @return {pakfileentry_t*} The entry on success, nullptr if the index is out of range.
+ */
+const pakfileentry_t* pak_entry(const pakreader_t* reader, const std::size_t index)
+{
+    return index < reader->Entries.size() ? &reader->Entries[index] : nullptr;
+}
+
+/**
+ * Returns the name of a file entry of a reader.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @return {char*} The entry name, or nullptr if the entry has no name in the string table.
+ */
+const char* pak_entry_name(const pakreader_t* reader, const std::size_t index)
+{
+    if (index >= reader->Names.size() || reader->Names[index].empty())
+        return nullptr;
+    return reader->Names[index].c_str();
+}
+
+/**
+ * Returns the name a file entry is extracted to; unnamed entries get the numbered unknown file name the dumper uses.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {std::string&} name - The output name on success.
+ * @return {bool} True on success, false if the index is out of range.
+ */
+bool pak_entry_output_name(const pakreader_t* reader, const std::size_t index, std::string& name)
+{
+    if (index >= reader->Names.size())
+        return false;
+
+    if (!reader->Names[index].empty())
+    {
+        name = reader->Names[index];
+        return true;
+    }
+
+    char fileName[MAX_PATH]{};
+    sprintf_s(fileName, u8"%08X.unknown_file", reader->Unnamed.at(index));
+    name = fileName;
+    return true;
+}
+
+/**
+ * Finds a file entry of a reader by its name.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {char*} name - The entry name, as stored in the string table.
+ * @param {std::size_t&} index - The entry index on success.
+ * @return {bool} True if the entry was found, false otherwise.
+ */
+bool pak_find_entry(const pakreader_t* reader, const char* name, std::size_t& index)
+{
+    const auto iter = reader->Lookup.find(name);
+    if (iter == reader->Lookup.end())
+        return false;
+
+    index = iter->second;
+    return true;
+}
+
+/**
+ * Reads the decompressed size and chunk count of a file entry. (The entry table only holds the stored size.)
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t&} size - The decompressed size on success.
+ * @param {uint32_t&} chunks - The count of compressed chunks on success.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_entry_layout(pakreader_t* reader, const std::size_t index, uint64_t& size, uint32_t& chunks)
+{
+    if (index >= reader->Entries.size())
+        return false;
+
+    uint32_t info[2]{};
+    {
+        std::lock_guard<std::mutex> lock(reader->FileMutex);
+        if (_fseeki64(reader->File, (uint64_t)reader->Entries[index].Position * reader->Header.Unknown00, SEEK_SET) != 0 || fread(info, 4, 2, reader->File) != 2)
+            return false;
+    }
+
+    size   = info[0];
+    chunks = info[1];
+    return true;
+}
+
+/**
+ * Reads the decompressed size of a file entry. (The entry table only holds the stored size.)
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t&} size - The decompressed size on success.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_entry_file_size(pakreader_t* reader, const std::size_t index, uint64_t& size)
+{
+    uint32_t chunks = 0;
+    return pak_entry_layout(reader, index, size, chunks);
+}
+
+/**
+ * Records a served read in the service metrics.
+ *
+ * @param {bool} ok - Flag if the read succeeded.
+ * @param {uint64_t} bytes - The count of bytes that were read.
+ */
+static void pak_record_read(const bool ok, const uint64_t bytes)
+{
+    if (!metrics_enabled())
+        return;
+
+    metrics_add(ok ? MetricCounter::Reads : MetricCounter::Errors, 1);
+    metrics_add(MetricCounter::ReadBytes, bytes);
+}
+
+/**
+ * Reads the compressed chunks covering a byte range of a file entry.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t} offset - The offset into the decompressed file.
+ * @param {uint64_t} length - The count of bytes to read. (Clamped to the end of the file.)
+ * @param {uint64_t} capacity - The most bytes the range may hold; larger ranges only have their end set.
+ * @param {std::vector<uint32_t>&} chunkSizes - The vector to receive the compressed size of each covering chunk.
+ * @param {std::vector<uint8_t>&} chunkData - The vector to receive the compressed data of the covering chunks.
+ * @param {uint64_t&} fileSize - The value to receive the decompressed size of the file.
+ * @param {uint64_t&} first - The value to receive the index of the first covering chunk.
+ * @param {uint64_t&} end - The value to receive the offset one past the clamped range. (Equal to offset when empty.)
+ * @return {bool} True on success, false otherwise.
+ */
+static bool pak_read_range_chunks(pakreader_t* reader, const std::size_t index, const uint64_t offset, const uint64_t length, const uint64_t capacity,
+    std::vector<uint32_t>& chunkSizes, std::vector<uint8_t>& chunkData, uint64_t& fileSize, uint64_t& first, uint64_t& end)
+{
+    chunkSizes.clear();
+    chunkData.clear();
+    fileSize = 0;
+    first    = 0;
+    end      = offset;
+    if (index >= reader->Entries.size())
+        return false;
+
+    std::lock_guard<std::mutex> lock(reader->FileMutex);
+
+    const auto f    = reader->File;
+    const auto base = (uint64_t)reader->Entries[index].Position * reader->Header.Unknown00;
+    if (base > reader->Size || reader->Size - base < 8 || _fseeki64(f, base, SEEK_SET) != 0)
+        return false;
+
+    // Read the compressed file information..
+    uint32_t info[2]{};
+    if (fread(info, 4, 2, f) != 2)
+        return false;
+
+    const auto chunks = info[1];
+    fileSize          = info[0];
+
+    // Every chunk but the last decompresses to a full PAK_CHUNK_SIZE; a larger count, or a table past the end of the
+    // file, is damage and is not allocated..
+    if (chunks > (fileSize + PAK_CHUNK_SIZE - 1) / PAK_CHUNK_SIZE || (reader->Size - base - 8) / 4 < chunks)
+        return false;
+
+    // Saturate the end of the range; offset + length may wrap for lengths such as UINT64_MAX..
+    if (offset >= fileSize || length == 0 || chunks == 0)
+        return true;
+    end = length >= fileSize - offset ? fileSize : offset + length;
+    if (end - offset > capacity)
+        return true;
+
+    // The covering chunks are known up front..
+    first           = offset / PAK_CHUNK_SIZE;
+    const auto last = std::min<uint64_t>((end - 1) / PAK_CHUNK_SIZE, chunks - 1);
+    if (first > last)
+        return false;
+
+    std::vector<uint32_t> sizes((std::size_t)last + 1);
+    if (fread(sizes.data(), 4, sizes.size(), f) != sizes.size())
+        return false;
+
+    // Skip the rest of the size table and the chunks before the range..
+    const auto skip = (uint64_t)(chunks - sizes.size()) * 4 + std::accumulate(sizes.begin(), sizes.begin() + (std::size_t)first, (uint64_t)0);
+    const auto data = base + 8 + (uint64_t)sizes.size() * 4 + skip;
+    const auto size = std::accumulate(sizes.begin() + (std::size_t)first, sizes.end(), (uint64_t)0);
+    if (data > reader->Size || reader->Size - data < size || _fseeki64(f, (int64_t)skip, SEEK_CUR) != 0)
+        return false;
+
+    chunkSizes.assign(sizes.begin() + (std::size_t)first, sizes.end());
+    chunkData.resize((std::size_t)size);
+    return chunkData.empty() || fread(chunkData.data(), 1, chunkData.size(), f) == chunkData.size();
+}
+
+/**
+ * Decodes the chunks covering a byte range of a file entry with the bounds checked decoder, straight into a buffer.
+ *
+ * Chunks wholly inside the range decode straight into the buffer; the partial chunks at either edge decode into a
+ * chunk sized block first. Each chunk must decode to exactly its share of the file.
+ *
+ * @param {std::vector<uint32_t>&} chunkSizes - The compressed size of each covering chunk.
+ * @param {std::vector<uint8_t>&} chunkData - The compressed data of the covering chunks.
+ * @param {uint64_t} fileSize - The decompressed size of the file.
+ * @param {uint64_t} first - The index of the first covering chunk.
+ * @param {uint64_t} offset - The offset of the range.
+ * @param {uint64_t} end - The offset one past the range.
+ * @param {uint8_t*} buffer - The buffer to receive the end - offset bytes of the range.
+ * @return {bool} True on success, false if a chunk is damaged or the chunks do not cover the range.
+ */
+static bool pak_decode_range(const std::vector<uint32_t>& chunkSizes, const std::vector<uint8_t>& chunkData, const uint64_t fileSize, const uint64_t first, const uint64_t offset,
+    const uint64_t end, uint8_t* buffer)
+{
+    if (end > offset && (first + chunkSizes.size()) * PAK_CHUNK_SIZE < end)
+        return false;
+
+    uint8_t edge[PAK_CHUNK_SIZE];
+    uint64_t pos = 0;
+    for (std::size_t x = 0; x < chunkSizes.size(); x++)
+    {
+        const auto start    = (first + x) * PAK_CHUNK_SIZE;
+        const auto expected = (uint32_t)std::min<uint64_t>(PAK_CHUNK_SIZE, fileSize - start);
+        const auto lo       = std::max(offset, start) - start;
+        const auto hi       = std::min(end, start + expected) - start;
+        const auto whole    = lo == 0 && hi == expected;
+
+        uint32_t decoded = 0;
+        if (!pak_decode_chunk_checked(chunkData.data() + pos, chunkSizes[x], whole ? buffer + (start - offset) : edge, expected, decoded) || decoded != expected)
+            return false;
+        if (!whole)
+            ::memcpy(buffer + (start + lo - offset), edge + lo, (std::size_t)(hi - lo));
+
+        pos += chunkSizes[x];
+    }
+    return true;
+}
+
+/**
+ * Reads and decompresses a byte range of a file entry; only the chunks covering the range are read.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t} offset - The offset into the decompressed file.
+ * @param {uint64_t} length - The count of bytes to read. (Clamped to the end of the file.)
+ * @param {std::vector<uint8_t>&} data - The vector to receive the decompressed bytes.
+ * @return {bool} True on success, false otherwise.
+ */
+static bool pak_read_range_data(pakreader_t* reader, const std::size_t index, const uint64_t offset, const uint64_t length, std::vector<uint8_t>& data)
+{
+    data.clear();
+
+    std::vector<uint32_t> chunkSizes;
+    std::vector<uint8_t> chunkData;
+    uint64_t fileSize = 0;
+    uint64_t first    = 0;
+    uint64_t end      = 0;
+    if (!pak_read_range_chunks(reader, index, offset, length, UINT64_MAX, chunkSizes, chunkData, fileSize, first, end))
+        return false;
+
+    data.resize((std::size_t)(end - offset));
+    if (!pak_decode_range(chunkSizes, chunkData, fileSize, first, offset, end, data.data()))
+    {
+        data.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Reads and decompresses a whole file entry.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {std::vector<uint8_t>&} data - The vector to receive the decompressed file data.
+ * @return {bool} True on success, false otherwise.
+ */
+static bool pak_read_entry_data(pakreader_t* reader, const std::size_t index, std::vector<uint8_t>& data)
+{
+    // A whole entry is the range that covers every chunk..
+    return pak_read_range_data(reader, index, 0, UINT64_MAX, data);
+}
+
+/**
+ * Reads and decompresses a byte range of a file entry straight into a caller buffer.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t} offset - The offset into the decompressed file.
+ * @param {uint64_t} length - The count of bytes to read. (Clamped to the end of the file.)
+ * @param {uint8_t*} buffer - The buffer to receive the decompressed bytes.
+ * @param {uint64_t} capacity - The size of the buffer.
+ * @param {uint64_t&} size - The value to receive the count of bytes in the range.
+ * @return {bool} True on success, false otherwise.
+ */
+static bool pak_read_range_buffer_data(pakreader_t* reader, const std::size_t index, const uint64_t offset, const uint64_t length, uint8_t* buffer, const uint64_t capacity, uint64_t& size)
+{
+    size = 0;
+
+    std::vector<uint32_t> chunkSizes;
+    std::vector<uint8_t> chunkData;
+    uint64_t fileSize = 0;
+    uint64_t first    = 0;
+    uint64_t end      = 0;
+    if (!pak_read_range_chunks(reader, index, offset, length, capacity, chunkSizes, chunkData, fileSize, first, end))
+        return false;
+
+    size = end - offset;
+    if (size > capacity)
+        return false;
+
+    return pak_decode_range(chunkSizes, chunkData, fileSize, first, offset, end, buffer);
+}
+
+/**
+ * Reads and decompresses a whole file entry.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {std::vector<uint8_t>&} data - The vector to receive the decompressed file data.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_entry(pakreader_t* reader, const std::size_t index, std::vector<uint8_t>& data)
+{
+    latencyscope_t latency(LatencyKind::Read);
+    metricsgauge_t inflight(MetricGauge::InFlightReads);
+
+    const auto ok = pak_read_entry_data(reader, index, data);
+    pak_record_read(ok, data.size());
+    return ok;
+}
+
+/**
+ * Reads and decompresses a byte range of a file entry; only the chunks covering the range are read.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t} offset - The offset into the decompressed file.
+ * @param {uint64_t} length - The count of bytes to read. (Clamped to the end of the file.)
+ * @param {std::vector<uint8_t>&} data - The vector to receive the decompressed bytes.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_range(pakreader_t* reader, const std::size_t index, const uint64_t offset, const uint64_t length, std::vector<uint8_t>& data)
+{
+    latencyscope_t latency(LatencyKind::Read);
+    metricsgauge_t inflight(MetricGauge::InFlightReads);
+
+    const auto ok = pak_read_range_data(reader, index, offset, length, data);
+    pak_record_read(ok, data.size());
+    return ok;
+}
+
+/**
+ * Reads and decompresses a byte range of a file entry straight into a caller buffer; only the chunks covering the
+ * range are read, and they are decoded with the bounds checked decoder.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t} offset - The offset into the decompressed file.
+ * @param {uint64_t} length - The count of bytes to read. (Clamped to the end of the file.)
+ * @param {uint8_t*} buffer - The buffer to receive the decompressed bytes.
+ * @param {uint64_t} capacity - The size of the buffer.
+ * @param {uint64_t&} size - The value to receive the count of bytes in the range; also set when the buffer is too small.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_range_buffer(pakreader_t* reader, const std::size_t index, const uint64_t offset, const uint64_t length, uint8_t* buffer, const uint64_t capacity, uint64_t& size)
+{
+    latencyscope_t latency(LatencyKind::Read);
+    metricsgauge_t inflight(MetricGauge::InFlightReads);
+
+    const auto ok = pak_read_range_buffer_data(reader, index, offset, length, buffer, capacity, size);
+    pak_record_read(ok, ok ? size : 0);
+    return ok;
+}
@@ -0,0 +1,176 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Random access reader api over a PAK file.
+ */
+#ifndef DEPAK_PAKREADER_H_INCLUDED
+#define DEPAK_PAKREADER_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pak.h"
+
+/**
+ * PAK Reader Structure (Opaque)
+ *
+ * Holds the opened file, its parsed tables and the entry names. Reads may be issued from multiple threads;
+ * file access is serialized and decoding runs on the calling thread. Every read decodes with the bounds checked
+ * decoder, so damaged file data fails the read instead of writing past its buffer.
+ */
+struct pakreader_t;
+
+/**
+ * Opens a PAK file for reading and parses its tables.
+ *
+ * @param {char*} path - The PAK file path.
+ * @return {pakreader_t*} The reader on success, nullptr otherwise.
+ */
+pakreader_t* pak_open(const char* path);
+
+/**
+ * Closes a reader and releases its resources.
+ *
+ * @param {pakreader_t*} reader - The reader to close.
+ */
+void pak_close(pakreader_t* reader);
+
+/**
+ * Returns the path of the PAK file a reader was opened from.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {char*} The PAK file path.
+ */
+const char* pak_path(const pakreader_t* reader);
+
+/**
+ * Returns the header of a reader.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {pakheader_t*} The PAK header.
+ */
+const pakheader_t* pak_header(const pakreader_t* reader);
+
+/**
+ * Returns the count of file entries of a reader. (The string table is not included.)
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {std::size_t} The count of file entries.
+ */
+std::size_t pak_entry_count(const pakreader_t* reader);
+
+/**
+ * Returns the count of entries of the entry table of a reader. (The string table included, as the table stores it.)
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {uint32_t} The count of entry table entries.
+ */
+uint32_t pak_table_count(const pakreader_t* reader);
+
+/**
+ * Returns the count of special entries of a reader.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @return {uint32_t} The count of special entries.
+ */
+uint32_t pak_special_count(const pakreader_t* reader);
+
+/**
+ * Returns a file entry of a reader.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @return {pakfileentry_t*} The entry on success, nullptr if the index is out of range.
+ */
+const pakfileentry_t* pak_entry(const pakreader_t* reader, const std::size_t index);
+
+/**
+ * Returns the name of a file entry of a reader.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @return {char*} The entry name, or nullptr if the entry has no name in the string table.
+ */
+const char* pak_entry_name(const pakreader_t* reader, const std::size_t index);
+
+/**
+ * Returns the name a file entry is extracted to; unnamed entries get the numbered unknown file name the dumper uses.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {std::string&} name - The output name on success.
+ * @return {bool} True on success, false if the index is out of range.
+ */
+bool pak_entry_output_name(const pakreader_t* reader, const std::size_t index, std::string& name);
+
+/**
+ * Finds a file entry of a reader by its name.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {char*} name - The entry name, as stored in the string table.
+ * @param {std::size_t&} index - The entry index on success.
+ * @return {bool} True if the entry was found, false otherwise.
+ */
+bool pak_find_entry(const pakreader_t* reader, const char* name, std::size_t& index);
+
+/**
+ * Reads the decompressed size and chunk count of a file entry. (The entry table only holds the stored size.)
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t&} size - The decompressed size on success.
+ * @param {uint32_t&} chunks - The count of compressed chunks on success.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_entry_layout(pakreader_t* reader, const std::size_t index, uint64_t& size, uint32_t& chunks);
+
+/**
+ * Reads the decompressed size of a file entry. (The entry table only holds the stored size.)
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t&} size - The decompressed size on success.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_entry_file_size(pakreader_t* reader, const std::size_t index, uint64_t& size);
+
+/**
+ * Reads and decompresses a whole file entry.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {std::vector<uint8_t>&} data - The vector to receive the decompressed file data.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_entry(pakreader_t* reader, const std::size_t index, std::vector<uint8_t>& data);
+
+/**
+ * Reads and decompresses a byte range of a file entry; only the chunks covering the range are read.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t} offset - The offset into the decompressed file.
+ * @param {uint64_t} length - The count of bytes to read. (Clamped to the end of the file.)
+ * @param {std::vector<uint8_t>&} data - The vector to receive the decompressed bytes.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_range(pakreader_t* reader, const std::size_t index, const uint64_t offset, const uint64_t length, std::vector<uint8_t>& data);
+
+/**
+ * Reads and decompresses a byte range of a file entry straight into a caller buffer; only the chunks covering the
+ * range are read, and they are decoded with the bounds checked decoder.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t} offset - The offset into the decompressed file.
+ * @param {uint64_t} length - The count of bytes to read. (Clamped to the end of the file.)
+ * @param {uint8_t*} buffer - The buffer to receive the decompressed bytes.
+ * @param {uint64_t} capacity - The size of the buffer.
+ * @param {uint64_t&} size - The value to receive the count of bytes in the range; also set when the buffer is too small.
+ * @return {bool} True on success, false otherwise.
+ */
+bool pak_read_range_buffer(pakreader_t* reader, const std::size_t index, const uint64_t offset, const uint64_t length, uint8_t* buffer, const uint64_t capacity, uint64_t& size);
+
+#endif // DEPAK_PAKREADER_H_INCLUDED
@@ -0,0 +1,351 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Hardware performance counters per phase. (Linux perf_event_open.)
+ */
+#include <Windows.h>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perf.h"
+#include "stats.h"
+
+/**
+ * Performance Counters Structure
+ *
+ * Each thread owns its own block; blocks are summed when printed.
+ */
+struct perfcounters_t
+{
+    uint64_t Values[(int)StatPhase::Count][(int)PerfCounter::Count]; // The counter deltas per phase.
+    uint64_t Bytes[(int)StatPhase::Count];                           // The count of bytes processed per phase.
+    uint64_t Calls[(int)StatPhase::Count];                           // The count of times each phase was sampled.
+};
+
+/**
+ * Performance counter state.
+ */
+static std::atomic<bool> g_PerfEnabled{false};
+static uint32_t g_PerfMask = 0;
+static std::mutex g_PerfMutex;
+static std::vector<std::unique_ptr<perfcounters_t>> g_PerfBlocks;
+
+#if defined(__linux__)
+
+/**
+ * The display names of the performance counters.
+ */
+static const char* g_PerfCounterNames[] = {
+    u8"cycles",
+    u8"instructions",
+    u8"branch-misses",
+    u8"cache-misses",
+    u8"dTLB-load-misses",
+};
+
+/**
+ * The perf event type and config of each performance counter.
+ */
+static const uint32_t g_PerfCounterTypes[] = {
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HW_CACHE,
+};
+static const uint64_t g_PerfCounterConfigs[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+};
+
+/**
+ * Performance Counter Group Structure
+ *
+ * The counters of a single thread, opened as one group so they are scheduled (and multiplexed) together.
+ */
+struct perfgroup_t
+{
+    int Fds[(int)PerfCounter::Count]; // The counter file descriptors; the first is the group leader.
+    uint32_t Mask;                    // The mask of counters that were opened.
+    int Error;                        // The error of the group leader, if it failed to open.
+
+    perfgroup_t(void)
+        : Mask(0)
+        , Error(0)
+    {
+        for (auto x = 0; x < (int)PerfCounter::Count; x++)
+        {
+            perf_event_attr attr{};
+            attr.size           = sizeof(attr);
+            attr.type           = g_PerfCounterTypes[x];
+            attr.config         = g_PerfCounterConfigs[x];
+            attr.disabled       = x == 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            Fds[x] = (int)::syscall(__NR_perf_event_open, &attr, 0, -1, x == 0 ? -1 : Fds[0], 0);
+            if (Fds[x] >= 0)
+                Mask |= 1u << x;
+            else if (x == 0)
+            {
+                // Without the leader there is no group to attach the others to..
+                Error = errno;
+                for (auto& fd : Fds)
+                    fd = -1;
+                return;
+            }
+        }
+
+        ::ioctl(Fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(Fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    ~perfgroup_t(void)
+    {
+        for (const auto fd : Fds)
+        {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    }
+
+    perfgroup_t(const perfgroup_t&) = delete;
+    perfgroup_t& operator=(const perfgroup_t&) = delete;
+};
+
+/**
+ * Returns the calling threads counter group.
+ *
+ * @return {perfgroup_t&} The counter group of the calling thread.
+ */
+static perfgroup_t& perf_group(void)
+{
+    thread_local perfgroup_t group;
+    return group;
+}
+
+#endif
+
+/**
+ * Returns the calling threads performance counter block.
+ *
+ * @return {perfcounters_t*} The counters of the calling thread.
+ */
+static perfcounters_t* perf_thread(void)
+{
+    thread_local perfcounters_t* counters = nullptr;
+    if (counters == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(g_PerfMutex);
+        g_PerfBlocks.push_back(std::make_unique<perfcounters_t>());
+        counters = g_PerfBlocks.back().get();
+    }
+    return counters;
+}
+
+/**
+ * Enables hardware performance counter collection.
+ *
+ * @return {bool} True if the counters are available, false otherwise.
+ */
+bool perf_enable(void)
+{
+#if defined(__linux__)
+    // Probe the counters on the calling thread; worker threads open their own groups on first use..
+    const auto& group = perf_group();
+    if (group.Mask == 0)
+    {
+        printf_s(u8"[!] Warning: Hardware performance counters are unavailable (%s); check /proc/sys/kernel/perf_event_paranoid.\r\n", ::strerror(group.Error));
+        return false;
+    }
+
+    for (auto x = 0; x < (int)PerfCounter::Count; x++)
+    {
+        if ((group.Mask & (1u << x)) == 0)
+            printf_s(u8"[!] Warning: The '%s' performance counter is unavailable.\r\n", g_PerfCounterNames[x]);
+    }
+
+    g_PerfMask = group.Mask;
+    g_PerfEnabled.store(true, std::memory_order_relaxed);
+    return true;
+#else
+    printf_s(u8"[!] Warning: Hardware performance counters are only supported on Linux.\r\n");
+    return false;
+#endif
+}
+
+/**
+ * Returns if hardware performance counter collection is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool perf_enabled(void)
+{
+    return g_PerfEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Reads the calling threads counters, opening them on first use.
+ *
+ * @param {perfsample_t&} sample - The sample to receive the counter values.
+ * @return {bool} True on success, false otherwise.
+ */
+bool perf_read(perfsample_t& sample)
+{
+    ::memset(&sample, 0, sizeof(sample));
+
+#if defined(__linux__)
+    const auto& group = perf_group();
+    if (group.Mask == 0)
+        return false;
+
+    // Group read layout: count, time enabled, time running, then one value per opened counter..
+    uint64_t data[3 + (int)PerfCounter::Count]{};
+    if (::read(group.Fds[0], data, sizeof(data)) <= 0 || data[2] == 0)
+        return false;
+
+    // Scale the values up when the group was multiplexed with other events..
+    const auto scale = (double)data[1] / (double)data[2];
+
+    auto index = 3;
+    for (auto x = 0; x < (int)PerfCounter::Count && index < 3 + (int)data[0]; x++)
+    {
+        if (group.Mask & (1u << x))
+            sample.Values[x] = (uint64_t)((double)data[index++] * scale);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Adds the counter deltas between two samples to the given phase of the calling thread.
+ *
+ * @param {StatPhase} phase - The phase to record the deltas into.
+ * @param {perfsample_t&} begin - The sample taken when the phase started.
+ * @param {perfsample_t&} end - The sample taken when the phase ended.
+ * @param {uint64_t} bytes - The count of bytes processed in the phase.
+ */
+void perf_add(const StatPhase phase, const perfsample_t& begin, const perfsample_t& end, const uint64_t bytes)
+{
+    auto counters = perf_thread();
+    for (auto x = 0; x < (int)PerfCounter::Count; x++)
+    {
+        if (end.Values[x] > begin.Values[x])
+            counters->Values[(int)phase][x] += end.Values[x] - begin.Values[x];
+    }
+    counters->Bytes[(int)phase] += bytes;
+    counters->Calls[(int)phase]++;
+}
+
+/**
+ * Sums the counter blocks of all threads.
+ *
+ * @param {perfcounters_t&} total - The counters to receive the sums.
+ */
+static void perf_sum(perfcounters_t& total)
+{
+    total = perfcounters_t{};
+
+    std::lock_guard<std::mutex> lock(g_PerfMutex);
+    for (const auto& b : g_PerfBlocks)
+    {
+        for (auto p = 0; p < (int)StatPhase::Count; p++)
+        {
+            for (auto x = 0; x < (int)PerfCounter::Count; x++)
+                total.Values[p][x] += b->Values[p][x];
+            total.Bytes[p] += b->Bytes[p];
+            total.Calls[p] += b->Calls[p];
+        }
+    }
+}
+
+/**
+ * Returns the counters of all threads summed over every phase.
+ *
+ * @param {perfsample_t&} total - The sample to receive the totals.
+ * @return {uint64_t} The count of bytes processed over every phase.
+ */
+uint64_t perf_totals(perfsample_t& total)
+{
+    perfcounters_t sum{};
+    perf_sum(sum);
+
+    total          = perfsample_t{};
+    uint64_t bytes = 0;
+    for (auto p = 0; p < (int)StatPhase::Count; p++)
+    {
+        for (auto x = 0; x < (int)PerfCounter::Count; x++)
+            total.Values[x] += sum.Values[p][x];
+        bytes += sum.Bytes[p];
+    }
+    return bytes;
+}
+
+/**
+ * Returns if the given counter could be opened.
+ *
+ * @param {PerfCounter} counter - The counter.
+ * @return {bool} True if available, false otherwise.
+ */
+bool perf_available(const PerfCounter counter)
+{
+    return perf_enabled() && (g_PerfMask & (1u << (int)counter)) != 0;
+}
+
+/**
+ * Prints the aggregated counters of all threads.
+ */
+void perf_print(void)
+{
+    if (!perf_enabled())
+        return;
+
+    perfcounters_t total{};
+    perf_sum(total);
+
+    const auto has = [](const PerfCounter c) -> bool { return (g_PerfMask & (1u << (int)c)) != 0; };
+
+    printf_s(u8"\r\n[!] Perf Counters: (user mode; summed over threads)\r\n");
+    printf_s(u8"    %-14s %12s %12s %8s %14s %14s %14s\r\n", u8"Phase", u8"Cycles (M)", u8"Instr (M)", u8"IPC", u8"Br-miss/KB", u8"Cache-miss/KB", u8"dTLB-miss/KB");
+
+    for (auto p = 0; p < (int)StatPhase::Count; p++)
+    {
+        if (total.Calls[p] == 0)
+            continue;
+
+        const auto v  = total.Values[p];
+        const auto kb = (double)total.Bytes[p] / 1024.0;
+
+        char ipc[32] = u8"n/a", br[32] = u8"n/a", cm[32] = u8"n/a", tlb[32] = u8"n/a";
+        if (has(PerfCounter::Instructions) && v[(int)PerfCounter::Cycles] > 0)
+            sprintf_s(ipc, u8"%.2f", (double)v[(int)PerfCounter::Instructions] / (double)v[(int)PerfCounter::Cycles]);
+        if (has(PerfCounter::BranchMisses) && kb > 0)
+            sprintf_s(br, u8"%.2f", (double)v[(int)PerfCounter::BranchMisses] / kb);
+        if (has(PerfCounter::CacheMisses) && kb > 0)
+            sprintf_s(cm, u8"%.2f", (double)v[(int)PerfCounter::CacheMisses] / kb);
+        if (has(PerfCounter::DtlbMisses) && kb > 0)
+            sprintf_s(tlb, u8"%.2f", (double)v[(int)PerfCounter::DtlbMisses] / kb);
+
+        printf_s(u8"    %-14s %12.2f %12.2f %8s %14s %14s %14s\r\n", stats_phase_name((StatPhase)p),
+            (double)v[(int)PerfCounter::Cycles] / 1000000.0, (double)v[(int)PerfCounter::Instructions] / 1000000.0, ipc, br, cm, tlb);
+    }
+
+    printf_s(u8"    Misses per KB use the bytes of each phase: compressed for read, decompressed for decode and write.\r\n");
+}
@@ -0,0 +1,90 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Hardware performance counters per phase. (Linux perf_event_open.)
+ */
+#ifndef DEPAK_PERF_H_INCLUDED
+#define DEPAK_PERF_H_INCLUDED
+
+#include <cstdint>
+
+enum class StatPhase;
+
+/**
+ * Performance Counter Enumeration
+ *
+ */
+enum class PerfCounter
+{
+    Cycles,       // Cpu cycles. (The group leader.)
+    Instructions, // Retired instructions.
+    BranchMisses, // Mispredicted branches.
+    CacheMisses,  // Last level cache misses.
+    DtlbMisses,   // Data TLB load misses.
+    Count
+};
+
+/**
+ * Performance Sample Structure
+ *
+ */
+struct perfsample_t
+{
+    uint64_t Values[(int)PerfCounter::Count]; // The counter values, scaled for multiplexing.
+};
+
+/**
+ * Enables hardware performance counter collection.
+ *
+ * @return {bool} True if the counters are available, false otherwise.
+ */
+bool perf_enable(void);
+
+/**
+ * Returns if hardware performance counter collection is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool perf_enabled(void);
+
+/**
+ * Reads the calling threads counters, opening them on first use.
+ *
+ * @param {perfsample_t&} sample - The sample to receive the counter values.
+ * @return {bool} True on success, false otherwise.
+ */
+bool perf_read(perfsample_t& sample);
+
+/**
+ * Adds the counter deltas between two samples to the given phase of the calling thread.
+ *
+ * @param {StatPhase} phase - The phase to record the deltas into.
+ * @param {perfsample_t&} begin - The sample taken when the phase started.
+ * @param {perfsample_t&} end - The sample taken when the phase ended.
+ * @param {uint64_t} bytes - The count of bytes processed in the phase.
+ */
+void perf_add(const StatPhase phase, const perfsample_t& begin, const perfsample_t& end, const uint64_t bytes);
+
+/**
+ * Returns the counters of all threads summed over every phase.
+ *
+ * @param {perfsample_t&} total - The sample to receive the totals.
+ * @return {uint64_t} The count of bytes processed over every phase.
+ */
+uint64_t perf_totals(perfsample_t& total);
+
+/**
+ * Returns if the given counter could be opened.
+ *
+ * @param {PerfCounter} counter - The counter.
+ * @return {bool} True if available, false otherwise.
+ */
+bool perf_available(const PerfCounter counter);
+
+/**
+ * Prints the aggregated counters of all threads.
+ */
+void perf_print(void);
+
+#endif // DEPAK_PERF_H_INCLUDED
@@ -0,0 +1,85 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * POSIX stand-in for the parts of Windows.h and the secure CRT used by depak.
+ *
+ * Only on the include path of non-Windows builds, so the sources keep including <Windows.h> unchanged.
+ */
+#ifndef DEPAK_POSIX_WINDOWS_H_INCLUDED
+#define DEPAK_POSIX_WINDOWS_H_INCLUDED
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define MAX_PATH 260
+#define ERROR_SUCCESS 0
+#define INVALID_FILE_ATTRIBUTES ((unsigned long)-1)
+#define _TRUNCATE ((std::size_t)-1)
+
+#define __cdecl
+#define __stdcall
+#define __declspec(x)
+
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+
+/**
+ * Secure CRT replacements; the standard functions already bound their output by the given size.
+ */
+#define printf_s printf
+#define fprintf_s fprintf
+#define sscanf_s sscanf
+#define _fseeki64 fseeko
+#define _ftelli64 ftello
+
+inline int fopen_s(FILE** f, const char* path, const char* mode)
+{
+    *f = ::fopen(path, mode);
+    return *f != nullptr ? ERROR_SUCCESS : 1;
+}
+
+inline int vsnprintf_s(char* buffer, const std::size_t size, const std::size_t count, const char* format, va_list args)
+{
+    (void)count;
+    return ::vsnprintf(buffer, size, format, args);
+}
+
+inline int sprintf_s(char* buffer, const std::size_t size, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const auto ret = ::vsnprintf(buffer, size, format, args);
+    va_end(args);
+    return ret;
+}
+
+template<std::size_t N>
+inline int sprintf_s(char (&buffer)[N], const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const auto ret = ::vsnprintf(buffer, N, format, args);
+    va_end(args);
+    return ret;
+}
+
+/**
+ * File system replacements.
+ */
+inline int CreateDirectory(const char* path, void* attributes)
+{
+    (void)attributes;
+    return ::mkdir(path, 0755) == 0;
+}
+
+inline unsigned long GetFileAttributes(const char* path)
+{
+    struct stat st;
+    return ::stat(path, &st) == 0 ? 0 : INVALID_FILE_ATTRIBUTES;
+}
+
+#endif // DEPAK_POSIX_WINDOWS_H_INCLUDED
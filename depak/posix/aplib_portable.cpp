@@ -0,0 +1,466 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Portable implementation of the aPLib functions used by depak.
+ *
+ * The Windows builds link against the official aplib.dll; this is used on platforms where the library
+ * is not available. The depacker follows the reference aPLib decoder; the packer is a greedy hash-chain
+ * encoder which produces streams the reference decoder (and aplib.dll) can decode.
+ */
+#include <Windows.h>
+#include <cstdint>
+#include <cstring>
+
+#include "aplib.h"
+
+namespace
+{
+    /**
+     * Depacker state.
+     */
+    struct apdstate_t
+    {
+        const uint8_t* Source;    // The current source pointer.
+        const uint8_t* SourceEnd; // The end of the source data. (nullptr if unchecked.)
+        uint8_t* Destination;     // The current destination pointer.
+        uint8_t* DestinationBase; // The start of the destination buffer.
+        uint8_t* DestinationEnd;  // The end of the destination buffer. (nullptr if unchecked.)
+        uint32_t Tag;             // The current tag byte.
+        uint32_t BitCount;        // The count of bits remaining in the tag byte.
+        bool Failed;              // Flag set when the stream runs past a buffer bound.
+    };
+
+    /**
+     * Reads a byte from the source stream.
+     */
+    inline uint32_t ap_getbyte(apdstate_t* ud)
+    {
+        if (ud->SourceEnd != nullptr && ud->Source >= ud->SourceEnd)
+        {
+            ud->Failed = true;
+            return 0;
+        }
+        return *ud->Source++;
+    }
+
+    /**
+     * Reads a single bit from the tag stream.
+     */
+    inline uint32_t ap_getbit(apdstate_t* ud)
+    {
+        if (!ud->BitCount--)
+        {
+            ud->Tag      = ap_getbyte(ud);
+            ud->BitCount = 7;
+        }
+
+        const auto bit = (ud->Tag >> 7) & 0x01;
+        ud->Tag <<= 1;
+        return bit;
+    }
+
+    /**
+     * Reads a gamma2 encoded value from the tag stream.
+     */
+    inline uint32_t ap_getgamma(apdstate_t* ud)
+    {
+        uint32_t result = 1;
+        do
+        {
+            result = (result << 1) + ap_getbit(ud);
+        } while (ap_getbit(ud) && !ud->Failed && result < 0x80000000);
+        return result;
+    }
+
+    /**
+     * Copies a back-reference into the destination.
+     */
+    inline void ap_copy(apdstate_t* ud, const uint32_t offs, uint32_t len)
+    {
+        if (offs == 0 || offs > (uint32_t)(ud->Destination - ud->DestinationBase) || (ud->DestinationEnd != nullptr && len > (uint32_t)(ud->DestinationEnd - ud->Destination)))
+        {
+            ud->Failed = true;
+            return;
+        }
+
+        for (; len; len--)
+        {
+            *ud->Destination = *(ud->Destination - offs);
+            ud->Destination++;
+        }
+    }
+
+    /**
+     * Writes a literal byte to the destination.
+     */
+    inline void ap_literal(apdstate_t* ud, const uint32_t value)
+    {
+        if (ud->DestinationEnd != nullptr && ud->Destination >= ud->DestinationEnd)
+        {
+            ud->Failed = true;
+            return;
+        }
+        *ud->Destination++ = (uint8_t)value;
+    }
+
+    /**
+     * Decompresses an aPLib stream.
+     */
+    uint32_t ap_depack(apdstate_t* ud)
+    {
+        uint32_t R0  = (uint32_t)-1;
+        uint32_t LWM = 0;
+        bool done    = false;
+
+        // First byte is stored verbatim..
+        ap_literal(ud, ap_getbyte(ud));
+
+        while (!done && !ud->Failed)
+        {
+            if (ap_getbit(ud))
+            {
+                if (ap_getbit(ud))
+                {
+                    if (ap_getbit(ud))
+                    {
+                        // Single byte from up to 15 bytes back, or a zero byte..
+                        uint32_t offs = 0;
+                        for (auto x = 4; x; x--)
+                            offs = (offs << 1) + ap_getbit(ud);
+
+                        if (offs)
+                            ap_copy(ud, offs, 1);
+                        else
+                            ap_literal(ud, 0x00);
+
+                        LWM = 0;
+                    }
+                    else
+                    {
+                        // Short match of 2 or 3 bytes, or the end marker..
+                        auto offs      = ap_getbyte(ud);
+                        const auto len = 2 + (offs & 0x0001);
+                        offs >>= 1;
+
+                        if (offs)
+                            ap_copy(ud, offs, len);
+                        else
+                            done = true;
+
+                        R0  = offs;
+                        LWM = 1;
+                    }
+                }
+                else
+                {
+                    auto offs = ap_getgamma(ud);
+
+                    if (LWM == 0 && offs == 2)
+                    {
+                        // Match reusing the last offset..
+                        ap_copy(ud, R0, ap_getgamma(ud));
+                    }
+                    else
+                    {
+                        // Regular match..
+                        offs -= LWM == 0 ? 3 : 2;
+                        offs <<= 8;
+                        offs += ap_getbyte(ud);
+
+                        auto len = ap_getgamma(ud);
+                        if (offs >= 32000)
+                            len++;
+                        if (offs >= 1280)
+                            len++;
+                        if (offs < 128)
+                            len += 2;
+
+                        ap_copy(ud, offs, len);
+                        R0 = offs;
+                    }
+
+                    LWM = 1;
+                }
+            }
+            else
+            {
+                ap_literal(ud, ap_getbyte(ud));
+                LWM = 0;
+            }
+        }
+
+        return ud->Failed ? APLIB_ERROR : (uint32_t)(ud->Destination - ud->DestinationBase);
+    }
+
+    /**
+     * Packer output state.
+     */
+    struct apcstate_t
+    {
+        uint8_t* Destination; // The destination buffer.
+        uint32_t Pos;         // The current write position.
+        uint32_t TagPos;      // The position of the current tag byte.
+        uint32_t BitsLeft;    // The count of unused bits in the current tag byte.
+    };
+
+    inline void ap_putbit(apcstate_t* uc, const uint32_t bit)
+    {
+        if (uc->BitsLeft == 0)
+        {
+            uc->TagPos                  = uc->Pos++;
+            uc->Destination[uc->TagPos] = 0;
+            uc->BitsLeft                = 8;
+        }
+
+        uc->BitsLeft--;
+        uc->Destination[uc->TagPos] |= (uint8_t)(bit << uc->BitsLeft);
+    }
+
+    inline void ap_putbyte(apcstate_t* uc, const uint32_t value)
+    {
+        uc->Destination[uc->Pos++] = (uint8_t)value;
+    }
+
+    inline void ap_putgamma(apcstate_t* uc, const uint32_t value)
+    {
+        auto bit = 31u;
+        while (((value >> bit) & 1) == 0)
+            bit--;
+
+        while (bit--)
+        {
+            ap_putbit(uc, (value >> bit) & 1);
+            ap_putbit(uc, bit ? 1 : 0);
+        }
+    }
+
+    /**
+     * Returns the minimum match length a regular match at the given offset may encode.
+     */
+    inline uint32_t ap_minlength(const uint32_t offs)
+    {
+        if (offs < 128)
+            return 4;
+        if (offs < 1280)
+            return 2;
+        if (offs < 32000)
+            return 3;
+        return 4;
+    }
+
+    constexpr uint32_t AP_HASH_BITS  = 12;
+    constexpr uint32_t AP_HASH_SIZE  = 1u << AP_HASH_BITS;
+    constexpr uint32_t AP_MAX_CHAIN  = 64;
+    constexpr uint32_t AP_MAX_OFFSET = 0x7FFFFF;
+
+    inline uint32_t ap_hash(const uint8_t* p)
+    {
+        return (((uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2]) * 2654435761u) >> (32 - AP_HASH_BITS);
+    }
+} // namespace
+
+extern "C" {
+
+unsigned int __stdcall aP_workmem_size(unsigned int inputsize)
+{
+    return AP_HASH_SIZE * sizeof(uint32_t) + (inputsize + 1) * sizeof(uint32_t);
+}
+
+unsigned int __stdcall aP_max_packed_size(unsigned int inputsize)
+{
+    return inputsize + inputsize / 8 + 64;
+}
+
+unsigned int __stdcall aP_pack(const void* source, void* destination, unsigned int length, void* workmem, int(__stdcall* callback)(unsigned int, unsigned int, unsigned int, void*), void* cbparam)
+{
+    if (source == nullptr || destination == nullptr || workmem == nullptr)
+        return APLIB_ERROR;
+    if (length == 0)
+        return 0;
+
+    const auto src = (const uint8_t*)source;
+    auto head      = (uint32_t*)workmem;
+    auto prev      = head + AP_HASH_SIZE;
+    std::memset(head, 0xFF, AP_HASH_SIZE * sizeof(uint32_t));
+
+    apcstate_t uc{(uint8_t*)destination, 0, 0, 0};
+
+    uint32_t R0  = (uint32_t)-1;
+    uint32_t LWM = 0;
+
+    const auto insert = [&](const uint32_t p) {
+        if (p + 2 < length)
+        {
+            const auto h = ap_hash(src + p);
+            prev[p]      = head[h];
+            head[h]      = p;
+        }
+    };
+
+    // First byte is stored verbatim..
+    ap_putbyte(&uc, src[0]);
+    insert(0);
+
+    uint32_t pos = 1;
+    while (pos < length)
+    {
+        if (callback != nullptr && (pos & 0xFFFF) == 0 && !callback(length, pos, uc.Pos, cbparam))
+            return APLIB_ERROR;
+
+        const auto maxLen = length - pos;
+
+        // Find the longest match along the hash chain..
+        uint32_t bestLen  = 0;
+        uint32_t bestOffs = 0;
+        if (maxLen >= 3)
+        {
+            auto cand = head[ap_hash(src + pos)];
+            for (auto depth = 0u; cand != 0xFFFFFFFF && depth < AP_MAX_CHAIN; depth++, cand = prev[cand])
+            {
+                const auto offs = pos - cand;
+                if (offs > AP_MAX_OFFSET)
+                    break;
+
+                auto len = 0u;
+                while (len < maxLen && src[cand + len] == src[pos + len])
+                    len++;
+
+                if (len > bestLen || (len == bestLen && offs < bestOffs))
+                {
+                    bestLen  = len;
+                    bestOffs = offs;
+                }
+            }
+        }
+
+        // Check for a match using the last offset..
+        uint32_t repLen = 0;
+        if (LWM == 0 && R0 != (uint32_t)-1 && R0 <= pos)
+        {
+            while (repLen < maxLen && src[pos - R0 + repLen] == src[pos + repLen])
+                repLen++;
+        }
+
+        // Check for a short match..
+        uint32_t shortLen  = 0;
+        uint32_t shortOffs = 0;
+        for (auto offs = 1u; offs < 128 && offs <= pos && shortLen < 3; offs++)
+        {
+            auto len = 0u;
+            while (len < 3 && len < maxLen && src[pos - offs + len] == src[pos + len])
+                len++;
+            if (len >= 2 && len > shortLen)
+            {
+                shortLen  = len;
+                shortOffs = offs;
+            }
+        }
+
+        // Pick the cheapest encoding per byte covered..
+        auto usedLen = 0u;
+        if (repLen >= 2 && repLen + 1 >= bestLen)
+        {
+            ap_putbit(&uc, 1);
+            ap_putbit(&uc, 0);
+            ap_putgamma(&uc, 2);
+            ap_putgamma(&uc, repLen);
+            usedLen = repLen;
+            LWM     = 1;
+        }
+        else if (bestLen >= ap_minlength(bestOffs) && (bestLen > shortLen || bestLen >= 4))
+        {
+            auto len = bestLen;
+            if (bestOffs >= 32000)
+                len--;
+            if (bestOffs >= 1280)
+                len--;
+            if (bestOffs < 128)
+                len -= 2;
+
+            ap_putbit(&uc, 1);
+            ap_putbit(&uc, 0);
+            ap_putgamma(&uc, (bestOffs >> 8) + (LWM == 0 ? 3 : 2));
+            ap_putbyte(&uc, bestOffs & 0xFF);
+            ap_putgamma(&uc, len);
+            usedLen = bestLen;
+            R0      = bestOffs;
+            LWM     = 1;
+        }
+        else if (shortLen >= 2)
+        {
+            ap_putbit(&uc, 1);
+            ap_putbit(&uc, 1);
+            ap_putbit(&uc, 0);
+            ap_putbyte(&uc, (shortOffs << 1) | (shortLen - 2));
+            usedLen = shortLen;
+            R0      = shortOffs;
+            LWM     = 1;
+        }
+        else
+        {
+            // Single byte; use the short 4-bit form for zero bytes or nearby repeats..
+            auto near = 0u;
+            for (auto offs = 1u; offs < 16 && offs <= pos; offs++)
+            {
+                if (src[pos - offs] == src[pos])
+                {
+                    near = offs;
+                    break;
+                }
+            }
+
+            if (src[pos] == 0 || near != 0)
+            {
+                const auto offs = src[pos] == 0 ? 0u : near;
+                ap_putbit(&uc, 1);
+                ap_putbit(&uc, 1);
+                ap_putbit(&uc, 1);
+                for (auto bit = 4; bit--;)
+                    ap_putbit(&uc, (offs >> bit) & 1);
+            }
+            else
+            {
+                ap_putbit(&uc, 0);
+                ap_putbyte(&uc, src[pos]);
+            }
+
+            usedLen = 1;
+            LWM     = 0;
+        }
+
+        for (auto x = 0u; x < usedLen; x++)
+            insert(pos + x);
+        pos += usedLen;
+    }
+
+    // End marker..
+    ap_putbit(&uc, 1);
+    ap_putbit(&uc, 1);
+    ap_putbit(&uc, 0);
+    ap_putbyte(&uc, 0);
+
+    return uc.Pos;
+}
+
+unsigned int __stdcall aP_depack_asm(const void* source, void* destination)
+{
+    apdstate_t ud{(const uint8_t*)source, nullptr, (uint8_t*)destination, (uint8_t*)destination, nullptr, 0, 0, false};
+    return ap_depack(&ud);
+}
+
+unsigned int __stdcall aP_depack_asm_fast(const void* source, void* destination)
+{
+    return aP_depack_asm(source, destination);
+}
+
+unsigned int __stdcall aP_depack_asm_safe(const void* source, unsigned int srclen, void* destination, unsigned int dstlen)
+{
+    if (source == nullptr || destination == nullptr || srclen == 0)
+        return APLIB_ERROR;
+
+    apdstate_t ud{(const uint8_t*)source, (const uint8_t*)source + srclen, (uint8_t*)destination, (uint8_t*)destination, (uint8_t*)destination + dstlen, 0, 0, false};
+    return ap_depack(&ud);
+}
+
+} // extern "C"
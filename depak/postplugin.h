@@ -0,0 +1,53 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Plugin interface of the post-process hooks. (--post <library>)
+ *
+ * The header is plain C so hooks can be built by any compiler without the dumper sources. A hook library exports,
+ * with C linkage:
+ *
+ *   int32_t depak_post_process(depak_postbuffer_t* buffer);   - Required; processes the decoded data of a file.
+ *   int32_t depak_post_accepts(const char* name);             - Optional; non-zero for the files to process. (All by default.)
+ *
+ * Hooks are called from every worker thread at once and must be thread-safe.
+ */
+#ifndef DEPAK_POSTPLUGIN_H_INCLUDED
+#define DEPAK_POSTPLUGIN_H_INCLUDED
+
+#include <stdint.h>
+
+/**
+ * Post-process hook results.
+ */
+#define DEPAK_POST_WRITE 0  // Write the (possibly changed) data.
+#define DEPAK_POST_SKIP  1  // Do not write the file.
+#define DEPAK_POST_ERROR -1 // The file failed and is not written.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * Post-Process Buffer Structure
+     *
+     * The decoded data of a file. A hook may change the data in place and set Size to anything up to Capacity, or
+     * point Data at a buffer of its own that stays valid until the hooks next call on the same thread.
+     */
+    typedef struct depak_postbuffer_t
+    {
+        const char* Name;  // The output name of the file.
+        uint8_t* Data;     // The decoded file data.
+        uint64_t Size;     // The size of the data.
+        uint64_t Capacity; // The size Data can grow to in place.
+    } depak_postbuffer_t;
+
+    typedef int32_t (*depak_post_process_t)(depak_postbuffer_t* buffer);
+    typedef int32_t (*depak_post_accepts_t)(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEPAK_POSTPLUGIN_H_INCLUDED
@@ -0,0 +1,242 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Post-process hooks run by the extraction workers on decoded files before they are written.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+#include "postprocess.h"
+
+/**
+ * Returns if a file name ends with the given extension, ignoring case.
+ *
+ * @param {char*} name - The file name.
+ * @param {char*} ext - The lowercase extension, including the dot.
+ * @return {bool} True if the name ends with the extension, false otherwise.
+ */
+static bool post_has_extension(const char* name, const char* ext)
+{
+    const auto len  = ::strlen(name);
+    const auto elen = ::strlen(ext);
+    if (len < elen)
+        return false;
+
+    for (std::size_t x = 0; x < elen; x++)
+    {
+        if (::tolower((unsigned char)name[len - elen + x]) != ext[x])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * xml-minify: Accepts .xml files.
+ *
+ * @param {char*} name - The output name of the file.
+ * @return {int32_t} Non-zero if the file is processed.
+ */
+static int32_t post_xml_accepts(const char* name)
+{
+    return post_has_extension(name, u8".xml") ? 1 : 0;
+}
+
+/**
+ * xml-minify: Removes whitespace-only text between tags, in place. Comments and CDATA sections are kept as they are.
+ *
+ * @param {depak_postbuffer_t*} buffer - The decoded file.
+ * @return {int32_t} DEPAK_POST_WRITE.
+ */
+static int32_t post_xml_minify(depak_postbuffer_t* buffer)
+{
+    const auto data = buffer->Data;
+    const auto size = (std::size_t)buffer->Size;
+    const auto copy = [&](std::size_t& r, std::size_t& w, const char* end) {
+        // Copy up to and including the end marker..
+        const auto elen = ::strlen(end);
+        while (r < size)
+        {
+            const auto done = r + elen <= size && ::memcmp(data + r, end, elen) == 0;
+            if (done)
+            {
+                ::memmove(data + w, data + r, elen);
+                r += elen;
+                w += elen;
+                return;
+            }
+            data[w++] = data[r++];
+        }
+    };
+
+    std::size_t r = 0;
+    std::size_t w = 0;
+    while (r < size)
+    {
+        if (data[r] == '<' && r + 9 <= size && ::memcmp(data + r, u8"<![CDATA[", 9) == 0)
+            copy(r, w, u8"]]>");
+        else if (data[r] == '<' && r + 4 <= size && ::memcmp(data + r, u8"<!--", 4) == 0)
+            copy(r, w, u8"-->");
+        else if (data[r] == '>')
+            data[w++] = data[r++];
+        else
+        {
+            data[w++] = data[r++];
+            continue;
+        }
+
+        // After a tag, drop the whitespace up to the next tag or to the end of the file..
+        auto e = r;
+        while (e < size && ::isspace(data[e]))
+            e++;
+        if (e == size || data[e] == '<')
+            r = e;
+    }
+
+    buffer->Size = w;
+    return DEPAK_POST_WRITE;
+}
+
+/**
+ * The compiled-in hooks and the loaded shared libraries.
+ */
+static std::mutex g_PostMutex;
+static std::vector<posthook_t> g_PostBuiltins = {
+    {u8"xml-minify", post_xml_accepts, post_xml_minify},
+};
+static std::vector<void*> g_PostLibraries;
+
+/**
+ * Registers a compiled-in hook so it can be loaded by name.
+ *
+ * @param {char*} name - The hook name.
+ * @param {depak_post_accepts_t} accepts - Returns non-zero for the files the hook processes. (nullptr for every file.)
+ * @param {depak_post_process_t} process - Processes the decoded data of a file.
+ */
+void post_register(const char* name, const depak_post_accepts_t accepts, const depak_post_process_t process)
+{
+    std::lock_guard<std::mutex> lock(g_PostMutex);
+    g_PostBuiltins.push_back({name, accepts, process});
+}
+
+/**
+ * Loads a hook; a compiled-in hook by name, otherwise a shared library by path.
+ *
+ * @param {char*} spec - The hook name or library path.
+ * @param {posthook_t&} hook - The hook to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool post_load(const char* spec, posthook_t& hook)
+{
+    std::lock_guard<std::mutex> lock(g_PostMutex);
+
+    const auto builtin = std::find_if(g_PostBuiltins.begin(), g_PostBuiltins.end(), [spec](const posthook_t& h) -> bool { return h.Name == spec; });
+    if (builtin != g_PostBuiltins.end())
+    {
+        hook = *builtin;
+        return true;
+    }
+
+#if defined(_WIN32)
+    const auto library = ::LoadLibraryA(spec);
+    if (library == nullptr)
+    {
+        printf_s(u8"[!] Error: Failed to load post-process library: %s (error %lu)\r\n", spec, ::GetLastError());
+        return false;
+    }
+
+    const auto process = (depak_post_process_t)::GetProcAddress(library, u8"depak_post_process");
+    const auto accepts = (depak_post_accepts_t)::GetProcAddress(library, u8"depak_post_accepts");
+#else
+    const auto library = ::dlopen(spec, RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr)
+    {
+        printf_s(u8"[!] Error: Failed to load post-process library: %s (%s)\r\n", spec, ::dlerror());
+        return false;
+    }
+
+    const auto process = (depak_post_process_t)::dlsym(library, u8"depak_post_process");
+    const auto accepts = (depak_post_accepts_t)::dlsym(library, u8"depak_post_accepts");
+#endif
+
+    if (process == nullptr)
+    {
+        printf_s(u8"[!] Error: The post-process library does not export depak_post_process: %s\r\n", spec);
+#if defined(_WIN32)
+        ::FreeLibrary(library);
+#else
+        ::dlclose(library);
+#endif
+        return false;
+    }
+
+    g_PostLibraries.push_back((void*)library);
+
+    hook.Name    = spec;
+    hook.Accepts = accepts;
+    hook.Process = process;
+    return true;
+}
+
+/**
+ * Unloads every shared library loaded by post_load.
+ */
+void post_unload(void)
+{
+    std::lock_guard<std::mutex> lock(g_PostMutex);
+
+    for (const auto library : g_PostLibraries)
+    {
+#if defined(_WIN32)
+        ::FreeLibrary((HMODULE)library);
+#else
+        ::dlclose(library);
+#endif
+    }
+    g_PostLibraries.clear();
+}
+
+/**
+ * Returns if any of the hooks processes the given file.
+ *
+ * @param {std::vector<posthook_t>&} hooks - The hooks.
+ * @param {char*} name - The output name of the file.
+ * @return {bool} True if a hook processes the file, false otherwise.
+ */
+bool post_accepts(const std::vector<posthook_t>& hooks, const char* name)
+{
+    return std::any_of(hooks.begin(), hooks.end(), [name](const posthook_t& h) -> bool { return h.Accepts == nullptr || h.Accepts(name) != 0; });
+}
+
+/**
+ * Runs the hooks that process the buffers file, in order, until one does not return DEPAK_POST_WRITE.
+ *
+ * @param {std::vector<posthook_t>&} hooks - The hooks.
+ * @param {depak_postbuffer_t&} buffer - The decoded file.
+ * @return {int32_t} DEPAK_POST_WRITE, DEPAK_POST_SKIP or DEPAK_POST_ERROR.
+ */
+int32_t post_run(const std::vector<posthook_t>& hooks, depak_postbuffer_t& buffer)
+{
+    for (const auto& h : hooks)
+    {
+        if (h.Accepts != nullptr && h.Accepts(buffer.Name) == 0)
+            continue;
+
+        const auto data = buffer.Data;
+        const auto ret  = h.Process(&buffer);
+        if (ret != DEPAK_POST_WRITE)
+            return ret < 0 ? DEPAK_POST_ERROR : DEPAK_POST_SKIP;
+
+        // A buffer a hook replaced is not known to have room, so later hooks may not grow it in place..
+        if (buffer.Data != data)
+            buffer.Capacity = buffer.Size;
+    }
+    return DEPAK_POST_WRITE;
+}
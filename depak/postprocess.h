@@ -0,0 +1,70 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Post-process hooks run by the extraction workers on decoded files before they are written.
+ *
+ * A hook is either compiled in (see post_register) or loaded from a shared library built against postplugin.h.
+ */
+#ifndef DEPAK_POSTPROCESS_H_INCLUDED
+#define DEPAK_POSTPROCESS_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "postplugin.h"
+
+/**
+ * Post-Process Hook Structure
+ *
+ */
+struct posthook_t
+{
+    std::string Name;             // The hook name. (The built-in name or the library path.)
+    depak_post_accepts_t Accepts; // Returns non-zero for the files the hook processes. (nullptr for every file.)
+    depak_post_process_t Process; // Processes the decoded data of a file.
+};
+
+/**
+ * Registers a compiled-in hook so it can be loaded by name.
+ *
+ * @param {char*} name - The hook name.
+ * @param {depak_post_accepts_t} accepts - Returns non-zero for the files the hook processes. (nullptr for every file.)
+ * @param {depak_post_process_t} process - Processes the decoded data of a file.
+ */
+void post_register(const char* name, const depak_post_accepts_t accepts, const depak_post_process_t process);
+
+/**
+ * Loads a hook; a compiled-in hook by name, otherwise a shared library by path.
+ *
+ * @param {char*} spec - The hook name or library path.
+ * @param {posthook_t&} hook - The hook to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool post_load(const char* spec, posthook_t& hook);
+
+/**
+ * Unloads every shared library loaded by post_load.
+ */
+void post_unload(void);
+
+/**
+ * Returns if any of the hooks processes the given file.
+ *
+ * @param {std::vector<posthook_t>&} hooks - The hooks.
+ * @param {char*} name - The output name of the file.
+ * @return {bool} True if a hook processes the file, false otherwise.
+ */
+bool post_accepts(const std::vector<posthook_t>& hooks, const char* name);
+
+/**
+ * Runs the hooks that process the buffers file, in order, until one does not return DEPAK_POST_WRITE.
+ *
+ * @param {std::vector<posthook_t>&} hooks - The hooks.
+ * @param {depak_postbuffer_t&} buffer - The decoded file.
+ * @return {int32_t} DEPAK_POST_WRITE, DEPAK_POST_SKIP or DEPAK_POST_ERROR.
+ */
+int32_t post_run(const std::vector<posthook_t>& hooks, depak_postbuffer_t& buffer);
+
+#endif // DEPAK_POSTPROCESS_H_INCLUDED
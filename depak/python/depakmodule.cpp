@@ -0,0 +1,635 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Python extension module over the PAK reader api.
+ *
+ *   import depak
+ *   with depak.Archive("file.pak") as pak:
+ *       data = pak["some\\file.xml"]     # depak.Buffer; memoryview(data) and numpy views share its memory
+ *       head = pak.read(0, 0, 4096)       # by index, only the chunks covering the range are decoded
+ *
+ * Archives behave like read-only mappings of entry names to decoded data. The decoded data is returned in buffer
+ * objects that own the native memory it was decoded into, so memoryview, bytes-like consumers and numpy read it
+ * without another copy. The GIL is released while entries are read and decoded, so reads from many threads run
+ * in parallel.
+ */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "pakreader.h"
+
+/**
+ * Buffer Object Structure
+ *
+ * The decoded data of an entry; exports its memory through the buffer protocol.
+ */
+struct depak_buffer_object
+{
+    PyObject_HEAD
+    std::vector<uint8_t> Data; // The decoded data. (Never changes once read, so exported views stay valid.)
+};
+
+/**
+ * Archive Object Structure
+ *
+ * An opened PAK file. Reads hold their own reference to the reader so closing the archive never pulls the reader out
+ * from under a read running without the GIL.
+ */
+struct depak_archive_object
+{
+    PyObject_HEAD
+    std::shared_ptr<pakreader_t> Reader; // The reader. (Empty once closed.)
+};
+
+static PyTypeObject depak_buffer_type  = {PyVarObject_HEAD_INIT(nullptr, 0)};
+static PyTypeObject depak_archive_type = {PyVarObject_HEAD_INIT(nullptr, 0)};
+static PyObject* depak_error           = nullptr;
+
+/**
+ * Buffer: Releases the decoded data.
+ *
+ * @param {PyObject*} self - The buffer object.
+ */
+static void depak_buffer_dealloc(PyObject* self)
+{
+    reinterpret_cast<depak_buffer_object*>(self)->Data.~vector();
+    Py_TYPE(self)->tp_free(self);
+}
+
+/**
+ * Buffer: Exports the decoded data. (Read-only.)
+ *
+ * @param {PyObject*} self - The buffer object.
+ * @param {Py_buffer*} view - The view to fill.
+ * @param {int} flags - The requested buffer flags.
+ * @return {int} 0 on success, -1 otherwise.
+ */
+static int depak_buffer_get(PyObject* self, Py_buffer* view, const int flags)
+{
+    const auto b = reinterpret_cast<depak_buffer_object*>(self);
+    return PyBuffer_FillInfo(view, self, b->Data.data(), (Py_ssize_t)b->Data.size(), 1, flags);
+}
+
+/**
+ * Buffer: Returns the size of the decoded data.
+ *
+ * @param {PyObject*} self - The buffer object.
+ * @return {Py_ssize_t} The size of the data.
+ */
+static Py_ssize_t depak_buffer_length(PyObject* self)
+{
+    return (Py_ssize_t)reinterpret_cast<depak_buffer_object*>(self)->Data.size();
+}
+
+/**
+ * Buffer: Returns the decoded data as a bytes object. (Copies.)
+ *
+ * @param {PyObject*} self - The buffer object.
+ * @return {PyObject*} The bytes object.
+ */
+static PyObject* depak_buffer_bytes(PyObject* self, PyObject* args)
+{
+    (void)args;
+    const auto b = reinterpret_cast<depak_buffer_object*>(self);
+    return PyBytes_FromStringAndSize((const char*)b->Data.data(), (Py_ssize_t)b->Data.size());
+}
+
+static PyBufferProcs depak_buffer_procs = {depak_buffer_get, nullptr};
+static PySequenceMethods depak_buffer_sequence = {depak_buffer_length};
+static PyMethodDef depak_buffer_methods[] = {
+    {"__bytes__", depak_buffer_bytes, METH_NOARGS, "Returns a copy of the data as bytes."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+/**
+ * Returns the reader of an archive, raising ValueError if it is closed.
+ *
+ * @param {depak_archive_object*} a - The archive object.
+ * @return {std::shared_ptr<pakreader_t>} The reader, or empty with an exception set.
+ */
+static std::shared_ptr<pakreader_t> depak_archive_reader(depak_archive_object* a)
+{
+    if (!a->Reader)
+        PyErr_SetString(PyExc_ValueError, "I/O operation on a closed archive.");
+    return a->Reader;
+}
+
+/**
+ * Resolves an entry key, an entry name or index, to the entry index.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {PyObject*} key - The entry name (str) or index (int).
+ * @param {std::size_t&} index - The entry index on success.
+ * @return {bool} True on success, false with KeyError, IndexError or TypeError set otherwise.
+ */
+static bool depak_archive_resolve(const pakreader_t* reader, PyObject* key, std::size_t& index)
+{
+    if (PyUnicode_Check(key))
+    {
+        const auto name = PyUnicode_AsUTF8(key);
+        if (name == nullptr)
+            return false;
+        if (!pak_find_entry(reader, name, index))
+        {
+            PyErr_SetObject(PyExc_KeyError, key);
+            return false;
+        }
+        return true;
+    }
+
+    if (PyLong_Check(key))
+    {
+        auto value = PyLong_AsSsize_t(key);
+        if (value == -1 && PyErr_Occurred())
+            return false;
+
+        // Negative indexes count from the end, as with sequences..
+        const auto count = (Py_ssize_t)pak_entry_count(reader);
+        if (value < 0)
+            value += count;
+        if (value < 0 || value >= count)
+        {
+            PyErr_SetString(PyExc_IndexError, "Entry index out of range.");
+            return false;
+        }
+
+        index = (std::size_t)value;
+        return true;
+    }
+
+    PyErr_SetString(PyExc_TypeError, "Entry keys must be names (str) or indexes (int).");
+    return false;
+}
+
+/**
+ * Status of a reader call made without the GIL.
+ */
+enum class DepakStatus
+{
+    Ok,       // The call succeeded.
+    Failed,   // The call failed, or threw.
+    NoMemory, // The call ran out of memory.
+};
+
+/**
+ * Runs a reader call that may not hold the GIL; no C++ exception may unwind through the interpreter, so they are
+ * turned into a status the caller raises once it holds the GIL again.
+ *
+ * @param {Func} func - The call; returns true on success.
+ * @return {DepakStatus} The status of the call.
+ */
+template <typename Func>
+static DepakStatus depak_guard(Func&& func)
+{
+    try
+    {
+        return func() ? DepakStatus::Ok : DepakStatus::Failed;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return DepakStatus::NoMemory;
+    }
+    catch (...)
+    {
+        return DepakStatus::Failed;
+    }
+}
+
+/**
+ * Reads a whole entry, or a range of it, into a new buffer object. The GIL is released while reading and decoding.
+ *
+ * @param {depak_archive_object*} a - The archive object.
+ * @param {PyObject*} key - The entry name or index.
+ * @param {uint64_t} offset - The offset into the decoded file.
+ * @param {uint64_t} length - The count of bytes to read. (UINT64_MAX for the whole file.)
+ * @return {PyObject*} The buffer object, or nullptr with an exception set.
+ */
+static PyObject* depak_archive_read_entry(depak_archive_object* a, PyObject* key, const uint64_t offset, const uint64_t length)
+{
+    const auto reader = depak_archive_reader(a);
+    if (!reader)
+        return nullptr;
+
+    std::size_t index = 0;
+    if (!depak_archive_resolve(reader.get(), key, index))
+        return nullptr;
+
+    const auto b = PyObject_New(depak_buffer_object, &depak_buffer_type);
+    if (b == nullptr)
+        return nullptr;
+    new (&b->Data) std::vector<uint8_t>();
+
+    // Decode straight into the buffer object's own storage; nothing is copied afterwards..
+    auto status = DepakStatus::Failed;
+    Py_BEGIN_ALLOW_THREADS;
+    status = depak_guard([&]() -> bool {
+        if (offset == 0 && length == UINT64_MAX)
+            return pak_read_entry(reader.get(), index, b->Data);
+
+        // Read to the end of the file as size - offset rather than relying on the reader to clamp offset + length..
+        auto count = length;
+        if (count == UINT64_MAX)
+        {
+            uint64_t size = 0;
+            if (!pak_entry_file_size(reader.get(), index, size))
+                return false;
+            count = offset < size ? size - offset : 0;
+        }
+        return pak_read_range(reader.get(), index, offset, count, b->Data);
+    });
+    Py_END_ALLOW_THREADS;
+
+    if (status != DepakStatus::Ok)
+    {
+        Py_DECREF(b);
+        if (status == DepakStatus::NoMemory)
+            return PyErr_NoMemory();
+
+        PyErr_Format(depak_error, "Failed to read entry %zu.", index);
+        return nullptr;
+    }
+
+    return reinterpret_cast<PyObject*>(b);
+}
+
+/**
+ * Archive: Opens a PAK file. (depak.Archive(path))
+ *
+ * @param {PyObject*} self - The archive object.
+ * @param {PyObject*} args - The positional arguments.
+ * @param {PyObject*} kwds - The keyword arguments.
+ * @return {int} 0 on success, -1 otherwise.
+ */
+static int depak_archive_init(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    static const char* keywords[] = {"path", nullptr};
+
+    PyObject* path = nullptr;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&", const_cast<char**>(keywords), PyUnicode_FSConverter, &path))
+        return -1;
+
+    const auto a = reinterpret_cast<depak_archive_object*>(self);
+    const auto p = PyBytes_AsString(path);
+
+    pakreader_t* reader = nullptr;
+    auto status         = DepakStatus::Failed;
+    Py_BEGIN_ALLOW_THREADS;
+    status = depak_guard([&]() -> bool { return (reader = pak_open(p)) != nullptr; });
+    Py_END_ALLOW_THREADS;
+
+    if (status != DepakStatus::Ok)
+    {
+        if (status == DepakStatus::NoMemory)
+            PyErr_NoMemory();
+        else
+            PyErr_Format(depak_error, "Failed to open PAK file: %s", p);
+        Py_DECREF(path);
+        return -1;
+    }
+
+    Py_DECREF(path);
+    a->Reader.reset(reader, pak_close);
+    return 0;
+}
+
+/**
+ * Archive: Allocates an archive object.
+ *
+ * @param {PyTypeObject*} type - The archive type.
+ * @param {PyObject*} args - The positional arguments.
+ * @param {PyObject*} kwds - The keyword arguments.
+ * @return {PyObject*} The archive object.
+ */
+static PyObject* depak_archive_new(PyTypeObject* type, PyObject* args, PyObject* kwds)
+{
+    (void)args;
+    (void)kwds;
+
+    const auto self = type->tp_alloc(type, 0);
+    if (self != nullptr)
+        new (&reinterpret_cast<depak_archive_object*>(self)->Reader) std::shared_ptr<pakreader_t>();
+    return self;
+}
+
+/**
+ * Archive: Releases the archive. (The reader closes once no read is using it.)
+ *
+ * @param {PyObject*} self - The archive object.
+ */
+static void depak_archive_dealloc(PyObject* self)
+{
+    using reader_t = std::shared_ptr<pakreader_t>;
+    reinterpret_cast<depak_archive_object*>(self)->Reader.~reader_t();
+    Py_TYPE(self)->tp_free(self);
+}
+
+/**
+ * Archive: Returns the count of entries.
+ *
+ * @param {PyObject*} self - The archive object.
+ * @return {Py_ssize_t} The count of entries, or -1 if the archive is closed.
+ */
+static Py_ssize_t depak_archive_length(PyObject* self)
+{
+    const auto reader = depak_archive_reader(reinterpret_cast<depak_archive_object*>(self));
+    return reader ? (Py_ssize_t)pak_entry_count(reader.get()) : -1;
+}
+
+/**
+ * Archive: Returns the decoded data of an entry. (archive[key])
+ *
+ * @param {PyObject*} self - The archive object.
+ * @param {PyObject*} key - The entry name or index.
+ * @return {PyObject*} The buffer object.
+ */
+static PyObject* depak_archive_subscript(PyObject* self, PyObject* key)
+{
+    return depak_archive_read_entry(reinterpret_cast<depak_archive_object*>(self), key, 0, UINT64_MAX);
+}
+
+/**
+ * Archive: Returns if an entry name is in the archive. (key in archive)
+ *
+ * @param {PyObject*} self - The archive object.
+ * @param {PyObject*} key - The entry name.
+ * @return {int} 1 if found, 0 if not, -1 on error.
+ */
+static int depak_archive_contains(PyObject* self, PyObject* key)
+{
+    const auto reader = depak_archive_reader(reinterpret_cast<depak_archive_object*>(self));
+    if (!reader)
+        return -1;
+    if (!PyUnicode_Check(key))
+        return 0;
+
+    const auto name = PyUnicode_AsUTF8(key);
+    if (name == nullptr)
+        return -1;
+
+    std::size_t index = 0;
+    return pak_find_entry(reader.get(), name, index) ? 1 : 0;
+}
+
+/**
+ * Archive: Returns the names of the named entries, in position order.
+ *
+ * @param {PyObject*} self - The archive object.
+ * @return {PyObject*} The list of names.
+ */
+static PyObject* depak_archive_keys(PyObject* self, PyObject* args)
+{
+    (void)args;
+    const auto reader = depak_archive_reader(reinterpret_cast<depak_archive_object*>(self));
+    if (!reader)
+        return nullptr;
+
+    const auto list = PyList_New(0);
+    if (list == nullptr)
+        return nullptr;
+
+    const auto count = pak_entry_count(reader.get());
+    for (std::size_t x = 0; x < count; x++)
+    {
+        const auto name = pak_entry_name(reader.get(), x);
+        if (name == nullptr)
+            continue;
+
+        const auto str = PyUnicode_FromString(name);
+        if (str == nullptr || PyList_Append(list, str) != 0)
+        {
+            Py_XDECREF(str);
+            Py_DECREF(list);
+            return nullptr;
+        }
+        Py_DECREF(str);
+    }
+    return list;
+}
+
+/**
+ * Archive: Iterates the names of the named entries.
+ *
+ * @param {PyObject*} self - The archive object.
+ * @return {PyObject*} The iterator.
+ */
+static PyObject* depak_archive_iter(PyObject* self)
+{
+    const auto keys = depak_archive_keys(self, nullptr);
+    if (keys == nullptr)
+        return nullptr;
+
+    const auto iter = PyObject_GetIter(keys);
+    Py_DECREF(keys);
+    return iter;
+}
+
+/**
+ * Archive: Returns the decoded data of an entry, or a default if the name is not found. (archive.get(key, default=None))
+ *
+ * @param {PyObject*} self - The archive object.
+ * @param {PyObject*} args - The key and optional default.
+ * @return {PyObject*} The buffer object or the default.
+ */
+static PyObject* depak_archive_get(PyObject* self, PyObject* args)
+{
+    PyObject* key = nullptr;
+    PyObject* def = Py_None;
+    if (!PyArg_ParseTuple(args, "O|O", &key, &def))
+        return nullptr;
+
+    const auto found = depak_archive_contains(self, key);
+    if (found < 0)
+        return nullptr;
+    if (found == 0 && PyUnicode_Check(key))
+    {
+        Py_INCREF(def);
+        return def;
+    }
+    return depak_archive_subscript(self, key);
+}
+
+/**
+ * Archive: Reads a byte range of an entry; only the chunks covering the range are decoded.
+ * (archive.read(key, offset=0, length=None))
+ *
+ * @param {PyObject*} self - The archive object.
+ * @param {PyObject*} args - The positional arguments.
+ * @param {PyObject*} kwds - The keyword arguments.
+ * @return {PyObject*} The buffer object.
+ */
+static PyObject* depak_archive_read(PyObject* self, PyObject* args, PyObject* kwds)
+{
+    static const char* keywords[] = {"key", "offset", "length", nullptr};
+
+    PyObject* key             = nullptr;
+    unsigned long long offset = 0;
+    PyObject* length          = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|KO", const_cast<char**>(keywords), &key, &offset, &length))
+        return nullptr;
+
+    auto count = (unsigned long long)UINT64_MAX;
+    if (length != Py_None)
+    {
+        count = PyLong_AsUnsignedLongLong(length);
+        if (PyErr_Occurred())
+            return nullptr;
+    }
+
+    return depak_archive_read_entry(reinterpret_cast<depak_archive_object*>(self), key, offset, count);
+}
+
+/**
+ * Archive: Returns the table information of an entry. (archive.info(key))
+ *
+ * @param {PyObject*} self - The archive object.
+ * @param {PyObject*} key - The entry name or index.
+ * @return {PyObject*} A dict with index, name, crc, position, offset, stored_size and size.
+ */
+static PyObject* depak_archive_info(PyObject* self, PyObject* key)
+{
+    const auto reader = depak_archive_reader(reinterpret_cast<depak_archive_object*>(self));
+    if (!reader)
+        return nullptr;
+
+    std::size_t index = 0;
+    if (!depak_archive_resolve(reader.get(), key, index))
+        return nullptr;
+
+    uint64_t size = 0;
+    auto status   = DepakStatus::Failed;
+    Py_BEGIN_ALLOW_THREADS;
+    status = depak_guard([&]() -> bool { return pak_entry_file_size(reader.get(), index, size); });
+    Py_END_ALLOW_THREADS;
+
+    if (status != DepakStatus::Ok)
+    {
+        PyErr_Format(depak_error, "Failed to read entry %zu.", index);
+        return nullptr;
+    }
+
+    const auto e    = pak_entry(reader.get(), index);
+    const auto name = pak_entry_name(reader.get(), index);
+    return Py_BuildValue("{s:n,s:s,s:k,s:k,s:K,s:k,s:K}",
+        "index", (Py_ssize_t)index,
+        "name", name,
+        "crc", (unsigned long)e->Crc,
+        "position", (unsigned long)e->Position,
+        "offset", (unsigned long long)((uint64_t)e->Position * pak_header(reader.get())->Unknown00),
+        "stored_size", (unsigned long)e->Size,
+        "size", (unsigned long long)size);
+}
+
+/**
+ * Archive: Closes the archive. Reads already running finish first.
+ *
+ * @param {PyObject*} self - The archive object.
+ * @return {PyObject*} None.
+ */
+static PyObject* depak_archive_close(PyObject* self, PyObject* args)
+{
+    (void)args;
+    reinterpret_cast<depak_archive_object*>(self)->Reader.reset();
+    Py_RETURN_NONE;
+}
+
+/**
+ * Archive: Context manager entry; returns the archive.
+ *
+ * @param {PyObject*} self - The archive object.
+ * @return {PyObject*} The archive object.
+ */
+static PyObject* depak_archive_enter(PyObject* self, PyObject* args)
+{
+    (void)args;
+    Py_INCREF(self);
+    return self;
+}
+
+/**
+ * Archive: Context manager exit; closes the archive.
+ *
+ * @param {PyObject*} self - The archive object.
+ * @return {PyObject*} False, so exceptions propagate.
+ */
+static PyObject* depak_archive_exit(PyObject* self, PyObject* args)
+{
+    (void)args;
+    reinterpret_cast<depak_archive_object*>(self)->Reader.reset();
+    Py_RETURN_FALSE;
+}
+
+static PyMappingMethods depak_archive_mapping = {depak_archive_length, depak_archive_subscript, nullptr};
+static PySequenceMethods depak_archive_sequence = {};
+static PyMethodDef depak_archive_methods[] = {
+    {"keys", depak_archive_keys, METH_NOARGS, "Returns the names of the named entries, in position order."},
+    {"get", depak_archive_get, METH_VARARGS, "Returns the decoded data of an entry, or a default if the name is not found."},
+    {"read", (PyCFunction)(void (*)(void))depak_archive_read, METH_VARARGS | METH_KEYWORDS, "Reads a byte range of an entry; only the chunks covering the range are decoded."},
+    {"info", depak_archive_info, METH_O, "Returns the table information and decoded size of an entry."},
+    {"close", depak_archive_close, METH_NOARGS, "Closes the archive."},
+    {"__enter__", depak_archive_enter, METH_NOARGS, nullptr},
+    {"__exit__", depak_archive_exit, METH_VARARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyModuleDef depak_module = {
+    PyModuleDef_HEAD_INIT,
+    "depak",
+    "Kingdoms of Amalur: Re-Reckoning PAK file reader.",
+    -1,
+};
+
+/**
+ * Module entry point.
+ *
+ * @return {PyObject*} The module.
+ */
+PyMODINIT_FUNC PyInit_depak(void)
+{
+    depak_buffer_type.tp_name        = "depak.Buffer";
+    depak_buffer_type.tp_doc         = "The decoded data of an entry. Supports the buffer protocol; views share its memory.";
+    depak_buffer_type.tp_basicsize   = sizeof(depak_buffer_object);
+    depak_buffer_type.tp_flags       = Py_TPFLAGS_DEFAULT;
+    depak_buffer_type.tp_dealloc     = depak_buffer_dealloc;
+    depak_buffer_type.tp_as_buffer   = &depak_buffer_procs;
+    depak_buffer_type.tp_as_sequence = &depak_buffer_sequence;
+    depak_buffer_type.tp_methods     = depak_buffer_methods;
+
+    depak_archive_sequence.sq_contains = depak_archive_contains;
+
+    depak_archive_type.tp_name        = "depak.Archive";
+    depak_archive_type.tp_doc         = "Archive(path) - An opened PAK file; a read-only mapping of entry names to decoded data.";
+    depak_archive_type.tp_basicsize   = sizeof(depak_archive_object);
+    depak_archive_type.tp_flags       = Py_TPFLAGS_DEFAULT;
+    depak_archive_type.tp_new         = depak_archive_new;
+    depak_archive_type.tp_init        = depak_archive_init;
+    depak_archive_type.tp_dealloc     = depak_archive_dealloc;
+    depak_archive_type.tp_as_mapping  = &depak_archive_mapping;
+    depak_archive_type.tp_as_sequence = &depak_archive_sequence;
+    depak_archive_type.tp_iter        = depak_archive_iter;
+    depak_archive_type.tp_methods     = depak_archive_methods;
+
+    if (PyType_Ready(&depak_buffer_type) < 0 || PyType_Ready(&depak_archive_type) < 0)
+        return nullptr;
+
+    const auto module = PyModule_Create(&depak_module);
+    if (module == nullptr)
+        return nullptr;
+
+    depak_error = PyErr_NewException("depak.Error", PyExc_OSError, nullptr);
+    Py_INCREF(&depak_archive_type);
+    Py_INCREF(&depak_buffer_type);
+    if (depak_error == nullptr || PyModule_AddObject(module, "Error", depak_error) != 0 ||
+        PyModule_AddObject(module, "Archive", reinterpret_cast<PyObject*>(&depak_archive_type)) != 0 ||
+        PyModule_AddObject(module, "Buffer", reinterpret_cast<PyObject*>(&depak_buffer_type)) != 0)
+    {
+        Py_DECREF(module);
+        return nullptr;
+    }
+
+    return module;
+}
@@ -0,0 +1,78 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Random read latency benchmark over the reader api.
+ */
+#include <Windows.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "latency.h"
+#include "pakreader.h"
+#include "readbench.h"
+
+/**
+ * Issues random reads against a PAK file through the reader api and reports their latency distribution.
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {uint32_t} reads - The count of reads to issue.
+ * @param {uint64_t} length - The length of each range read. (0 reads whole entries.)
+ * @param {uint64_t} seed - The random seed.
+ * @return {bool} True on success, false otherwise.
+ */
+bool read_bench(const char* path, const uint32_t reads, const uint64_t length, const uint64_t seed)
+{
+    auto reader = pak_open(path);
+    if (reader == nullptr)
+    {
+        printf_s(u8"[!] Error: Failed to open the PAK file with the reader api.\r\n");
+        return false;
+    }
+
+    const auto count = pak_entry_count(reader);
+    if (count == 0)
+    {
+        printf_s(u8"[!] Error: The PAK file has no entries to read.\r\n");
+        pak_close(reader);
+        return false;
+    }
+
+    printf_s(u8"[!] Info: Issuing %u random %s reads over %zu entries..\r\n", reads, length == 0 ? u8"whole entry" : u8"range", count);
+
+    std::mt19937_64 rng(seed);
+    std::vector<uint8_t> data;
+    uint64_t bytes    = 0;
+    uint32_t failures = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t x = 0; x < reads; x++)
+    {
+        const auto index = (std::size_t)(rng() % count);
+
+        bool ok = false;
+        if (length == 0)
+            ok = pak_read_entry(reader, index, data);
+        else
+        {
+            // Pick a start offset so the range fits inside the file where possible..
+            const auto size   = (uint64_t)pak_entry(reader, index)->Size;
+            const auto offset = size > length ? rng() % (size - length + 1) : 0;
+            ok                = pak_read_range(reader, index, offset, length, data);
+        }
+
+        if (!ok)
+            failures++;
+        bytes += data.size();
+    }
+    const auto secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf_s(u8"[!] Info: %u reads, %.2f MB in %.3f s (%.0f reads/s, %.2f MB/s)\r\n", reads, (double)bytes / (1024.0 * 1024.0), secs,
+        secs > 0 ? (double)reads / secs : 0.0, secs > 0 ? ((double)bytes / (1024.0 * 1024.0)) / secs : 0.0);
+    if (failures > 0)
+        printf_s(u8"[!] Warning: %u reads failed.\r\n", failures);
+
+    pak_close(reader);
+    return failures == 0;
+}
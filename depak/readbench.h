@@ -0,0 +1,23 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Random read latency benchmark over the reader api.
+ */
+#ifndef DEPAK_READBENCH_H_INCLUDED
+#define DEPAK_READBENCH_H_INCLUDED
+
+#include <cstdint>
+
+/**
+ * Issues random reads against a PAK file through the reader api and reports their latency distribution.
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {uint32_t} reads - The count of reads to issue.
+ * @param {uint64_t} length - The length of each range read. (0 reads whole entries.)
+ * @param {uint64_t} seed - The random seed.
+ * @return {bool} True on success, false otherwise.
+ */
+bool read_bench(const char* path, const uint32_t reads, const uint64_t length, const uint64_t seed);
+
+#endif // DEPAK_READBENCH_H_INCLUDED
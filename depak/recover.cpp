@@ -0,0 +1,340 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Recovery of the files of PAK files with a damaged header or entry table.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+#include "aplib.h"
+#include "filemap.h"
+#include "logger.h"
+#include "recover.h"
+#include "stats.h"
+
+/**
+ * Returns if an alignment can be scanned at. (A power of two up to 1 MB.)
+ *
+ * @param {uint32_t} alignment - The alignment.
+ * @return {bool} True if usable, false otherwise.
+ */
+static bool recover_usable_alignment(const uint32_t alignment)
+{
+    return alignment != 0 && alignment <= 1024 * 1024 && (alignment & (alignment - 1)) == 0;
+}
+
+/**
+ * Checks if a plausible file starts at the given offset, and trial-decodes its first chunk if so.
+ *
+ * @param {uint8_t*} data - The PAK file data.
+ * @param {uint64_t} size - The size of the PAK file data.
+ * @param {uint64_t} offset - The offset to check.
+ * @param {uint32_t} maxChunk - The largest compressed size of a chunk.
+ * @param {uint8_t*} scratch - The buffer the first chunk is trial-decoded into. (PAK_CHUNK_SIZE bytes.)
+ * @param {recoverfile_t&} file - The file to populate.
+ * @param {bool&} plausible - The value to receive if the offset held a plausible file, whether it decoded or not.
+ * @return {bool} True if the first chunk of the file decoded to its exact size, false otherwise.
+ */
+static bool recover_probe(const uint8_t* data, const uint64_t size, const uint64_t offset, const uint32_t maxChunk, uint8_t* scratch, recoverfile_t& file, bool& plausible)
+{
+    plausible = false;
+
+    // The file size and chunk count must agree; empty files cannot be told apart from padding..
+    if (size - offset < 8)
+        return false;
+
+    uint32_t fileSize = 0;
+    uint32_t chunks   = 0;
+    ::memcpy(&fileSize, data + offset, 4);
+    ::memcpy(&chunks, data + offset + 4, 4);
+    if (fileSize == 0 || chunks != (fileSize - 1) / PAK_CHUNK_SIZE + 1)
+        return false;
+
+    // Every chunk size must be one the compressor can produce, and the chunks must fit the data..
+    const auto table = offset + 8;
+    if ((size - table) / 4 < chunks)
+        return false;
+
+    uint64_t total = 0;
+    for (uint32_t x = 0; x < chunks; x++)
+    {
+        uint32_t chunk = 0;
+        ::memcpy(&chunk, data + table + (uint64_t)x * 4, 4);
+        if (chunk == 0 || chunk > maxChunk)
+            return false;
+        total += chunk;
+    }
+
+    const auto start = table + (uint64_t)chunks * 4;
+    if (size - start < total)
+        return false;
+
+    plausible = true;
+
+    // Trial-decode the first chunk with the bounds checked decoder; the extraction decodes and checks the whole file..
+    uint32_t first = 0;
+    ::memcpy(&first, data + table, 4);
+    if (aP_depack_asm_safe(data + start, first, scratch, PAK_CHUNK_SIZE) != std::min(fileSize, PAK_CHUNK_SIZE))
+        return false;
+
+    file.Offset     = offset;
+    file.StoredSize = start + total - offset;
+    file.FileSize   = fileSize;
+    return true;
+}
+
+/**
+ * Scans a segment of PAK file data for the files starting in it.
+ *
+ * @param {uint8_t*} data - The PAK file data.
+ * @param {uint64_t} size - The size of the PAK file data.
+ * @param {uint32_t} alignment - The alignment of the file data.
+ * @param {uint64_t} begin - The first offset of the segment. (Aligned.)
+ * @param {uint64_t} end - The offset one past the segment.
+ * @param {std::vector<recoverfile_t>&} files - The vector to receive the files found.
+ * @param {std::vector<uint64_t>&} damaged - The vector to receive the offsets of plausible files whose first chunk failed to decode.
+ */
+static void recover_segment(const uint8_t* data, const uint64_t size, const uint32_t alignment, const uint64_t begin, const uint64_t end, std::vector<recoverfile_t>& files, std::vector<uint64_t>& damaged)
+{
+    const auto maxChunk = aP_max_packed_size(PAK_CHUNK_SIZE);
+
+    uint8_t scratch[PAK_CHUNK_SIZE];
+    for (auto offset = begin; offset < end;)
+    {
+        recoverfile_t file{};
+        bool plausible = false;
+        if (recover_probe(data, size, offset, maxChunk, scratch, file, plausible))
+        {
+            // Nothing else starts inside a file, so its data is never scanned..
+            files.push_back(file);
+            offset = (offset + file.StoredSize + alignment - 1) & ~(uint64_t)(alignment - 1);
+            continue;
+        }
+
+        if (plausible)
+            damaged.push_back(offset);
+        offset += alignment;
+    }
+}
+
+/**
+ * Scans PAK file data for the files stored in it, without using its entry table.
+ *
+ * @param {uint8_t*} data - The PAK file data.
+ * @param {uint64_t} size - The size of the PAK file data.
+ * @param {uint32_t} alignment - The alignment of the file data. (A power of two.)
+ * @param {executor_t*} executor - The executor the segments are scanned on. (nullptr scans on the calling thread.)
+ * @param {std::vector<recoverfile_t>&} files - The vector to receive the files found, in offset order.
+ * @param {uint64_t&} damaged - The value to receive the count of plausible files outside of the files found whose first chunk failed to decode.
+ */
+void recover_scan(const uint8_t* data, const uint64_t size, const uint32_t alignment, executor_t* executor, std::vector<recoverfile_t>& files, uint64_t& damaged)
+{
+    files.clear();
+    damaged = 0;
+
+    // File data starts after the header..
+    const auto start = ((uint64_t)sizeof(pakheader_t) + alignment - 1) & ~(uint64_t)(alignment - 1);
+    if (start >= size)
+        return;
+
+    const auto count = (std::size_t)((size - start + RECOVER_SEGMENT - 1) / RECOVER_SEGMENT);
+    std::vector<std::vector<recoverfile_t>> found(count);
+    std::vector<std::vector<uint64_t>> failed(count);
+
+    executor_parallel_for(executor, count, [&](const std::size_t x) {
+        const auto begin = start + (uint64_t)x * RECOVER_SEGMENT;
+        recover_segment(data, size, alignment, begin, std::min(size, begin + RECOVER_SEGMENT), found[x], failed[x]);
+    });
+
+    // A segment starting inside a file that began in an earlier one may have found a file inside its data..
+    uint64_t end = 0;
+    for (std::size_t x = 0; x < count; x++)
+    {
+        for (const auto& f : found[x])
+        {
+            if (f.Offset < end)
+                continue;
+
+            files.push_back(f);
+            end = f.Offset + f.StoredSize;
+        }
+    }
+
+    // Likewise, only the damaged files outside of every accepted file are counted; both lists are in offset order..
+    std::size_t next = 0;
+    for (const auto& offsets : failed)
+    {
+        for (const auto offset : offsets)
+        {
+            while (next < files.size() && files[next].Offset + files[next].StoredSize <= offset)
+                next++;
+
+            if (next == files.size() || offset < files[next].Offset)
+                damaged++;
+        }
+    }
+}
+
+/**
+ * Reads the names of the files from the entry and string tables, if they still parse.
+ *
+ * @param {filemap_t&} map - The mapped PAK file.
+ * @param {pakheader_t&} header - The PAK header.
+ * @param {std::unordered_map<uint32_t, std::string>&} names - The map to receive the name of each file position.
+ */
+static void recover_names(const filemap_t& map, const pakheader_t& header, std::unordered_map<uint32_t, std::string>& names)
+{
+    if (header.EntriesOffset >= map.Size || header.Unknown00 == 0)
+        return;
+
+    std::vector<pakfileentry_t> entries;
+    uint32_t specialCount = 0;
+    if (!pak_parse_entries(map.Data + header.EntriesOffset, map.Size - header.EntriesOffset, entries, specialCount) || entries.empty())
+        return;
+
+    pak_sort_entries(entries);
+
+    // The string table is the last entry..
+    const auto table = (uint64_t)entries.back().Position * header.Unknown00;
+    entries.pop_back();
+
+    uint32_t tSize = 0;
+    if (table >= map.Size || map.Size - table < 8)
+        return;
+    ::memcpy(&tSize, map.Data + table, 4);
+    if (tSize == 0 || map.Size - table - 8 < tSize)
+        return;
+
+    std::vector<std::tuple<uint32_t, std::string>> strings;
+    if (!pak_parse_names(map.Data + table + 8, tSize, strings))
+        return;
+
+    std::unordered_map<uint32_t, std::size_t> index;
+    pak_index_names(strings, index);
+
+    for (const auto& e : entries)
+    {
+        const auto name = index.find(e.Crc);
+        if (name != index.end() && !std::get<1>(strings[name->second]).empty())
+            names.emplace(e.Position, std::get<1>(strings[name->second]));
+    }
+}
+
+/**
+ * Recovers the files of a damaged PAK file by scanning it, and extracts them.
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {uint32_t} alignment - The alignment of the file data. (0 uses the header alignment when usable.)
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool recover_pak(const char* path, const uint32_t alignment, const extractoptions_t& opts, extractresult_t& result)
+{
+    result = extractresult_t{};
+
+    filemap_t map{};
+    if (!filemap_open(path, map, opts.Pages))
+    {
+        log_error(u8"[!] Error: Failed to map the PAK file into memory.\r\n");
+        return false;
+    }
+
+    pakheader_t header{};
+    if (map.Size >= sizeof(pakheader_t))
+        ::memcpy(&header, map.Data, sizeof(pakheader_t));
+
+    // Use the header alignment unless it was given or is damaged too..
+    auto align = alignment;
+    if (align == 0)
+    {
+        align = header.Unknown00;
+        if (!recover_usable_alignment(align))
+        {
+            log_error(u8"[!] Warning: The header alignment (%u) is damaged; scanning at %u bytes.\r\n", header.Unknown00, RECOVER_DEFAULT_ALIGNMENT);
+            align = RECOVER_DEFAULT_ALIGNMENT;
+        }
+    }
+    else if (!recover_usable_alignment(align))
+    {
+        log_error(u8"[!] Error: The alignment must be a power of two up to 1 MB.\r\n");
+        filemap_close(map);
+        return false;
+    }
+
+    log_info(u8"[!] Info: Scanning %.2f MB for files at %u byte alignment...\r\n", (double)map.Size / (1024.0 * 1024.0), align);
+
+    // Scan on the host executor, or on a pool of the requested threads; the scan stands in for the entry table..
+    std::vector<recoverfile_t> files;
+    uint64_t damaged = 0;
+    {
+        statscope_t scope(StatPhase::Entries);
+        scope.bytes(map.Size);
+
+        const auto threads = opts.Threads != 0 ? opts.Threads : opts.Executor != nullptr ? opts.Executor->concurrency() : std::thread::hardware_concurrency();
+
+        std::unique_ptr<workpool_t> pool;
+        auto executor = opts.Executor;
+        if (executor == nullptr && threads > 1)
+        {
+            pool     = std::make_unique<workpool_t>(threads);
+            executor = pool.get();
+        }
+
+        recover_scan(map.Data, map.Size, align, executor, files, damaged);
+    }
+
+    log_info(u8"[!] Info: Found %zu files. (%llu damaged files skipped)\r\n", files.size(), (unsigned long long)damaged);
+
+    // Name the files the entry table still points at; the others are named by their offset..
+    std::unordered_map<uint32_t, std::string> known;
+    if (header.Unknown00 == align)
+        recover_names(map, header, known);
+
+    std::vector<pakfileentry_t> entries;
+    std::vector<std::string> names;
+    entries.reserve(files.size());
+    names.reserve(files.size());
+
+    std::size_t named = 0;
+    for (const auto& f : files)
+    {
+        if (f.Offset / align > UINT32_MAX)
+        {
+            log_error(u8"[!] Warning: Files past %llu bytes cannot be addressed at %u byte alignment; they are skipped.\r\n", (unsigned long long)align * UINT32_MAX, align);
+            break;
+        }
+
+        const auto position = (uint32_t)(f.Offset / align);
+        entries.push_back(pakfileentry_t{0, position, (uint32_t)std::min<uint64_t>(f.StoredSize, UINT32_MAX)});
+
+        const auto name = known.find(position);
+        if (name != known.end())
+        {
+            names.push_back(name->second);
+            named++;
+            continue;
+        }
+
+        char buffer[64]{};
+        sprintf_s(buffer, u8"%012llX.unknown_file", (unsigned long long)f.Offset);
+        names.push_back(buffer);
+    }
+
+    log_info(u8"[!] Info: Named %zu files from the entry table.\r\n\r\n", named);
+
+    // Extract straight from the mapping; files damaged past their first chunk fail in the extraction..
+    pakheader_t recovered = header;
+    recovered.Unknown00   = align;
+
+    const auto ok = extract_entries_image(map.Data, map.Size, &recovered, entries, names, opts, result);
+    filemap_close(map);
+    return ok;
+}
@@ -0,0 +1,69 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Recovery of the files of PAK files with a damaged header or entry table.
+ */
+#ifndef DEPAK_RECOVER_H_INCLUDED
+#define DEPAK_RECOVER_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "executor.h"
+#include "extract.h"
+#include "pak.h"
+
+/**
+ * Recovered File Structure
+ *
+ */
+struct recoverfile_t
+{
+    uint64_t Offset;     // The offset to the file data.
+    uint64_t StoredSize; // The size of the file data. (The file size, chunk table and compressed chunks.)
+    uint32_t FileSize;   // The decompressed size of the file.
+};
+
+/**
+ * The alignment scanned at when the header does not hold a usable one.
+ */
+constexpr uint32_t RECOVER_DEFAULT_ALIGNMENT = 16;
+
+/**
+ * The bytes of the PAK file each scan task walks.
+ */
+constexpr uint64_t RECOVER_SEGMENT = 16 * 1024 * 1024;
+
+/**
+ * Scans PAK file data for the files stored in it, without using its entry table.
+ *
+ * Every aligned offset is checked for a plausible file: a decompressed size, a chunk count matching it and a chunk
+ * table whose sizes fit the data. Candidates are kept only if their first chunk decodes to its exact size with the
+ * bounds checked decoder; the scan then skips past the file, and the extraction decodes and checks the rest. The data
+ * is split into segments scanned in parallel on the executor, and files found by a segment that started inside
+ * another file are dropped afterwards.
+ *
+ * @param {uint8_t*} data - The PAK file data.
+ * @param {uint64_t} size - The size of the PAK file data.
+ * @param {uint32_t} alignment - The alignment of the file data. (A power of two.)
+ * @param {executor_t*} executor - The executor the segments are scanned on. (nullptr scans on the calling thread.)
+ * @param {std::vector<recoverfile_t>&} files - The vector to receive the files found, in offset order.
+ * @param {uint64_t&} damaged - The value to receive the count of plausible files outside of the files found whose first chunk failed to decode.
+ */
+void recover_scan(const uint8_t* data, const uint64_t size, const uint32_t alignment, executor_t* executor, std::vector<recoverfile_t>& files, uint64_t& damaged);
+
+/**
+ * Recovers the files of a damaged PAK file by scanning it, and extracts them.
+ *
+ * Files are named from the entry and string tables where those still parse; the others are named by their offset.
+ *
+ * @param {char*} path - The PAK file path.
+ * @param {uint32_t} alignment - The alignment of the file data. (0 uses the header alignment when usable.)
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool recover_pak(const char* path, const uint32_t alignment, const extractoptions_t& opts, extractresult_t& result);
+
+#endif // DEPAK_RECOVER_H_INCLUDED
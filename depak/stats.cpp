@@ -0,0 +1,241 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Per-phase timing and throughput statistics.
+ */
+#include <Windows.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif
+
+#include "metrics.h"
+#include "stats.h"
+#include "trace.h"
+
+/**
+ * Statistics state.
+ */
+static std::atomic<bool> g_StatsEnabled{false};
+static std::mutex g_StatsMutex;
+static std::vector<std::unique_ptr<statcounters_t>> g_StatsBlocks;
+
+/**
+ * The display names of the statistics phases.
+ */
+static const char* g_StatPhaseNames[] = {
+    u8"header",
+    u8"entry table",
+    u8"string table",
+    u8"name resolve",
+    u8"read",
+    u8"decode",
+    u8"write",
+    u8"post-process",
+};
+
+/**
+ * Enables or disables statistics collection.
+ *
+ * @param {bool} enabled - Flag if statistics should be collected.
+ */
+void stats_enable(const bool enabled)
+{
+    g_StatsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * Returns if statistics collection is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool stats_enabled(void)
+{
+    return g_StatsEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Returns the display name of a statistics phase.
+ *
+ * @param {StatPhase} phase - The phase.
+ * @return {char*} The phase name.
+ */
+const char* stats_phase_name(const StatPhase phase)
+{
+    return g_StatPhaseNames[(int)phase];
+}
+
+/**
+ * Returns the calling threads statistics counters.
+ *
+ * @return {statcounters_t*} The counters of the calling thread.
+ */
+statcounters_t* stats_thread(void)
+{
+    thread_local statcounters_t* counters = nullptr;
+    if (counters == nullptr)
+    {
+        // Blocks are owned by the registry so they outlive their threads until printed..
+        std::lock_guard<std::mutex> lock(g_StatsMutex);
+        g_StatsBlocks.push_back(std::make_unique<statcounters_t>());
+        counters = g_StatsBlocks.back().get();
+    }
+    return counters;
+}
+
+/**
+ * Returns the cpu time consumed by the calling thread.
+ *
+ * @return {uint64_t} The thread cpu time in nanoseconds.
+ */
+uint64_t stats_thread_cpu_ns(void)
+{
+#if defined(_WIN32)
+    FILETIME c{}, e{}, k{}, u{};
+    if (!::GetThreadTimes(::GetCurrentThread(), &c, &e, &k, &u))
+        return 0;
+
+    const auto kernel = ((uint64_t)k.dwHighDateTime << 32) | k.dwLowDateTime;
+    const auto user   = ((uint64_t)u.dwHighDateTime << 32) | u.dwLowDateTime;
+    return (kernel + user) * 100;
+#else
+    timespec ts{};
+    if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * Records a written file and its byte counts.
+ *
+ * @param {uint64_t} bytesIn - The count of compressed bytes read.
+ * @param {uint64_t} bytesOut - The count of decompressed bytes written.
+ */
+void stats_add_file(const uint64_t bytesIn, const uint64_t bytesOut)
+{
+    if (!stats_enabled())
+        return;
+
+    auto counters = stats_thread();
+    counters->BytesIn += bytesIn;
+    counters->BytesOut += bytesOut;
+    counters->Files++;
+}
+
+/**
+ * Prints the aggregated statistics of all threads.
+ *
+ * @param {double} wallSecs - The total wall time of the run in seconds.
+ */
+void stats_print(const double wallSecs)
+{
+    statcounters_t total{};
+    std::size_t threads = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_StatsMutex);
+        for (const auto& b : g_StatsBlocks)
+        {
+            for (auto x = 0; x < (int)StatPhase::Count; x++)
+            {
+                total.WallNs[x] += b->WallNs[x];
+                total.CpuNs[x] += b->CpuNs[x];
+                total.Calls[x] += b->Calls[x];
+            }
+            total.BytesIn += b->BytesIn;
+            total.BytesOut += b->BytesOut;
+            total.Files += b->Files;
+        }
+        threads = g_StatsBlocks.size();
+    }
+
+    const auto mb   = [](const uint64_t bytes) -> double { return (double)bytes / (1024.0 * 1024.0); };
+    const auto rate = [&wallSecs](const double value) -> double { return wallSecs > 0 ? value / wallSecs : 0.0; };
+
+    printf_s(u8"\r\n[!] Stats: (%zu thread(s); phase times are summed over threads)\r\n", threads);
+    printf_s(u8"    %-14s %12s %12s %12s\r\n", u8"Phase", u8"Wall ms", u8"CPU ms", u8"Calls");
+    for (auto x = 0; x < (int)StatPhase::Count; x++)
+    {
+        printf_s(u8"    %-14s %12.3f %12.3f %12llu\r\n", g_StatPhaseNames[x],
+            (double)total.WallNs[x] / 1000000.0, (double)total.CpuNs[x] / 1000000.0, (unsigned long long)total.Calls[x]);
+    }
+
+    printf_s(u8"    Total wall     : %.3f s\r\n", wallSecs);
+    printf_s(u8"    Files          : %llu (%.1f files/s)\r\n", (unsigned long long)total.Files, rate((double)total.Files));
+    printf_s(u8"    Read           : %.2f MB (%.2f MB/s)\r\n", mb(total.BytesIn), rate(mb(total.BytesIn)));
+    printf_s(u8"    Written        : %.2f MB (%.2f MB/s)\r\n", mb(total.BytesOut), rate(mb(total.BytesOut)));
+    printf_s(u8"    Ratio          : %.3fx\r\n", total.BytesIn > 0 ? (double)total.BytesOut / (double)total.BytesIn : 0.0);
+}
+
+/**
+ * Constructor and Destructor
+ *
+ * @param {StatPhase} phase - The phase to record the scope into.
+ */
+statscope_t::statscope_t(const StatPhase phase)
+    : m_Phase(phase)
+    , m_Stats(stats_enabled())
+    , m_Trace(trace_enabled())
+    , m_Perf(perf_enabled() && (phase == StatPhase::Read || phase == StatPhase::Decode || phase == StatPhase::Write))
+    , m_Metrics(metrics_enabled() && (phase == StatPhase::Read || phase == StatPhase::Decode || phase == StatPhase::Write))
+    , m_Bytes(0)
+    , m_Cpu(0)
+    , m_MemPhase(mem_set_phase((int32_t)phase))
+{
+    if (m_Stats || m_Trace || m_Metrics)
+        m_Wall = std::chrono::steady_clock::now();
+    if (m_Stats)
+        m_Cpu = stats_thread_cpu_ns();
+
+    // Sample the counters last so the scope's own bookkeeping is not counted..
+    if (m_Perf)
+        m_Perf = perf_read(m_PerfBegin);
+}
+statscope_t::~statscope_t(void)
+{
+    mem_set_phase(m_MemPhase);
+
+    if (m_Perf)
+    {
+        perfsample_t end;
+        if (perf_read(end))
+            perf_add(m_Phase, m_PerfBegin, end, m_Bytes);
+    }
+
+    if (!m_Stats && !m_Trace && !m_Metrics)
+        return;
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if (m_Metrics)
+    {
+        const auto counter = m_Phase == StatPhase::Read ? MetricCounter::ReadNs : (m_Phase == StatPhase::Decode ? MetricCounter::DecodeNs : MetricCounter::WriteNs);
+        metrics_add(counter, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_Wall).count());
+    }
+
+    if (m_Stats)
+    {
+        auto counters = stats_thread();
+        counters->WallNs[(int)m_Phase] += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_Wall).count();
+        counters->CpuNs[(int)m_Phase] += stats_thread_cpu_ns() - m_Cpu;
+        counters->Calls[(int)m_Phase]++;
+    }
+
+    if (m_Trace)
+        trace_record(g_StatPhaseNames[(int)m_Phase], m_Wall, now, m_Bytes, nullptr);
+}
+
+/**
+ * Sets the count of bytes processed in the scope. (Recorded with the trace span.)
+ *
+ * @param {uint64_t} bytes - The count of bytes.
+ */
+void statscope_t::bytes(const uint64_t bytes)
+{
+    m_Bytes = bytes;
+}
@@ -0,0 +1,130 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Per-phase timing and throughput statistics.
+ */
+#ifndef DEPAK_STATS_H_INCLUDED
+#define DEPAK_STATS_H_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+
+#include "memstats.h"
+#include "perf.h"
+
+/**
+ * Statistics Phase Enumeration
+ *
+ */
+enum class StatPhase
+{
+    Header,  // Reading and validating the PAK header.
+    Entries, // Reading the entry table.
+    Strings, // Reading the string table.
+    Names,   // Resolving entry names.
+    Read,    // Reading compressed file data.
+    Decode,  // Decompressing file data.
+    Write,   // Writing decompressed file data.
+    Post,    // Running the post-process hooks on decompressed file data.
+    Count
+};
+
+/**
+ * Statistics Counters Structure
+ *
+ * Each thread owns its own block so the hot path never shares cache lines; blocks are summed when printed.
+ */
+struct statcounters_t
+{
+    uint64_t WallNs[(int)StatPhase::Count]; // The wall time spent per phase.
+    uint64_t CpuNs[(int)StatPhase::Count];  // The thread cpu time spent per phase.
+    uint64_t Calls[(int)StatPhase::Count];  // The count of times each phase was entered.
+    uint64_t BytesIn;                       // The count of compressed bytes read.
+    uint64_t BytesOut;                      // The count of decompressed bytes written.
+    uint64_t Files;                         // The count of files written.
+};
+
+/**
+ * Enables or disables statistics collection.
+ *
+ * @param {bool} enabled - Flag if statistics should be collected.
+ */
+void stats_enable(const bool enabled);
+
+/**
+ * Returns if statistics collection is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool stats_enabled(void);
+
+/**
+ * Returns the display name of a statistics phase.
+ *
+ * @param {StatPhase} phase - The phase.
+ * @return {char*} The phase name.
+ */
+const char* stats_phase_name(const StatPhase phase);
+
+/**
+ * Returns the calling threads statistics counters.
+ *
+ * @return {statcounters_t*} The counters of the calling thread.
+ */
+statcounters_t* stats_thread(void);
+
+/**
+ * Returns the cpu time consumed by the calling thread.
+ *
+ * @return {uint64_t} The thread cpu time in nanoseconds.
+ */
+uint64_t stats_thread_cpu_ns(void);
+
+/**
+ * Records a written file and its byte counts.
+ *
+ * @param {uint64_t} bytesIn - The count of compressed bytes read.
+ * @param {uint64_t} bytesOut - The count of decompressed bytes written.
+ */
+void stats_add_file(const uint64_t bytesIn, const uint64_t bytesOut);
+
+/**
+ * Prints the aggregated statistics of all threads.
+ *
+ * @param {double} wallSecs - The total wall time of the run in seconds.
+ */
+void stats_print(const double wallSecs);
+
+/**
+ * Statistics Scope Structure
+ *
+ * Adds the wall and cpu time between its construction and destruction to the given phase, records it as
+ * a trace span when tracing is enabled, and samples the hardware counters around the read, decode and write phases.
+ * Heap allocations made while the scope is alive are accounted to its phase. The read, decode and write times are
+ * also added to the service metrics when they are enabled.
+ */
+struct statscope_t
+{
+    statscope_t(const StatPhase phase);
+    ~statscope_t(void);
+
+    statscope_t(const statscope_t&) = delete;
+    statscope_t& operator=(const statscope_t&) = delete;
+
+    void bytes(const uint64_t bytes);
+
+private:
+    StatPhase m_Phase;
+    bool m_Stats;
+    bool m_Trace;
+    bool m_Perf;
+    bool m_Metrics;
+    uint64_t m_Bytes;
+    std::chrono::steady_clock::time_point m_Wall;
+    uint64_t m_Cpu;
+    perfsample_t m_PerfBegin;
+    int32_t m_MemPhase;
+};
+
+#endif // DEPAK_STATS_H_INCLUDED
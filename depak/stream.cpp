@@ -0,0 +1,305 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Extraction of PAK files read from non-seekable input streams. (Pipes and standard input.)
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <cstdlib>
+#include <unistd.h>
+#endif
+
+#include "logger.h"
+#include "stats.h"
+#include "stream.h"
+
+/**
+ * Creates the spill file of a spill store with a unique name in its directory.
+ *
+ * The name is picked and the file created in one step (GetTempFileName / mkstemp), so an existing file is never
+ * opened or replaced.
+ *
+ * @param {spillstore_t&} s - The spill store.
+ * @return {bool} True on success, false otherwise.
+ */
+static bool spill_create(spillstore_t& s)
+{
+#if defined(_WIN32)
+    char path[MAX_PATH]{};
+    if (::GetTempFileNameA(s.Dir.c_str(), u8"dpk", 0, path) == 0)
+        return false;
+
+    if (fopen_s(&s.File, path, u8"r+b") != ERROR_SUCCESS)
+    {
+        s.File = nullptr;
+        ::DeleteFileA(path);
+        return false;
+    }
+#else
+    std::string path = s.Dir + u8"/depak-XXXXXX.spill";
+
+    const auto fd = ::mkstemps(&path[0], 6);
+    if (fd == -1)
+        return false;
+
+    s.File = ::fdopen(fd, u8"w+b");
+    if (s.File == nullptr)
+    {
+        ::close(fd);
+        ::unlink(path.c_str());
+        return false;
+    }
+#endif
+
+    s.Path = path;
+    return true;
+}
+
+/**
+ * Appends bytes to a spill store, moving the store to its spill file when it grows past the memory limit.
+ *
+ * @param {spillstore_t&} s - The spill store.
+ * @param {uint8_t*} data - The bytes to append.
+ * @param {std::size_t} size - The count of bytes to append.
+ * @return {bool} True on success, false otherwise.
+ */
+bool spill_write(spillstore_t& s, const uint8_t* data, const std::size_t size)
+{
+    if (size == 0)
+        return true;
+
+    // Move the store to its spill file the first time it would grow past the memory limit..
+    if (s.File == nullptr && s.Size + size > s.Limit)
+    {
+        if (!spill_create(s))
+            return false;
+
+        // From here on the file exists, so failures leave it to spill_close to remove..
+        if (!s.Memory.empty() && fwrite(s.Memory.data(), 1, s.Memory.size(), s.File) != s.Memory.size())
+            return false;
+
+        std::vector<uint8_t>().swap(s.Memory);
+    }
+
+    if (s.File != nullptr)
+    {
+        if (fwrite(data, 1, size, s.File) != size)
+            return false;
+    }
+    else
+    {
+        // Grow by doubling, but never reserve past the limit..
+        if (s.Memory.capacity() < s.Size + size)
+            s.Memory.reserve((std::size_t)std::min<uint64_t>(s.Limit, std::max<uint64_t>(s.Memory.capacity() * 2, s.Size + size)));
+        s.Memory.insert(s.Memory.end(), data, data + size);
+    }
+
+    s.Size += size;
+    return true;
+}
+
+/**
+ * Reads stored bytes from a spill store.
+ *
+ * @param {spillstore_t&} s - The spill store.
+ * @param {uint64_t} offset - The offset to read from.
+ * @param {uint8_t*} data - The buffer to receive the bytes.
+ * @param {std::size_t} size - The count of bytes to read.
+ * @return {bool} True on success, false if the range is not stored.
+ */
+bool spill_read(spillstore_t& s, const uint64_t offset, uint8_t* data, const std::size_t size)
+{
+    if (offset > s.Size || s.Size - offset < size)
+        return false;
+
+    if (s.File == nullptr)
+    {
+        ::memcpy(data, s.Memory.data() + offset, size);
+        return true;
+    }
+
+    // Step back to the end afterwards so later writes keep appending..
+    if (_fseeki64(s.File, offset, SEEK_SET) != 0)
+        return false;
+
+    const auto read = fread(data, 1, size, s.File) == size;
+    _fseeki64(s.File, 0, SEEK_END);
+    return read;
+}
+
+/**
+ * Closes a spill store and removes its spill file.
+ *
+ * @param {spillstore_t&} s - The spill store.
+ */
+void spill_close(spillstore_t& s)
+{
+    if (s.File != nullptr)
+        fclose(s.File);
+    if (!s.Path.empty())
+        std::remove(s.Path.c_str());
+
+    s.File = nullptr;
+    s.Path.clear();
+    s.Size = 0;
+    std::vector<uint8_t>().swap(s.Memory);
+}
+
+/**
+ * Reads a Kaiko compressed PAK file front to back from a non-seekable stream and extracts all of its file entries.
+ *
+ * The file data is stored in a spill store until the entry and string tables at the end of the file arrive, and is
+ * then extracted from the store.
+ *
+ * @param {FILE*} f - The opened input stream.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_stream(FILE* f, const extractoptions_t& opts, extractresult_t& result)
+{
+    result = extractresult_t{};
+
+    // Read the PAK header..
+    pakheader_t header{};
+    {
+        statscope_t scope(StatPhase::Header);
+        if (fread(&header, sizeof(pakheader_t), 1, f) != 1)
+        {
+            log_error(u8"[!] Error: Invalid file size; cannot parse PAK file.\r\n");
+            return false;
+        }
+    }
+
+    if (header.Signature != PakFileType::KaikoCompressedLE)
+    {
+        log_error(u8"[!] Error: PAK file type unsupported!\r\n");
+        return false;
+    }
+    if (header.IsValid == 0 || header.EntriesOffset < sizeof(pakheader_t))
+    {
+        log_error(u8"[!] Error: Invalid PAK information; cannot process.\r\n");
+        return false;
+    }
+
+    log_info(u8"[!] Info: Processing PAK file type: Kaiko Compressed (Little Endian) from a stream\r\n\r\n");
+
+    // The spill file is only created once the stream outgrows the memory limit..
+    spillstore_t spill{};
+    spill.Limit = opts.SpillMemory;
+    spill.Dir   = opts.SpillDir;
+
+    // Store the header and file data up to the entry table; the files cannot be told apart until the tables arrive..
+    std::vector<uint8_t> block(STREAM_BLOCK_SIZE);
+    if (!spill_write(spill, (const uint8_t*)&header, sizeof(pakheader_t)))
+    {
+        log_error(u8"[!] Error: Failed to write the spill file in: %s\r\n", opts.SpillDir.c_str());
+        spill_close(spill);
+        return false;
+    }
+
+    while (spill.Size < header.EntriesOffset)
+    {
+        statscope_t scope(StatPhase::Read);
+
+        const auto size = (std::size_t)std::min<uint64_t>(block.size(), header.EntriesOffset - spill.Size);
+        const auto read = fread(block.data(), 1, size, f);
+        scope.bytes(read);
+
+        if (read != size)
+        {
+            log_error(u8"[!] Error: The stream ended before the entry table.\r\n");
+            spill_close(spill);
+            return false;
+        }
+        if (!spill_write(spill, block.data(), read))
+        {
+            log_error(u8"[!] Error: Failed to write the spill file in: %s\r\n", opts.SpillDir.c_str());
+            spill_close(spill);
+            return false;
+        }
+    }
+
+    // Read the entry table; it runs to the end of the stream..
+    std::vector<pakfileentry_t> entries;
+    uint32_t sCount = 0;
+    {
+        statscope_t scope(StatPhase::Entries);
+
+        std::vector<uint8_t> table;
+        for (;;)
+        {
+            const auto read = fread(block.data(), 1, block.size(), f);
+            table.insert(table.end(), block.data(), block.data() + read);
+            if (read < block.size())
+                break;
+        }
+
+        if (ferror(f) != 0 || !pak_parse_entries(table.data(), table.size(), entries, sCount))
+        {
+            log_error(u8"[!] Error: Failed to read the entries table; cannot continue to parse.\r\n");
+            spill_close(spill);
+            return false;
+        }
+
+        // Sort the file list by its file position..
+        pak_sort_entries(entries);
+    }
+
+    log_info(u8"[!] Info: Entry Count: %d\r\n", (uint32_t)entries.size());
+    log_info(u8"[!] Info: Entry Count: %d (Special)\r\n\r\n", sCount);
+    if (sCount > 0)
+        log_info(u8"[!] Warning: Special entries are not currently supported.\r\n");
+
+    // Read the string table from the store; it is the last entry..
+    std::vector<std::tuple<uint32_t, std::string>> strings;
+    if (!entries.empty())
+    {
+        statscope_t scope(StatPhase::Strings);
+
+        const auto table  = entries.back();
+        const auto offset = (uint64_t)table.Position * header.Unknown00;
+        entries.pop_back();
+
+        uint32_t tSize = 0; // The string table size..
+        std::vector<uint8_t> data;
+        auto valid = spill_read(spill, offset, (uint8_t*)&tSize, 4) && tSize > 0 && tSize <= spill.Size;
+        if (valid)
+        {
+            data.resize(tSize);
+            valid = spill_read(spill, offset + 8, data.data(), data.size()) && pak_parse_names(data.data(), data.size(), strings);
+        }
+
+        if (!valid)
+        {
+            log_error(u8"[!] Error: Invalid string table size; cannot continue to parse.\r\n");
+            spill_close(spill);
+            return false;
+        }
+    }
+
+    std::vector<std::string> names;
+    extract_resolve_names(entries, strings, names);
+
+    // Extract straight from memory when the stream fit, from the spill file otherwise..
+    bool extracted = false;
+    if (spill.File == nullptr)
+    {
+        log_info(u8"[!] Info: Held the whole stream in memory (%.2f MB); decoding from memory.\r\n", (double)spill.Size / (1024.0 * 1024.0));
+        extracted = extract_entries_image(spill.Memory.data(), spill.Size, &header, entries, names, opts, result);
+    }
+    else
+    {
+        log_info(u8"[!] Info: Spilled %.2f MB of the stream to: %s\r\n", (double)spill.Size / (1024.0 * 1024.0), spill.Path.c_str());
+
+        fflush(spill.File);
+        extracted = extract_entries(spill.Path.c_str(), &header, entries, names, opts, result);
+    }
+
+    spill_close(spill);
+    return extracted;
+}
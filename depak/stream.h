@@ -0,0 +1,80 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Extraction of PAK files read from non-seekable input streams. (Pipes and standard input.)
+ */
+#ifndef DEPAK_STREAM_H_INCLUDED
+#define DEPAK_STREAM_H_INCLUDED
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "extract.h"
+
+/**
+ * The size of each read from the input stream.
+ */
+constexpr std::size_t STREAM_BLOCK_SIZE = 1024 * 1024;
+
+/**
+ * Spill Store Structure
+ *
+ * The bytes of a PAK file read from a stream, held in memory up to a limit and moved to a temporary file once the
+ * stream grows past it. The store keeps every byte at its original offset, so once the tables have arrived it is
+ * extracted like any other PAK file; from memory directly or from the spill file with the requested backend.
+ */
+struct spillstore_t
+{
+    std::vector<uint8_t> Memory; // The stored bytes while they fit in memory. (Emptied once spilled.)
+    uint64_t Limit;              // The most bytes held in memory before spilling.
+    std::string Dir;             // The directory the spill file is created in.
+    std::string Path;            // The spill file path. (Empty until the spill file is created.)
+    FILE* File;                  // The spill file. (nullptr until the limit is passed.)
+    uint64_t Size;               // The count of bytes stored.
+};
+
+/**
+ * Appends bytes to a spill store, moving the store to its spill file when it grows past the memory limit.
+ *
+ * @param {spillstore_t&} s - The spill store.
+ * @param {uint8_t*} data - The bytes to append.
+ * @param {std::size_t} size - The count of bytes to append.
+ * @return {bool} True on success, false otherwise.
+ */
+bool spill_write(spillstore_t& s, const uint8_t* data, const std::size_t size);
+
+/**
+ * Reads stored bytes from a spill store.
+ *
+ * @param {spillstore_t&} s - The spill store.
+ * @param {uint64_t} offset - The offset to read from.
+ * @param {uint8_t*} data - The buffer to receive the bytes.
+ * @param {std::size_t} size - The count of bytes to read.
+ * @return {bool} True on success, false if the range is not stored.
+ */
+bool spill_read(spillstore_t& s, const uint64_t offset, uint8_t* data, const std::size_t size);
+
+/**
+ * Closes a spill store and removes its spill file.
+ *
+ * @param {spillstore_t&} s - The spill store.
+ */
+void spill_close(spillstore_t& s);
+
+/**
+ * Reads a Kaiko compressed PAK file front to back from a non-seekable stream and extracts all of its file entries.
+ *
+ * The file data is stored in a spill store until the entry and string tables at the end of the file arrive, and is
+ * then extracted from the store.
+ *
+ * @param {FILE*} f - The opened input stream.
+ * @param {extractoptions_t&} opts - The extraction options.
+ * @param {extractresult_t&} result - The result to populate.
+ * @return {bool} True on success, false otherwise.
+ */
+bool extract_stream(FILE* f, const extractoptions_t& opts, extractresult_t& result);
+
+#endif // DEPAK_STREAM_H_INCLUDED
@@ -0,0 +1,158 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Entry and string table parsing microbenchmark.
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "extract.h"
+#include "generator.h"
+#include "pak.h"
+#include "tablebench.h"
+
+/**
+ * Table Benchmark Step Enumeration
+ *
+ */
+enum class TableStep
+{
+    Entries, // Parsing the entry table.
+    Sort,    // Sorting the entries by their file position.
+    Names,   // Parsing the string table.
+    Index,   // Building the name index.
+    Resolve, // Resolving the output name of every entry. (Includes building the index.)
+    Count
+};
+
+/**
+ * Builds the synthetic tables of the given size, laid out the same way the generator writes them.
+ *
+ * @param {genoptions_t&} opts - The generator options.
+ * @param {uint64_t} count - The count of file entries.
+ * @param {std::vector<uint8_t>&} entryTable - The vector to receive the entry table.
+ * @param {std::vector<uint8_t>&} stringTable - The vector to receive the name records of the string table.
+ */
+static void table_build(const genoptions_t& opts, const uint64_t count, std::vector<uint8_t>& entryTable, std::vector<uint8_t>& stringTable)
+{
+    std::vector<pakfileentry_t> entries((std::size_t)count);
+    stringTable.clear();
+
+    for (uint64_t x = 0; x < count; x++)
+    {
+        entries[(std::size_t)x] = {gen_file_id(opts, x), (uint32_t)x, 0};
+
+        const auto name      = gen_file_name(opts, x);
+        const uint32_t id[2] = {entries[(std::size_t)x].Crc, (uint32_t)name.size()};
+        stringTable.insert(stringTable.end(), (const uint8_t*)id, (const uint8_t*)id + sizeof(id));
+        stringTable.insert(stringTable.end(), name.begin(), name.end());
+    }
+
+    // The entry table is ordered by id like the game archives..
+    std::sort(entries.begin(), entries.end(), [](const pakfileentry_t& a, const pakfileentry_t& b) -> bool {
+        return a.Crc < b.Crc;
+    });
+
+    const uint32_t counts[2] = {(uint32_t)count, 0};
+    entryTable.resize(sizeof(counts) + entries.size() * sizeof(pakfileentry_t));
+    ::memcpy(entryTable.data(), counts, sizeof(counts));
+    ::memcpy(entryTable.data() + sizeof(counts), entries.data(), entries.size() * sizeof(pakfileentry_t));
+}
+
+/**
+ * Runs a step the given count of times and returns the fastest run.
+ *
+ * @param {uint32_t} repeat - The count of timed runs.
+ * @param {std::function} prepare - Called before each run, outside of the timed region.
+ * @param {std::function} run - The step to time.
+ * @return {double} The fastest run in seconds.
+ */
+static double table_time(const uint32_t repeat, const std::function<void(void)>& prepare, const std::function<void(void)>& run)
+{
+    auto best = 0.0;
+    for (uint32_t x = 0; x < repeat; x++)
+    {
+        prepare();
+
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (x == 0 || secs < best)
+            best = secs;
+    }
+    return best;
+}
+
+/**
+ * Parses synthetic entry and string tables held in memory, from 10k entries up to the given maximum in steps of ten,
+ * and reports the time per entry of each parsing step.
+ *
+ * @param {uint64_t} maxEntries - The largest table size to parse.
+ * @param {uint32_t} repeat - The count of timed runs per step; the fastest is reported.
+ * @param {uint64_t} seed - The random seed.
+ * @return {bool} True on success, false otherwise.
+ */
+bool table_bench(const uint64_t maxEntries, const uint32_t repeat, const uint64_t seed)
+{
+    auto opts = gen_default_options();
+    opts.Seed = seed;
+
+    printf_s(u8"[!] Info: Parsing in-memory tables of 10000 to %llu entries, fastest of %u runs.\r\n\r\n", (unsigned long long)maxEntries, repeat);
+    printf_s(u8"    %10s %10s %10s %12s %12s %12s %12s %12s\r\n", u8"Entries", u8"Entry MB", u8"String MB", u8"Entries", u8"Sort", u8"Names", u8"Index", u8"Resolve");
+    printf_s(u8"    %10s %10s %10s %12s %12s %12s %12s %12s\r\n", u8"", u8"", u8"", u8"ns/entry", u8"ns/entry", u8"ns/entry", u8"ns/entry", u8"ns/entry");
+
+    std::vector<uint8_t> entryTable;
+    std::vector<uint8_t> stringTable;
+    std::vector<pakfileentry_t> entries;
+    std::vector<pakfileentry_t> sorted;
+    std::vector<std::tuple<uint32_t, std::string>> strings;
+    std::unordered_map<uint32_t, std::size_t> index;
+    std::vector<std::string> names;
+
+    for (uint64_t count = 10000; count <= maxEntries && count <= UINT32_MAX; count *= 10)
+    {
+        table_build(opts, count, entryTable, stringTable);
+
+        bool ok = true;
+        double secs[(int)TableStep::Count]{};
+        uint32_t specialCount = 0;
+
+        secs[(int)TableStep::Entries] = table_time(repeat, [&]() {}, [&]() {
+            ok &= pak_parse_entries(entryTable.data(), entryTable.size(), entries, specialCount);
+        });
+        secs[(int)TableStep::Sort] = table_time(repeat, [&]() { sorted = entries; }, [&]() {
+            pak_sort_entries(sorted);
+        });
+        secs[(int)TableStep::Names] = table_time(repeat, [&]() { strings.clear(); strings.shrink_to_fit(); }, [&]() {
+            ok &= pak_parse_names(stringTable.data(), stringTable.size(), strings);
+        });
+        secs[(int)TableStep::Index] = table_time(repeat, [&]() { index = {}; }, [&]() {
+            pak_index_names(strings, index);
+        });
+        secs[(int)TableStep::Resolve] = table_time(repeat, [&]() { names.clear(); names.shrink_to_fit(); }, [&]() {
+            extract_resolve_names(sorted, strings, names);
+        });
+
+        // Every entry must have been parsed and given its generated name..
+        ok &= entries.size() == count && strings.size() == count && names.size() == count && index.size() == count;
+        ok &= std::is_sorted(sorted.begin(), sorted.end(), [](const pakfileentry_t& a, const pakfileentry_t& b) -> bool { return a.Position < b.Position; });
+        ok &= names.empty() || names.back() == gen_file_name(opts, count - 1);
+        if (!ok)
+        {
+            printf_s(u8"[!] Error: Failed to parse the synthetic tables of %llu entries.\r\n", (unsigned long long)count);
+            return false;
+        }
+
+        const auto ns = [&](const TableStep step) -> double { return secs[(int)step] * 1e9 / (double)count; };
+        printf_s(u8"    %10llu %10.2f %10.2f %12.2f %12.2f %12.2f %12.2f %12.2f\r\n", (unsigned long long)count, (double)entryTable.size() / (1024.0 * 1024.0),
+            (double)stringTable.size() / (1024.0 * 1024.0), ns(TableStep::Entries), ns(TableStep::Sort), ns(TableStep::Names), ns(TableStep::Index), ns(TableStep::Resolve));
+    }
+
+    return true;
+}
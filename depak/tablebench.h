@@ -0,0 +1,23 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Entry and string table parsing microbenchmark.
+ */
+#ifndef DEPAK_TABLEBENCH_H_INCLUDED
+#define DEPAK_TABLEBENCH_H_INCLUDED
+
+#include <cstdint>
+
+/**
+ * Parses synthetic entry and string tables held in memory, from 10k entries up to the given maximum in steps of ten,
+ * and reports the time per entry of each parsing step.
+ *
+ * @param {uint64_t} maxEntries - The largest table size to parse.
+ * @param {uint32_t} repeat - The count of timed runs per step; the fastest is reported.
+ * @param {uint64_t} seed - The random seed.
+ * @return {bool} True on success, false otherwise.
+ */
+bool table_bench(const uint64_t maxEntries, const uint32_t repeat, const uint64_t seed);
+
+#endif // DEPAK_TABLEBENCH_H_INCLUDED
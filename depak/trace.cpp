@@ -0,0 +1,229 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Chrome trace-event (Perfetto) span recording.
+ */
+#include <Windows.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+#include "trace.h"
+
+/**
+ * Trace Ring Structure
+ *
+ * Written only by its owning thread; Head is published with release ordering so the ring can be read once
+ * the thread has stopped recording.
+ */
+struct tracering_t
+{
+    uint32_t ThreadId;                     // The trace thread id.
+    std::atomic<uint64_t> Head;            // The total count of events recorded.
+    std::unique_ptr<traceevent_t[]> Events; // The event ring.
+};
+
+/**
+ * Trace state.
+ */
+static std::atomic<bool> g_TraceEnabled{false};
+static std::string g_TracePath;
+static std::chrono::steady_clock::time_point g_TraceStart;
+static std::mutex g_TraceMutex;
+static std::vector<std::unique_ptr<tracering_t>> g_TraceRings;
+
+/**
+ * Returns the calling threads trace ring.
+ *
+ * @return {tracering_t*} The ring of the calling thread.
+ */
+static tracering_t* trace_thread(void)
+{
+    thread_local tracering_t* ring = nullptr;
+    if (ring == nullptr)
+    {
+        auto r      = std::make_unique<tracering_t>();
+        r->Head     = 0;
+        r->Events   = std::make_unique<traceevent_t[]>(TRACE_RING_SIZE);
+
+        std::lock_guard<std::mutex> lock(g_TraceMutex);
+        r->ThreadId = (uint32_t)g_TraceRings.size() + 1;
+        ring        = r.get();
+        g_TraceRings.push_back(std::move(r));
+    }
+    return ring;
+}
+
+/**
+ * Writes a json escaped string to the given file.
+ *
+ * @param {FILE*} f - The output file.
+ * @param {char*} str - The string to write.
+ */
+static void trace_write_string(FILE* f, const char* str)
+{
+    fputc('"', f);
+    for (auto p = (const unsigned char*)str; *p; p++)
+    {
+        if (*p == '"' || *p == '\\')
+            fprintf_s(f, u8"\\%c", *p);
+        else if (*p < 0x20)
+            fprintf_s(f, u8"\\u%04x", *p);
+        else
+            fputc(*p, f);
+    }
+    fputc('"', f);
+}
+
+/**
+ * Starts recording trace events; they are written to the given path by trace_flush or at exit.
+ *
+ * @param {char*} path - The output json file path.
+ */
+void trace_open(const char* path)
+{
+    g_TracePath  = path;
+    g_TraceStart = std::chrono::steady_clock::now();
+    g_TraceEnabled.store(true, std::memory_order_release);
+
+    std::atexit(trace_flush);
+}
+
+/**
+ * Returns if trace recording is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool trace_enabled(void)
+{
+    return g_TraceEnabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * Records a completed span into the calling threads ring buffer.
+ *
+ * @param {char*} name - The span name. (Must be a string literal.)
+ * @param {std::chrono::steady_clock::time_point} begin - The span start time.
+ * @param {std::chrono::steady_clock::time_point} end - The span end time.
+ * @param {uint64_t} bytes - The count of bytes processed in the span.
+ * @param {char*} detail - Optional detail text.
+ */
+void trace_record(const char* name, const std::chrono::steady_clock::time_point begin, const std::chrono::steady_clock::time_point end, const uint64_t bytes, const char* detail)
+{
+    if (!trace_enabled())
+        return;
+
+    auto ring       = trace_thread();
+    const auto head = ring->Head.load(std::memory_order_relaxed);
+    auto& e         = ring->Events[head & (TRACE_RING_SIZE - 1)];
+
+    e.Name  = name;
+    e.Begin = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(begin - g_TraceStart).count();
+    e.End   = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - g_TraceStart).count();
+    e.Bytes = bytes;
+
+    e.Detail[0] = '\0';
+    if (detail != nullptr)
+    {
+        // Keep the tail of long names; it holds the most distinctive part. (Cut at a UTF-8 code point boundary.)
+        const auto len = ::strlen(detail);
+        auto src       = len >= sizeof(e.Detail) ? detail + len - (sizeof(e.Detail) - 1) : detail;
+        while (src != detail && ((uint8_t)*src & 0xC0) == 0x80)
+            src++;
+        ::memcpy(e.Detail, src, ::strlen(src) + 1);
+    }
+
+    ring->Head.store(head + 1, std::memory_order_release);
+}
+
+/**
+ * Writes the recorded events of all threads to the trace file. Threads must no longer be recording.
+ */
+void trace_flush(void)
+{
+    if (!g_TraceEnabled.exchange(false))
+        return;
+
+    std::lock_guard<std::mutex> lock(g_TraceMutex);
+
+    FILE* f = nullptr;
+    if (fopen_s(&f, g_TracePath.c_str(), u8"wb") != ERROR_SUCCESS)
+    {
+        log_error(u8"[!] Error: Failed to open trace file for writing: %s\r\n", g_TracePath.c_str());
+        return;
+    }
+
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+
+    fprintf_s(f, u8"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf_s(f, u8"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"depak\"}}");
+
+    for (const auto& ring : g_TraceRings)
+    {
+        fprintf_s(f, u8",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}", ring->ThreadId, ring->ThreadId);
+
+        const auto head  = ring->Head.load(std::memory_order_acquire);
+        const auto first = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+        dropped += first;
+
+        for (auto x = first; x < head; x++)
+        {
+            const auto& e = ring->Events[x & (TRACE_RING_SIZE - 1)];
+
+            fprintf_s(f, u8",\n{\"name\":\"%s\",\"cat\":\"depak\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%llu",
+                e.Name, ring->ThreadId, (double)e.Begin / 1000.0, (double)(e.End - e.Begin) / 1000.0, (unsigned long long)e.Bytes);
+            if (e.Detail[0] != '\0')
+            {
+                fprintf_s(f, u8",\"file\":");
+                trace_write_string(f, e.Detail);
+            }
+            fprintf_s(f, u8"}}");
+            written++;
+        }
+    }
+
+    fprintf_s(f, u8"\n]}\n");
+    fclose(f);
+
+    log_info(u8"[!] Info: Wrote %llu trace events to: %s\r\n", (unsigned long long)written, g_TracePath.c_str());
+    if (dropped > 0)
+        log_error(u8"[!] Warning: %llu of the oldest trace events were overwritten; the ring holds %u events per thread.\r\n", (unsigned long long)dropped, TRACE_RING_SIZE);
+}
+
+/**
+ * Constructor and Destructor
+ *
+ * @param {char*} name - The span name. (Must be a string literal; nullptr disables the scope.)
+ * @param {char*} detail - Optional detail text; must outlive the scope.
+ */
+tracescope_t::tracescope_t(const char* name, const char* detail)
+    : m_Name(name)
+    , m_Detail(detail)
+    , m_Active(name != nullptr && trace_enabled())
+    , m_Bytes(0)
+{
+    if (m_Active)
+        m_Begin = std::chrono::steady_clock::now();
+}
+tracescope_t::~tracescope_t(void)
+{
+    if (m_Active)
+        trace_record(m_Name, m_Begin, std::chrono::steady_clock::now(), m_Bytes, m_Detail);
+}
+
+/**
+ * Sets the count of bytes processed in the span.
+ *
+ * @param {uint64_t} bytes - The count of bytes.
+ */
+void tracescope_t::bytes(const uint64_t bytes)
+{
+    m_Bytes = bytes;
+}
@@ -0,0 +1,84 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Chrome trace-event (Perfetto) span recording.
+ */
+#ifndef DEPAK_TRACE_H_INCLUDED
+#define DEPAK_TRACE_H_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * The count of events kept per thread; once full, the oldest events are overwritten.
+ */
+constexpr uint32_t TRACE_RING_SIZE = 1 << 17;
+
+/**
+ * Trace Event Structure
+ *
+ */
+struct traceevent_t
+{
+    const char* Name; // The span name. (Must be a string literal.)
+    uint64_t Begin;   // The span start, in nanoseconds since tracing started.
+    uint64_t End;     // The span end, in nanoseconds since tracing started.
+    uint64_t Bytes;   // The count of bytes processed in the span.
+    char Detail[32];  // Optional detail text. (Truncated file name.)
+};
+
+/**
+ * Starts recording trace events; they are written to the given path by trace_flush or at exit.
+ *
+ * @param {char*} path - The output json file path.
+ */
+void trace_open(const char* path);
+
+/**
+ * Returns if trace recording is enabled.
+ *
+ * @return {bool} True if enabled, false otherwise.
+ */
+bool trace_enabled(void);
+
+/**
+ * Records a completed span into the calling threads ring buffer.
+ *
+ * @param {char*} name - The span name. (Must be a string literal.)
+ * @param {std::chrono::steady_clock::time_point} begin - The span start time.
+ * @param {std::chrono::steady_clock::time_point} end - The span end time.
+ * @param {uint64_t} bytes - The count of bytes processed in the span.
+ * @param {char*} detail - Optional detail text.
+ */
+void trace_record(const char* name, const std::chrono::steady_clock::time_point begin, const std::chrono::steady_clock::time_point end, const uint64_t bytes, const char* detail);
+
+/**
+ * Writes the recorded events of all threads to the trace file. Threads must no longer be recording.
+ */
+void trace_flush(void);
+
+/**
+ * Trace Scope Structure
+ *
+ * Records a span covering its lifetime when tracing is enabled.
+ */
+struct tracescope_t
+{
+    tracescope_t(const char* name, const char* detail = nullptr);
+    ~tracescope_t(void);
+
+    tracescope_t(const tracescope_t&) = delete;
+    tracescope_t& operator=(const tracescope_t&) = delete;
+
+    void bytes(const uint64_t bytes);
+
+private:
+    const char* m_Name;
+    const char* m_Detail;
+    bool m_Active;
+    uint64_t m_Bytes;
+    std::chrono::steady_clock::time_point m_Begin;
+};
+
+#endif // DEPAK_TRACE_H_INCLUDED
@@ -0,0 +1,273 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Checks the C api of libdepak from plain C: whole and range reads of an intact archive, and clean errors instead of
+ * crashes on truncated and corrupted copies of it.
+ *
+ * Usage: depak_capi_test <file.pak> <work dir>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libdepak.h"
+
+/**
+ * The count of failed checks.
+ */
+static unsigned long long g_Failures = 0;
+
+/**
+ * Records a failed check.
+ *
+ * @param {char*} what - The check that failed.
+ * @param {char*} detail - The archive or entry the check was made on.
+ */
+static void capi_fail(const char* what, const char* detail)
+{
+    printf("FAIL: %s (%s)\n", what, detail);
+    g_Failures++;
+}
+
+/**
+ * Reads a whole file into memory.
+ *
+ * @param {char*} path - The file path.
+ * @param {size_t*} size - Receives the size of the file.
+ * @return {uint8_t*} The file data on success, NULL otherwise. (Released with free.)
+ */
+static uint8_t* capi_load(const char* path, size_t* size)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    *size = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint8_t* data = (uint8_t*)malloc(*size + 1);
+    if (data != NULL && fread(data, 1, *size, f) != *size)
+    {
+        free(data);
+        data = NULL;
+    }
+
+    fclose(f);
+    return data;
+}
+
+/**
+ * Writes a file.
+ *
+ * @param {char*} path - The file path.
+ * @param {uint8_t*} data - The file data.
+ * @param {size_t} size - The size of the file data.
+ * @return {int} 1 on success, 0 otherwise.
+ */
+static int capi_save(const char* path, const uint8_t* data, const size_t size)
+{
+    FILE* f = fopen(path, "wb");
+    if (f == NULL)
+        return 0;
+
+    const int ok = size == 0 || fwrite(data, 1, size, f) == size;
+    fclose(f);
+    return ok;
+}
+
+/**
+ * Reads every entry of an archive; every read must either succeed with consistent sizes or fail with an error status.
+ *
+ * @param {depak_archive*} archive - The archive.
+ * @param {char*} name - The archive name, for reporting.
+ * @param {uint64_t*} failed - Receives the count of entries that failed to read.
+ */
+static void capi_read_all(depak_archive* archive, const char* name, uint64_t* failed)
+{
+    *failed = 0;
+
+    const uint64_t count = depak_entry_count(archive);
+    for (uint64_t x = 0; x < count; x++)
+    {
+        uint64_t size = 0;
+        if (depak_entry_size(archive, x, &size) != DEPAK_OK)
+        {
+            (*failed)++;
+            continue;
+        }
+
+        // Querying the size with no buffer must report it, unless the entry turns out to be damaged..
+        uint64_t needed     = 0;
+        const int32_t query = depak_read(archive, x, NULL, 0, &needed);
+        if (size > 0 && query != DEPAK_ERROR_READ && (query != DEPAK_ERROR_BUFFER || needed != size))
+            capi_fail("depak_read did not report the needed size", name);
+
+        uint8_t* data = (uint8_t*)malloc((size_t)size + 1);
+        uint64_t read = 0;
+        const int32_t status = depak_read(archive, x, data, size, &read);
+        if (status == DEPAK_OK)
+        {
+            if (read != size)
+                capi_fail("depak_read returned the wrong size", name);
+
+            // A range in the middle of the entry must match the whole read..
+            if (size > 2)
+            {
+                uint8_t* range = (uint8_t*)malloc((size_t)size);
+                uint64_t got   = 0;
+                if (depak_read_range(archive, x, 1, UINT64_MAX, range, size, &got) != DEPAK_OK || got != size - 1 || memcmp(range, data + 1, (size_t)got) != 0)
+                    capi_fail("depak_read_range does not match depak_read", name);
+                free(range);
+            }
+        }
+        else if (status == DEPAK_ERROR_READ)
+            (*failed)++;
+        else
+            capi_fail("depak_read returned an unexpected status", name);
+
+        free(data);
+    }
+
+    // Indexes past the table are argument errors..
+    depak_entry_info info;
+    uint64_t size = 0;
+    if (depak_entry(archive, count, &info) != DEPAK_ERROR_ARGUMENT || depak_read(archive, count, NULL, 0, &size) != DEPAK_ERROR_ARGUMENT)
+        capi_fail("an index past the entry table was accepted", name);
+}
+
+/**
+ * Application entry point.
+ *
+ * @param {int} argc - The count of parameters passed to the application.
+ * @param {char*[]} argv - The array of parameters passed to the application.
+ * @return {int} 0 when every check passed, 1 otherwise.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        printf("Usage: depak_capi_test <file.pak> <work dir>\n");
+        return 1;
+    }
+
+    if (depak_api_version() != DEPAK_API_VERSION)
+        capi_fail("depak_api_version does not match the header", argv[1]);
+
+    size_t size   = 0;
+    uint8_t* data = capi_load(argv[1], &size);
+    if (data == NULL || size < 32)
+    {
+        printf("FAIL: Failed to load the PAK file: %s\n", argv[1]);
+        return 1;
+    }
+
+    // The intact archive reads every entry..
+    depak_archive* archive = depak_open(argv[1]);
+    if (archive == NULL)
+    {
+        printf("FAIL: Failed to open the PAK file: %s\n", argv[1]);
+        return 1;
+    }
+
+    uint64_t failed = 0;
+    capi_read_all(archive, argv[1], &failed);
+    if (failed != 0)
+        capi_fail("entries of the intact archive failed to read", argv[1]);
+
+    const uint64_t count = depak_entry_count(archive);
+    depak_entry_info first;
+    depak_entry_info second;
+    if (count < 2 || depak_entry(archive, 0, &first) != DEPAK_OK || depak_entry(archive, 1, &second) != DEPAK_OK)
+    {
+        printf("FAIL: The PAK file needs at least two entries: %s\n", argv[1]);
+        return 1;
+    }
+    depak_close(archive);
+
+    char path[4096];
+    uint8_t* copy = (uint8_t*)malloc(size);
+
+    // Truncated copies lose the tables at the end of the file and must not open..
+    const size_t lengths[] = {0, 16, 31, 32, size / 2, size - 1};
+    for (size_t x = 0; x < sizeof(lengths) / sizeof(lengths[0]); x++)
+    {
+        snprintf(path, sizeof(path), "%s/truncated-%zu.pak", argv[2], lengths[x]);
+        if (!capi_save(path, data, lengths[x]))
+        {
+            capi_fail("failed to write a damaged copy", path);
+            continue;
+        }
+
+        archive = depak_open(path);
+        if (archive != NULL)
+        {
+            capi_fail("a truncated archive opened", path);
+            depak_close(archive);
+        }
+        remove(path);
+    }
+
+    // An entry count far past the end of the file must not open..
+    uint64_t entriesOffset = 0;
+    memcpy(&entriesOffset, data + 16, 8);
+    if (entriesOffset + 4 <= size)
+    {
+        const uint32_t huge = 0x7FFFFFFF;
+        memcpy(copy, data, size);
+        memcpy(copy + entriesOffset, &huge, 4);
+
+        snprintf(path, sizeof(path), "%s/entries.pak", argv[2]);
+        if (capi_save(path, copy, size))
+        {
+            archive = depak_open(path);
+            if (archive != NULL)
+            {
+                capi_fail("an archive with a damaged entry count opened", path);
+                depak_close(archive);
+            }
+        }
+        remove(path);
+    }
+    else
+        capi_fail("the entry table offset is past the end of the file", argv[1]);
+
+    // A damaged chunk count in the first entry and damaged chunk data in the second fail those entries alone..
+    {
+        const uint32_t chunks = 0xFFFFFFFF;
+        uint32_t count2       = 0;
+        memcpy(copy, data, size);
+        memcpy(copy + first.Offset + 4, &chunks, 4);
+        memcpy(&count2, data + second.Offset + 4, 4);
+
+        const uint64_t chunkData = second.Offset + 8 + (uint64_t)count2 * 4;
+        for (uint64_t x = chunkData; x < chunkData + 64 && x < second.Offset + second.StoredSize; x++)
+            copy[x] = 0xFF;
+
+        snprintf(path, sizeof(path), "%s/chunks.pak", argv[2]);
+        if (capi_save(path, copy, size))
+        {
+            archive = depak_open(path);
+            if (archive == NULL)
+                capi_fail("an archive with damaged file data did not open", path);
+            else
+            {
+                capi_read_all(archive, path, &failed);
+                if (failed != 2)
+                {
+                    printf("FAIL: %llu entries failed to read; expected 2 (%s)\n", (unsigned long long)failed, path);
+                    g_Failures++;
+                }
+                depak_close(archive);
+            }
+        }
+        remove(path);
+    }
+
+    free(copy);
+    free(data);
+
+    printf("%llu entries, %llu failures\n", (unsigned long long)count, g_Failures);
+    return g_Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+# Kingdoms of Amalur: Re-Reckoning PAK Dumper
+# (c) 2020 atom0s [atom0s@live.com]
+#
+# Checks the depak Python module: whole and range reads of an intact archive, and depak.Error instead of crashes on
+# truncated and corrupted copies of it.
+#
+# Usage: python3 python_test.py <module dir> <file.pak> <work dir>
+import os
+import struct
+import sys
+
+sys.path.insert(0, sys.argv[1])
+import depak
+
+pak, work = sys.argv[2], sys.argv[3]
+failures = 0
+
+
+def fail(what):
+    global failures
+    print('FAIL: ' + what)
+    failures += 1
+
+
+# The intact archive reads every entry, by index and by name, whole and in ranges..
+with depak.Archive(pak) as archive:
+    count = len(archive)
+    for x in range(count):
+        info = archive.info(x)
+        data = bytes(archive[x])
+        if len(data) != info['size']:
+            fail('entry %d has size %d, expected %d' % (x, len(data), info['size']))
+        if info['name'] and bytes(archive[info['name']]) != data:
+            fail('entry %d reads differently by name' % x)
+        for offset, length in ((0, None), (1, None), (4095, 2), (4096, 4097), (len(data), None), (len(data) + 1, 1), (1, 2**64 - 1)):
+            expected = data[offset:] if length is None else data[offset:offset + length]
+            got = bytes(archive.read(x, offset) if length is None else archive.read(x, offset, length))
+            if got != expected:
+                fail('entry %d range (%d, %s) does not match the whole read' % (x, offset, length))
+    first, second = archive.info(0), archive.info(1)
+
+try:
+    archive[0]
+    fail('a closed archive was read')
+except ValueError:
+    pass
+
+with open(pak, 'rb') as f:
+    original = f.read()
+
+
+def damaged(name, data):
+    path = os.path.join(work, name)
+    with open(path, 'wb') as f:
+        f.write(data)
+    return path
+
+
+# Truncated copies lose the tables at the end of the file and must not open..
+for length in (0, 16, 32, len(original) // 2, len(original) - 1):
+    path = damaged('truncated-%d.pak' % length, original[:length])
+    try:
+        depak.Archive(path).close()
+        fail('a truncated archive opened: %d bytes' % length)
+    except depak.Error:
+        pass
+    os.remove(path)
+
+# A damaged chunk count in the first entry and damaged chunk data in the second fail those entries alone..
+copy = bytearray(original)
+copy[first['offset'] + 4:first['offset'] + 8] = struct.pack('<I', 0xFFFFFFFF)
+chunks = struct.unpack_from('<I', original, second['offset'] + 4)[0]
+start = second['offset'] + 8 + chunks * 4
+copy[start:start + 64] = b'\xff' * 64
+path = damaged('chunks.pak', bytes(copy))
+
+with depak.Archive(path) as archive:
+    failed = 0
+    for x in range(len(archive)):
+        try:
+            archive[x]
+            archive.read(x, 1)
+        except depak.Error:
+            failed += 1
+    if failed != 2:
+        fail('%d entries of the damaged archive failed to read; expected 2' % failed)
+os.remove(path)
+
+print('%d entries, %d failures' % (count, failures))
+sys.exit(1 if failures else 0)
@@ -0,0 +1,135 @@
+/**
+ * Kingdoms of Amalur: Re-Reckoning PAK Dumper
+ * (c) 2020 atom0s [atom0s@live.com]
+ *
+ * Checks pak_read_range and pak_read_range_buffer against slices of whole entries, at the offset and length edge
+ * cases: chunk boundaries, the end of the file, past the end of the file and lengths that would wrap offset + length.
+ *
+ * Usage: depak_range_test <file.pak>
+ */
+#include <Windows.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "pak.h"
+#include "pakreader.h"
+
+/**
+ * The count of failed checks.
+ */
+static uint64_t g_Failures = 0;
+
+/**
+ * Records a failed check.
+ *
+ * @param {std::size_t} index - The entry index.
+ * @param {uint64_t} offset - The range offset.
+ * @param {uint64_t} length - The range length.
+ * @param {char*} what - The check that failed.
+ */
+static void range_fail(const std::size_t index, const uint64_t offset, const uint64_t length, const char* what)
+{
+    printf_s(u8"FAIL: entry %zu, offset %llu, length %llu: %s\r\n", index, (unsigned long long)offset, (unsigned long long)length, what);
+    g_Failures++;
+}
+
+/**
+ * Checks one range of an entry against the slice of the whole entry.
+ *
+ * @param {pakreader_t*} reader - The reader.
+ * @param {std::size_t} index - The entry index.
+ * @param {std::vector<uint8_t>&} whole - The whole decoded entry.
+ * @param {uint64_t} offset - The range offset.
+ * @param {uint64_t} length - The range length.
+ */
+static void range_check(pakreader_t* reader, const std::size_t index, const std::vector<uint8_t>& whole, const uint64_t offset, const uint64_t length)
+{
+    // The expected range, clamped to the end of the file without computing offset + length..
+    const auto size  = (uint64_t)whole.size();
+    const auto begin = std::min(offset, size);
+    const auto end   = length >= size - begin ? size : begin + length;
+    const std::vector<uint8_t> expected(whole.begin() + (std::size_t)begin, whole.begin() + (std::size_t)end);
+
+    std::vector<uint8_t> data;
+    if (!pak_read_range(reader, index, offset, length, data))
+        range_fail(index, offset, length, "pak_read_range failed");
+    else if (data != expected)
+        range_fail(index, offset, length, "pak_read_range returned the wrong bytes");
+
+    // The buffer variant must fill an exactly sized buffer, and refuse one byte less while still reporting the size..
+    std::vector<uint8_t> buffer(expected.size() + 1, 0xCD);
+    uint64_t read = 0;
+    if (!pak_read_range_buffer(reader, index, offset, length, buffer.data(), expected.size(), read))
+        range_fail(index, offset, length, "pak_read_range_buffer failed");
+    else if (read != expected.size() || !std::equal(expected.begin(), expected.end(), buffer.begin()))
+        range_fail(index, offset, length, "pak_read_range_buffer returned the wrong bytes");
+    else if (buffer.back() != 0xCD)
+        range_fail(index, offset, length, "pak_read_range_buffer wrote past the range");
+
+    if (!expected.empty())
+    {
+        read = 0;
+        if (pak_read_range_buffer(reader, index, offset, length, buffer.data(), expected.size() - 1, read) || read != expected.size())
+            range_fail(index, offset, length, "pak_read_range_buffer accepted a buffer that is too small");
+    }
+}
+
+/**
+ * Application entry point.
+ *
+ * @param {int32_t} argc - The count of parameters passed to the application.
+ * @param {char*[]} argv - The array of parameters passed to the application.
+ * @return {int32_t} 0 when every check passed, 1 otherwise.
+ */
+int32_t main(int32_t argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        printf_s(u8"Usage: depak_range_test <file.pak>\r\n");
+        return 1;
+    }
+
+    const auto reader = pak_open(argv[1]);
+    if (reader == nullptr)
+    {
+        printf_s(u8"FAIL: Failed to open the PAK file: %s\r\n", argv[1]);
+        return 1;
+    }
+
+    const auto count = pak_entry_count(reader);
+    uint64_t ranges  = 0;
+    for (std::size_t x = 0; x < count; x++)
+    {
+        std::vector<uint8_t> whole;
+        if (!pak_read_entry(reader, x, whole))
+        {
+            range_fail(x, 0, UINT64_MAX, "pak_read_entry failed");
+            continue;
+        }
+
+        const auto size                     = (uint64_t)whole.size();
+        const std::vector<uint64_t> offsets = {0, 1, PAK_CHUNK_SIZE - 1, PAK_CHUNK_SIZE, PAK_CHUNK_SIZE + 1, size / 2, size - std::min<uint64_t>(size, 1), size, size + 1, UINT64_MAX - 1, UINT64_MAX};
+        const std::vector<uint64_t> lengths = {0, 1, PAK_CHUNK_SIZE - 1, PAK_CHUNK_SIZE, PAK_CHUNK_SIZE + 1, 2 * PAK_CHUNK_SIZE, size, size + 1, UINT64_MAX - 1, UINT64_MAX};
+        for (const auto offset : offsets)
+        {
+            for (const auto length : lengths)
+            {
+                range_check(reader, x, whole, offset, length);
+                ranges++;
+            }
+        }
+    }
+
+    // Indexes past the table fail instead of reading anything..
+    std::vector<uint8_t> data;
+    uint8_t byte  = 0;
+    uint64_t read = 0;
+    if (pak_read_range(reader, count, 0, 1, data) || pak_read_range_buffer(reader, count, 0, 1, &byte, 1, read))
+        range_fail(count, 0, 1, "a read past the entry table succeeded");
+
+    pak_close(reader);
+
+    printf_s(u8"%zu entries, %llu ranges, %llu failures\r\n", count, (unsigned long long)ranges, (unsigned long long)g_Failures);
+    return g_Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+# Kingdoms of Amalur: Re-Reckoning PAK Dumper
+# (c) 2020 atom0s [atom0s@live.com]
+#
+# Extracts a PAK file through the baseline path (one thread, stdio, the full dump) and through every other extraction
+# path, and byte-compares each dump against the baseline. (Run by CTest with cmake -P.)
+#
+# Variables: DEPAK, PAK, WORK_DIR.
+cmake_minimum_required(VERSION 3.16)
+
+if(NOT DEPAK OR NOT PAK OR NOT WORK_DIR)
+    message(FATAL_ERROR "DEPAK, PAK and WORK_DIR must be given.")
+endif()
+
+# Runs depak in a directory of its own; the dump is written to <dir>/dump. (Commands go first, so -q is passed by the caller.)
+function(roundtrip_run dir)
+    cmake_parse_arguments(RUN "" "INPUT" "" ${ARGN})
+    file(REMOVE_RECURSE ${dir})
+    file(MAKE_DIRECTORY ${dir})
+    if(RUN_INPUT)
+        execute_process(COMMAND ${DEPAK} ${RUN_UNPARSED_ARGUMENTS} WORKING_DIRECTORY ${dir} INPUT_FILE ${RUN_INPUT} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    else()
+        execute_process(COMMAND ${DEPAK} ${RUN_UNPARSED_ARGUMENTS} WORKING_DIRECTORY ${dir} RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    endif()
+    if(NOT result EQUAL 0 OR output MATCHES "Error")
+        list(JOIN RUN_UNPARSED_ARGUMENTS " " cmd)
+        message(FATAL_ERROR "depak ${cmd} failed (${result}):\n${output}")
+    endif()
+endfunction()
+
+# Compares the dump of a path against the baseline; SUBSET allows the path to dump only some of the files..
+function(roundtrip_compare name)
+    cmake_parse_arguments(CMP "SUBSET" "" "" ${ARGN})
+    file(GLOB_RECURSE files RELATIVE ${WORK_DIR}/${name}/dump ${WORK_DIR}/${name}/dump/*)
+    list(SORT files)
+    if(NOT CMP_SUBSET AND NOT files STREQUAL BASE_FILES)
+        message(FATAL_ERROR "[${name}] The dumped file names differ from the baseline.")
+    endif()
+    if(NOT files)
+        message(FATAL_ERROR "[${name}] No files were dumped.")
+    endif()
+
+    foreach(f ${files})
+        if(NOT EXISTS ${WORK_DIR}/base/dump/${f})
+            message(FATAL_ERROR "[${name}] ${f} is not in the baseline dump.")
+        endif()
+        file(SHA256 ${WORK_DIR}/${name}/dump/${f} got)
+        file(SHA256 ${WORK_DIR}/base/dump/${f} expected)
+        if(NOT got STREQUAL expected)
+            message(FATAL_ERROR "[${name}] ${f} differs from the baseline.")
+        endif()
+    endforeach()
+
+    list(LENGTH files count)
+    message(STATUS "[${name}] ${count} files match the baseline.")
+endfunction()
+
+# The baseline..
+roundtrip_run(${WORK_DIR}/base -q ${PAK})
+file(GLOB_RECURSE BASE_FILES RELATIVE ${WORK_DIR}/base/dump ${WORK_DIR}/base/dump/*)
+list(SORT BASE_FILES)
+
+# Every other extraction path..
+roundtrip_run(${WORK_DIR}/threads -q --threads 4 ${PAK})
+roundtrip_compare(threads)
+
+roundtrip_run(${WORK_DIR}/mmap -q --threads 2 --io mmap ${PAK})
+roundtrip_compare(mmap)
+
+roundtrip_run(${WORK_DIR}/budget -q --threads 2 --memory-budget 1 ${PAK})
+roundtrip_compare(budget)
+
+roundtrip_run(${WORK_DIR}/stream -q --spill-memory 1 --spill-dir . - INPUT ${PAK})
+roundtrip_compare(stream)
+file(GLOB spills ${WORK_DIR}/stream/*.spill ${WORK_DIR}/stream/*.tmp)
+if(spills)
+    message(FATAL_ERROR "[stream] The spill file was left behind: ${spills}")
+endif()
+
+roundtrip_run(${WORK_DIR}/filtered -q --min-size 8 ${PAK})
+roundtrip_compare(filtered SUBSET)
+
+roundtrip_run(${WORK_DIR}/recover recover -q --threads 2 ${PAK})
+roundtrip_compare(recover)